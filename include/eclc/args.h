@@ -0,0 +1,58 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_ARGS_H
+#define ECLC_ARGS_H
+
+#include "common.h"
+
+// Files per batch for a bare --unity
+#define ECLC_UNITY_DEFAULT 8
+
+typedef struct {
+    char** input_files;         // Sources, or FCEF files and folders with --inspect
+    int file_count;
+    bool c_mode;
+    bool cpp_mode;
+    bool folder_mode;
+    char* folder_path;
+    char* output_file;
+    int optimization_level;
+    bool debug_info;
+    bool show_help;
+    bool show_version;
+    int jobs;                   // -j N, 0 = one thread per CPU
+    bool icf;                   // --icf
+    bool gc_sections;           // --gc-sections
+    int unity;                  // --unity[=N], files per batch, 0 = off
+    bool no_cache;              // --no-cache
+    bool inspect;               // --inspect
+    bool run;                   // --run, interpret instead of writing FCEF
+    bool json;                  // --json, for --inspect
+    bool time_report;           // --time-report[=json]
+    bool time_report_json;
+    bool mem_report;            // --mem-report[=json]
+    bool mem_report_json;
+    const char* trace_path;     // --trace=<file>
+    const char* error;          // Why the command line was rejected, or NULL
+} CompilerConfig;
+
+CompilerConfig parse_arguments(int argc, char** argv);
+void free_config(CompilerConfig* config);
+void print_help(void);
+
+#endif // ECLC_ARGS_H
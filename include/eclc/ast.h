@@ -27,7 +27,8 @@ typedef enum {
     NODE_RETURN_STMT,
     NODE_INTEGER_LITERAL,
     NODE_BINARY_OP,
-    NODE_IDENTIFIER
+    NODE_IDENTIFIER,
+    NODE_CALL_EXPR
 } NodeType; // AST node types
 
 typedef struct ASTNode {
@@ -35,6 +36,7 @@ typedef struct ASTNode {
     Token token;
     struct ASTNode* left;
     struct ASTNode* right;
+    u64 hash;                   // NODE_FUNCTION_DEF: its tokens, positions left out
 } ASTNode;
 
 typedef struct {
@@ -58,5 +60,6 @@ Parser* parser_create(TokenStream* tokens, const char* filename);
 ASTNode* parser_parse(Parser* parser);
 void parser_destroy(Parser* parser);
 void ast_print(ASTNode* node, int indent);
+void ast_free(ASTNode* node);
 
 #endif // ECLC_AST_H
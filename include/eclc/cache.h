@@ -0,0 +1,76 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_CACHE_H
+#define ECLC_CACHE_H
+
+#include "common.h"
+#include "manifest.h"
+#include "fcef/eclc_fcef.h"
+
+// Default size limit of the build cache
+#define ECLC_CACHE_SIZE_DEFAULT (1024ull << 20)
+
+// Content-addressed store of compiled objects shared by every build on
+// the machine: $ECLC_CACHE_DIR, else $XDG_CACHE_HOME/eclc, else
+// ~/.cache/eclc. Entries are immutable files named by their key and are
+// evicted least recently used first once the cache outgrows
+// $ECLC_CACHE_SIZE (bytes, or with a K, M or G suffix). All functions are
+// thread-safe.
+typedef struct ObjectCache ObjectCache;
+
+typedef struct {
+    u64 hi;
+    u64 lo;
+} CacheKey;
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+    size_t stores;
+} CacheStats;
+
+// NULL when the cache is disabled (ECLC_CACHE_SIZE=0) or can't be created
+ObjectCache* cache_open(void);
+
+// Cache in `dir` holding up to `max_size` bytes, keyed for the compiler
+// whose identity is `compiler`; cache_open() passes a hash of the running
+// binary. NULL when `dir` can't be created.
+ObjectCache* cache_open_at(const char* dir, u64 max_size, u64 compiler);
+
+// Account for this process's stores and evict old entries if needed
+void cache_close(ObjectCache* cache);
+
+// Key of `source` compiled from `path` with `flags`. It covers the source,
+// the contents of every file it includes (in include order), the language
+// implied by the extension, `flags` and the compiler binary itself.
+CacheKey cache_key(ObjectCache* cache, const char* source, const char* path,
+                   const ManifestDep* deps, size_t dep_count, u64 flags);
+
+// Place the cached object at `dest` as a file of its own: a reflink where
+// the file system has them, else a copy. False on a miss.
+bool cache_fetch(ObjectCache* cache, const CacheKey* key, const char* dest);
+
+// Load the cached object, or NULL on a miss
+eclc_output_t* cache_load(ObjectCache* cache, const CacheKey* key);
+
+// Add an object; entries are written atomically
+bool cache_store(ObjectCache* cache, const CacheKey* key, const eclc_output_t* object);
+
+void cache_stats(const ObjectCache* cache, CacheStats* stats);
+
+#endif // ECLC_CACHE_H
@@ -0,0 +1,69 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_CODEGEN_H
+#define ECLC_CODEGEN_H
+
+#include "ast.h"
+#include "pool.h"
+#include "fcef/eclc_fcef.h"
+
+// Default load addresses (E-comOS user space)
+#define ECLC_TEXT_ADDR   0x400000
+#define ECLC_RODATA_ADDR 0x410000
+#define ECLC_DATA_ADDR   0x420000
+
+// Lower a parsed program to AArch64 code.
+// Every function gets a global symbol, calls become CALL26 relocations.
+// Calls to functions defined in the same program are resolved in place.
+eclc_output_t* codegen_generate(ASTNode* program);
+
+// A function of an earlier build of the same source
+typedef struct {
+    const char* name;
+    u64 hash;                   // ASTNode.hash it was generated from
+} FunctionHash;
+
+// Machine code of that earlier build
+typedef struct {
+    const eclc_output_t* object;
+    const FunctionHash* functions;
+    size_t count;
+    size_t reused;              // Out: functions copied rather than generated
+} CodegenCache;
+
+typedef struct {
+    ThreadPool* pool;           // Generate functions in parallel, NULL = serially
+    CodegenCache* cache;        // Earlier build to copy unchanged functions from
+    int level;                  // -O level; from 1 on small callees are inlined, calls
+                                // in tail position become branches and functions go
+                                // through the peephole pass; from 2 on calls with a
+                                // value known at compile time become that value
+} CodegenOptions;
+
+// codegen_generate() with options. Functions are generated independently,
+// on the pool when there are many, then laid out in source order, so the
+// output is byte-identical however they were scheduled. A function whose
+// name and hash match one in `cache` has its code and relocations copied
+// from the old object instead; its code only depends on its own tokens
+// (calls are relocated) and, once a callee is inlined, on the callee's,
+// which inline_calls() folds into the hash, as consteval_calls() does
+// with values, so that doesn't change the output either. Both rewrite
+// `program` before anything is generated.
+eclc_output_t* codegen_generate_with(ASTNode* program, const CodegenOptions* options);
+
+#endif // ECLC_CODEGEN_H
@@ -33,6 +33,7 @@ void* xmalloc(size_t size);
 void* xcalloc(size_t count, size_t size);
 void* xrealloc(void* ptr, size_t size);
 void xfree(void* ptr);
+char* xstrdup(const char* str);
 
 // Error
 #define PANIC(...) do { \
@@ -0,0 +1,44 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_CONSTEVAL_H
+#define ECLC_CONSTEVAL_H
+
+#include "ast.h"
+
+// Functions take no arguments and have no side effects, so running one
+// at compile time gives what it returns on every run: the integer its
+// chain of calls ends in. Calls that never return, or that leave the
+// program, have no value. Running a program is bounded by these limits.
+
+// Calls followed in one program before evaluation gives up, so that
+// compile time stays bounded whatever the program does
+#define CONSTEVAL_FUEL      (1u << 22)
+// Calls in flight at once; deeper chains are left to run at run time
+#define CONSTEVAL_MAX_DEPTH (1u << 16)
+
+// Value of calling `name`, as atoi() reads the literal it returns;
+// false when it can't be known before the program runs
+bool consteval_function(const ASTNode* program, const char* name, int* value);
+
+// Replace every call with a known value by that value, from -O `level`
+// 2 on. A rewritten function's hash also covers the value, so code
+// reused by hash always returns the value it was compiled with.
+// Returns how many calls were replaced.
+size_t consteval_calls(ASTNode* program, int level);
+
+#endif // ECLC_CONSTEVAL_H
@@ -0,0 +1,47 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_ERROR_H
+#define ECLC_ERROR_H
+
+#include "common.h"
+#include <stdio.h>
+
+// Diagnostics printed while a buffer is captured on the calling thread,
+// so parallel compiles can print each file's messages in input order
+typedef struct {
+    char* text;
+    size_t size;
+    size_t capacity;
+} ErrorBuffer;
+
+// Print "Error: <message>" to stderr, or into the active capture buffer
+void error_report(const char* format, ...)
+    __attribute__((format(printf, 1, 2)));
+
+// Errors reported on the calling thread so far
+int error_count(void);
+
+// Redirect this thread's diagnostics into `buffer` until error_capture_end
+void error_capture_begin(ErrorBuffer* buffer);
+void error_capture_end(void);
+
+// Write captured diagnostics to `out` and empty the buffer
+void error_buffer_flush(ErrorBuffer* buffer, FILE* out);
+void error_buffer_free(ErrorBuffer* buffer);
+
+#endif // ECLC_ERROR_H
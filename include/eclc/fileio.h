@@ -0,0 +1,59 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_FILEIO_H
+#define ECLC_FILEIO_H
+
+#include "common.h"
+
+// Reads and writes of many small files at once. On Linux each thread gets
+// an io_uring with registered buffers, so a batch of opens, reads or
+// writes and closes costs a couple of system calls instead of several per
+// file. Where io_uring is missing or refused, or ECLC_IO_URING=0 is set,
+// the same calls fall back to plain open/read/write/close.
+
+// Files per round trip through the ring; larger arrays are split
+#define FILEIO_BATCH 32
+
+// Registered buffer per file of a batch. Larger files are read with plain
+// syscalls and written straight from the caller's data.
+#define FILEIO_SLOT (64 * 1024)
+
+typedef struct {
+    const char* path;
+    char* data;                 // Contents plus a NUL, NULL on failure
+    size_t size;
+    int error;                  // errno of the failure
+} FileRead;
+
+typedef struct {
+    const char* path;
+    const void* data;
+    size_t size;
+    int error;                  // 0 once the file is in place
+} FileWrite;
+
+void fileio_read(FileRead* files, size_t count);
+
+// Each file is written under a temporary name and renamed over `path`,
+// so readers never see half of it
+void fileio_write(FileWrite* files, size_t count);
+
+// Whether the calling thread's batches go through io_uring
+bool fileio_uring(void);
+
+#endif // ECLC_FILEIO_H
@@ -0,0 +1,29 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_HASH_H
+#define ECLC_HASH_H
+
+#include "common.h"
+
+// Fast 64-bit content hash (not cryptographic)
+u64 eclc_hash64(const void* data, size_t len, u64 seed);
+
+// Fold another value into a running hash
+u64 eclc_hash_combine(u64 hash, u64 value);
+
+#endif // ECLC_HASH_H
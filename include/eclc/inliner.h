@@ -0,0 +1,46 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_INLINER_H
+#define ECLC_INLINER_H
+
+#include "ast.h"
+
+// What inlining may cost at one -O level. Every inlined call saves the
+// branch into the callee and its return; it costs the instructions the
+// caller grows by, since the callee keeps its own copy for other callers.
+typedef struct {
+    size_t site_growth;         // Instructions one call site may add
+    size_t unit_percent;        // Instructions the whole program may add, in percent
+} InlineLimits;
+
+// Growth every program is allowed, so that small ones aren't held back
+#define INLINE_UNIT_SLACK 16
+
+// Limits at `level`, also used by the linker to inline across objects
+const InlineLimits* inline_limits(int level);
+
+// Replace calls to small functions of the same program with the callee's
+// body, as far as the cost model of -O `level` allows (nothing at 0).
+// Callees are done before their callers, so chains of helpers collapse
+// from the bottom. Functions on a call cycle are never inlined or
+// inlined into. A rewritten function's hash also covers its callee, so
+// code reused by hash always matches the callee it was inlined from.
+// Returns how many calls were replaced.
+size_t inline_calls(ASTNode* program, int level);
+
+#endif // ECLC_INLINER_H
@@ -0,0 +1,32 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_INSPECT_H
+#define ECLC_INSPECT_H
+
+#include "common.h"
+
+typedef struct {
+    int threads;                // Workers (0 = one per CPU)
+    bool json;                  // JSON lines instead of a table
+} InspectOptions;
+
+// Validate FCEF files and print their layout. Directories are searched
+// recursively for *.fcef. Returns 0 when every file is valid.
+int eclc_inspect(const char* const* paths, int count, const InspectOptions* options);
+
+#endif // ECLC_INSPECT_H
@@ -0,0 +1,38 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_INTERN_H
+#define ECLC_INTERN_H
+
+#include "common.h"
+
+// Unique, immutable copy of a string. Equal strings get the same pointer,
+// so interned names compare with ==. Strings live until the process exits,
+// which lets the compile server keep them across requests. Thread-safe.
+const char* intern(const char* str, size_t len);
+const char* intern_cstr(const char* str);
+
+typedef struct {
+    size_t strings;             // Distinct strings
+    size_t bytes;               // Arena bytes in use
+    u64 lookups;
+    u64 hits;                   // Lookups that found an existing string
+} InternStats;
+
+void intern_stats(InternStats* stats);
+
+#endif // ECLC_INTERN_H
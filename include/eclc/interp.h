@@ -0,0 +1,88 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_INTERP_H
+#define ECLC_INTERP_H
+
+#include "ast.h"
+
+// Frames deeper than this end the program with an error instead of
+// exhausting memory (unbounded recursion)
+#define INTERP_MAX_DEPTH (1u << 20)
+
+// Every function of one or more translation units, lowered to bytecode
+// for a register machine and linked by name, for `eclc --run`
+typedef struct InterpProgram InterpProgram;
+
+// Opcodes, in the order of the dispatch table in interp_run()
+typedef enum {
+    OP_LOADI,                   // r[a] = imm
+    OP_CALL,                    // r[a] = call imm (function index, its entry once linked)
+    OP_RET,                     // return r[a]
+    OP_RETI,                    // return imm, the fused form of `return <int>;`
+    OP_COUNT
+} Opcode;
+
+// Operands are a register, a register window size and an immediate
+typedef struct {
+    uint8_t op;
+    uint8_t a;
+    uint16_t b;                 // OP_CALL: registers of the caller, where the callee's start
+    int32_t imm;
+} Insn;
+
+typedef struct {
+    const char* name;           // Interned
+    const char* file;           // Where it is defined, or first called while undefined
+    uint32_t entry;             // First instruction
+    uint32_t size;              // Instructions
+    uint16_t registers;
+    bool defined;
+} InterpFunction;
+
+typedef struct {
+    u64 instructions;           // Bytecode instructions executed
+    u64 calls;
+    u32 max_depth;              // Deepest call chain, main included
+} InterpStats;
+
+InterpProgram* interp_create(void);
+void interp_free(InterpProgram* program);
+
+// Lower the functions of a parsed unit. Reports a function that an
+// earlier unit already defined and returns false.
+bool interp_add_unit(InterpProgram* program, const ASTNode* unit, const char* filename);
+
+// Resolve calls once every unit is added. Reports calls to functions no
+// unit defines and returns false.
+bool interp_link(InterpProgram* program);
+
+// Call `entry` with a threaded dispatch loop and store what it returns in
+// `result`. Returns false, after reporting it, if there is no such
+// function or the call chain got deeper than INTERP_MAX_DEPTH. `stats`
+// may be NULL.
+bool interp_run(const InterpProgram* program, const char* entry, int* result, InterpStats* stats);
+
+// The linked bytecode, for the JIT and benchmarks. Every function is a
+// contiguous run of instructions ending in a return.
+const Insn* interp_code(const InterpProgram* program, size_t* size);
+const InterpFunction* interp_functions(const InterpProgram* program, size_t* count);
+
+// Index of the function defined as `name`, or -1
+long interp_find(const InterpProgram* program, const char* name);
+
+#endif // ECLC_INTERP_H
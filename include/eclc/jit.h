@@ -0,0 +1,48 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_JIT_H
+#define ECLC_JIT_H
+
+#include "interp.h"
+
+// Stack of a JIT run. Like INTERP_MAX_DEPTH it turns unbounded recursion
+// into an error, at about the same depth.
+#define JIT_STACK_SIZE ((size_t)INTERP_MAX_DEPTH * 16)
+
+// x86-64 machine code of a linked bytecode program, in memory that is
+// executable but never writable
+typedef struct JitCode JitCode;
+
+// Whether this host can run what jit_compile() produces (x86-64)
+bool jit_available(void);
+
+// Translate every function of a linked program, which must outlive the
+// code. NULL when the host isn't x86-64 or no executable memory could be
+// mapped; --run then interprets.
+JitCode* jit_compile(const InterpProgram* program);
+void jit_free(JitCode* code);
+
+// Bytes of machine code, stubs included
+size_t jit_code_size(const JitCode* code);
+
+// Call `entry` on the code's own stack and store what it returns in
+// `result`. Returns false, after reporting it, if there is no such
+// function or the stack ran out. One run at a time per JitCode.
+bool jit_run(JitCode* code, const char* entry, int* result);
+
+#endif // ECLC_JIT_H
@@ -0,0 +1,64 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_LINK_H
+#define ECLC_LINK_H
+
+#include "common.h"
+#include "pool.h"
+#include "fcef/eclc_fcef.h"
+
+typedef struct {
+    const char* name;           // Source name, used in diagnostics
+    const eclc_output_t* object;
+} LinkInput;
+
+typedef struct {
+    ThreadPool* pool;           // Shared pool, or NULL to create one
+    int threads;                // Workers when pool is NULL (0 = one per CPU)
+    const char* entry;          // Entry symbol, "main" when NULL
+    bool icf;                   // Fold functions with identical code
+    bool gc_sections;           // Drop code and data unreachable from the entry
+    int level;                  // -O level; from 1 on small functions of one object
+                                // are inlined into branches from another
+} LinkOptions;
+
+typedef struct {
+    size_t objects;
+    size_t symbols;             // Global definitions in the output
+    size_t relocations;         // Relocations applied
+    size_t rodata_in;           // Read-only data before deduplication
+    size_t rodata_out;
+    size_t text_in;             // Code before folding and collection
+    size_t text_out;
+    size_t icf_functions;       // Functions folded into an identical one
+    size_t icf_bytes;
+    size_t gc_atoms;            // Functions and objects removed as unreachable
+    size_t gc_bytes;
+    size_t inlined_calls;       // Branches replaced by the function they reached
+    size_t inlined_bytes;       // Code that added
+} LinkStats;
+
+// Merge relocatable FCEF objects into one executable.
+// Returns NULL after printing diagnostics on undefined or duplicate symbols.
+// Identical code folding only merges functions whose address is never
+// taken, so distinct functions still compare unequal. Inlining copies a
+// callee into each caller, so it keeps every function's address too.
+eclc_output_t* eclc_link(const LinkInput* inputs, size_t count,
+                         const LinkOptions* options, LinkStats* stats);
+
+#endif // ECLC_LINK_H
@@ -0,0 +1,112 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_MANIFEST_H
+#define ECLC_MANIFEST_H
+
+#include "common.h"
+
+// Bump when codegen output changes so old cached objects are rebuilt
+#define ECLC_OBJECT_VERSION 5
+
+// What a file looked like when it was last built
+typedef struct {
+    int64_t mtime_ns;
+    uint64_t size;
+    u64 hash;                   // Content hash
+} FileStamp;
+
+typedef struct {
+    char* path;                 // As resolved from the including file
+    FileStamp stamp;
+} ManifestDep;
+
+// A function the cached object was generated from
+typedef struct {
+    char* name;
+    u64 hash;                   // Of its tokens, see ASTNode.hash
+} ManifestFunction;
+
+typedef struct {
+    char* name;                 // Input path relative to the folder
+    FileStamp stamp;
+    char* object;               // Cached object, relative to the manifest dir
+    ManifestDep* deps;          // Files pulled in with #include "..."
+    size_t dep_count;
+    ManifestFunction* functions;    // Empty when the object came from elsewhere
+    size_t function_count;
+} ManifestEntry;
+
+// Build state of a folder, kept in <output dir>/.eclc/<output name>/manifest
+typedef struct {
+    char* dir;                  // <output dir>/.eclc/<output name>
+    u64 flags;                  // Options the objects were compiled with
+    u64 link_flags;             // Options the output was linked with
+    FileStamp output;           // Linked executable, size 0 when missing
+    ManifestEntry* entries;     // Sorted by name
+    size_t count;
+    size_t capacity;
+} Manifest;
+
+// Load the manifest of `output_file`, stored next to it. A missing or
+// unreadable manifest, or one written with different `flags`, loads empty.
+Manifest* manifest_load(const char* output_file, u64 flags);
+
+// Empty manifest for the same directory and flags
+Manifest* manifest_create(const Manifest* previous);
+
+// Entry for an input name, or NULL
+const ManifestEntry* manifest_find(const Manifest* manifest, const char* name);
+
+// Append an entry; entries must be added in name order. Takes ownership.
+void manifest_add(Manifest* manifest, ManifestEntry* entry);
+
+// Create the manifest and object directories
+bool manifest_prepare_dirs(const Manifest* manifest);
+
+// Write atomically (temporary file, then rename)
+bool manifest_save(const Manifest* manifest);
+void manifest_free(Manifest* manifest);
+
+// Delete cached objects of inputs that `next` no longer lists
+void manifest_prune(const Manifest* previous, const Manifest* next);
+void manifest_entry_free(ManifestEntry* entry);
+
+// Path of the cached object for an input name, to be freed by the caller
+char* manifest_object_path(const Manifest* manifest, const char* object);
+char* manifest_object_name(const char* name);
+
+// stat() a file into `stamp` (hash left 0)
+bool file_stamp_stat(const char* path, FileStamp* stamp);
+
+// Whether `path` still matches `recorded`. Only stat() runs when mtime and
+// size match; otherwise the contents are hashed. `current` receives the
+// up-to-date stamp.
+bool file_stamp_fresh(const char* path, const FileStamp* recorded, FileStamp* current);
+
+// Whether an input and everything it includes are unchanged since `entry`
+// was recorded; `updated` (may be NULL) receives the refreshed entry
+bool manifest_entry_fresh(const ManifestEntry* entry, const char* path,
+                          ManifestEntry* updated);
+
+// Find #include "..." lines in `source` and stamp the files they name
+size_t manifest_scan_includes(const char* source, const char* source_path,
+                              ManifestDep** deps);
+void manifest_deps_free(ManifestDep* deps, size_t count);
+void manifest_functions_free(ManifestFunction* functions, size_t count);
+
+#endif // ECLC_MANIFEST_H
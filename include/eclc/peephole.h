@@ -0,0 +1,39 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_PEEPHOLE_H
+#define ECLC_PEEPHOLE_H
+
+#include "common.h"
+#include <stdio.h>
+
+// Longest instruction sequence a pattern looks at
+#define PEEPHOLE_WINDOW 3
+
+// Rewrite the AArch64 instructions of one function in place and return
+// how many are left. Patterns only ever shorten the code, and each word
+// is looked at a bounded number of times, so the pass is linear. Words
+// with `pinned` set (relocation sites) are never changed or removed;
+// `pinned` may be NULL. For every surviving input word i, `where[i]` is
+// set to its new index. Safe to call from several threads at once.
+size_t peephole_optimize(uint32_t* insns, size_t count, const uint8_t* pinned, uint32_t* where);
+
+// Hits of every pattern since the last reset, summed over threads
+void peephole_reset(void);
+void peephole_report(FILE* out, bool json);
+
+#endif // ECLC_PEEPHOLE_H
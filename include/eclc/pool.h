@@ -0,0 +1,48 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_POOL_H
+#define ECLC_POOL_H
+
+#include "common.h"
+
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*PoolJob)(void* arg);
+typedef void (*PoolForBody)(void* ctx, size_t index);
+
+// Number of online CPUs, at least 1
+int pool_cpu_count(void);
+
+// Create a pool with `threads` workers (0 = one per CPU)
+ThreadPool* pool_create(int threads);
+void pool_destroy(ThreadPool* pool);
+int pool_size(const ThreadPool* pool);
+
+// Queue a job; it runs on one of the workers. Jobs submitted from a
+// worker go to that worker's own deque and may be stolen by the others.
+void pool_submit(ThreadPool* pool, PoolJob job, void* arg);
+
+// Block until every submitted job has finished. Not for use from a worker.
+void pool_wait(ThreadPool* pool);
+
+// Run body(ctx, i) for i in [0, count) across the pool and wait for it.
+// A NULL pool runs the loop on the calling thread. The caller takes part,
+// and loops may nest: a worker waiting on an inner loop runs other jobs.
+void pool_for(ThreadPool* pool, size_t count, PoolForBody body, void* ctx);
+
+#endif // ECLC_POOL_H
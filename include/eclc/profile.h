@@ -0,0 +1,97 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_PROFILE_H
+#define ECLC_PROFILE_H
+
+#include "common.h"
+#include <stdio.h>
+
+// Compiler stages that time (and later memory) is charged to
+typedef enum {
+    PHASE_OTHER,                // Driver work outside the stages below
+    PHASE_SCAN,                 // Finding sources and checking the manifest
+    PHASE_READ,                 // Reading source files
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_CODEGEN,
+    PHASE_FCEF,                 // Writing and loading FCEF files
+    PHASE_CACHE,                // Build cache lookups and stores
+    PHASE_LINK,
+    PHASE_COUNT
+} Phase;
+
+#define PROFILE_TIME    1u      // --time-report
+#define PROFILE_MEM     2u      // --mem-report
+#define PROFILE_TRACE   4u      // --trace=<file>
+
+// Allocation size classes: <= 16 bytes, <= 32, ... and one for the rest
+#define MEM_SIZE_CLASSES 16
+
+// PROFILE_* bits; set before any compile starts. When it is 0 a phase
+// scope costs one load and a branch.
+extern unsigned profile_flags;
+
+typedef struct {
+    Phase phase;
+    Phase previous;
+    u64 start_ns;
+} PhaseScope;
+
+void phase_enter_slow(PhaseScope* scope, Phase phase);
+void phase_leave_slow(PhaseScope* scope);
+
+// Charge the time until phase_leave to `phase`, on the calling thread.
+// Scopes nest; the inner phase's time is not also charged to the outer.
+static inline void phase_enter(PhaseScope* scope, Phase phase) {
+    if (profile_flags) phase_enter_slow(scope, phase);
+}
+
+static inline void phase_leave(PhaseScope* scope) {
+    if (profile_flags) phase_leave_slow(scope);
+}
+
+const char* phase_name(Phase phase);
+
+// Clear all counters and start the wall clock
+void profile_reset(void);
+
+// Totals summed over every thread, as a table or one JSON object
+void profile_report_time(FILE* out, bool json);
+
+// Called by the xmalloc family when PROFILE_MEM is set. `usable` is the
+// block's real size (0 where the C library can't tell), and it is what
+// live and peak bytes are counted in.
+void profile_note_alloc(size_t requested, size_t usable);
+void profile_note_realloc(size_t old_usable, size_t requested, size_t usable);
+void profile_note_free(size_t usable);
+
+// Allocations per phase, peak live bytes and the size-class histogram.
+// Live bytes start from 0 at profile_reset.
+void profile_report_mem(FILE* out, bool json);
+
+// With PROFILE_TRACE every phase scope becomes a span in a per-thread
+// buffer, tagged with the file the thread is working on. Set the file
+// when a job starts and its size once it is known.
+void profile_trace_file(const char* name);
+void profile_trace_size(u64 size);
+
+// Write the spans of every thread as Chrome trace-event JSON, viewable
+// in chrome://tracing or Perfetto
+bool profile_write_trace(const char* path);
+
+#endif // ECLC_PROFILE_H
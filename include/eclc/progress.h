@@ -0,0 +1,49 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_PROGRESS_H
+#define ECLC_PROGRESS_H
+
+#include "common.h"
+#include <stdio.h>
+
+// Build progress drawn by its own thread. Workers only bump counters, so
+// they never wait on the terminal. On a TTY one status line is redrawn at
+// most 20 times a second; otherwise a plain line is printed at most once
+// a second. Every function accepts NULL and then does nothing.
+typedef struct Progress Progress;
+
+// Start reporting `total` items (more may be added) under `verb`
+Progress* progress_start(FILE* out, const char* verb, int total);
+
+void progress_add_total(Progress* progress, int count);
+
+// One item finished. `name` must outlive the Progress.
+void progress_done(Progress* progress, const char* name, bool ok);
+
+// One item finished without any work, e.g. a fresh file
+void progress_skip(Progress* progress);
+
+// Clear the status line and hold off redraws so the caller can print
+void progress_pause(Progress* progress);
+void progress_resume(Progress* progress);
+
+// Draw the final state, end the line and free the Progress. Nothing is
+// left on screen if no item did any work.
+void progress_finish(Progress* progress);
+
+#endif // ECLC_PROGRESS_H
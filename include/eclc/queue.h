@@ -0,0 +1,50 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_QUEUE_H
+#define ECLC_QUEUE_H
+
+#include "common.h"
+
+// Bounded multi-producer, multi-consumer queue of pointers. Pushes and
+// pops claim a ring slot with one compare-and-swap; the lock is only taken
+// by a thread that has to sleep because the queue is full or empty, and
+// by whoever then has to wake it.
+typedef struct BoundedQueue BoundedQueue;
+
+// `capacity` is rounded up to a power of two
+BoundedQueue* queue_create(size_t capacity);
+void queue_destroy(BoundedQueue* queue);
+
+// Non-blocking; false when full or empty
+bool queue_try_push(BoundedQueue* queue, void* item);
+bool queue_try_pop(BoundedQueue* queue, void** item);
+
+// Wait while the queue is full
+void queue_push(BoundedQueue* queue, void* item);
+
+// Wait while the queue is empty. False once it is closed and drained.
+bool queue_pop(BoundedQueue* queue, void** item);
+
+// Wait for one item like queue_pop(), then take up to `max` in all of
+// those already queued. 0 once the queue is closed and drained.
+size_t queue_pop_many(BoundedQueue* queue, void** items, size_t max);
+
+// No more pushes; consumers drain what is left and then stop
+void queue_close(BoundedQueue* queue);
+
+#endif // ECLC_QUEUE_H
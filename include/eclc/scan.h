@@ -0,0 +1,49 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_SCAN_H
+#define ECLC_SCAN_H
+
+#include "common.h"
+
+// Per-directory ignore file, gitignore-style patterns
+#define ECLC_IGNORE_FILE ".eclcignore"
+
+// Called for each source file as soon as its directory has been read, on
+// the scanning thread. `name` is relative to the root, `path` includes it.
+typedef void (*ScanCallback)(void* ctx, const char* name, const char* path);
+
+typedef struct {
+    size_t files;               // Source files reported
+    size_t dirs;                // Directories read
+    size_t ignored;             // Entries dropped by ignore rules
+} ScanStats;
+
+// Whether a file name has a C/C++ source extension
+bool scan_is_source(const char* name);
+
+// Walk `root` and report every C/C++ source file below it. Hidden entries
+// are skipped, as is anything matched by an .eclcignore in its directory
+// or one above it. Each directory is opened relative to its parent and
+// read once. Returns false if `root` can't be opened.
+bool scan_project(const char* root, ScanCallback found, void* ctx, ScanStats* stats);
+
+// Same walk, reporting the files whose name `match` accepts
+bool scan_files(const char* root, bool (*match)(const char* name),
+                ScanCallback found, void* ctx, ScanStats* stats);
+
+#endif // ECLC_SCAN_H
@@ -0,0 +1,44 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ECLC_SERVER_H
+#define ECLC_SERVER_H
+
+#include "common.h"
+
+// Runs one forwarded command line. While it runs, stdout, stderr and the
+// working directory are the client's.
+typedef int (*ServerCommand)(int argc, char* argv[]);
+
+// Socket to use when none is given: $ECLC_SOCKET, else
+// $XDG_RUNTIME_DIR/eclc.sock, else /tmp/eclc-<uid>/eclc.sock, with the
+// directory created mode 0700. NULL when that directory exists but isn't
+// private to us. Caller frees.
+char* server_socket_path(void);
+
+// Listen on `socket_path` and run requests one at a time, keeping the
+// process (and everything it has cached) alive between them, until
+// SIGINT or SIGTERM. A command that calls exit() takes the server down.
+// Connections from other users are refused.
+int eclc_server(const char* socket_path, ServerCommand command);
+
+// Forward a command line to the server, which writes straight to our
+// stdout and stderr. Returns its exit status, or -1 when no server of
+// our own user is listening (nothing has run then).
+int eclc_client(const char* socket_path, int argc, char* argv[]);
+
+#endif // ECLC_SERVER_H
@@ -73,7 +73,7 @@ typedef enum {
 
 typedef struct {
     TokenType type;
-    char* value;        // token's string
+    const char* value;  // token's string, interned
     int line;          
     int column;        
 } Token;
@@ -27,6 +27,108 @@
 extern "C" {
 #endif
 
+// ==================== Link tables ====================
+// The link section is little-endian whatever the host: eclc_to_fcef and
+// eclc_from_fcef convert every field, so the tables in eclc_output_t are
+// always in host order. (The layout words in the header are big-endian.)
+
+// Sections a symbol or relocation can refer to
+typedef enum {
+    FCEF_SEC_UNDEF = 0,
+    FCEF_SEC_TEXT,
+    FCEF_SEC_RODATA,
+    FCEF_SEC_DATA,
+    FCEF_SEC_BSS
+} fcef_section_t;
+
+typedef enum {
+    FCEF_BIND_LOCAL = 0,
+    FCEF_BIND_GLOBAL,
+    FCEF_BIND_WEAK
+} fcef_bind_t;
+
+typedef enum {
+    FCEF_SYM_NOTYPE = 0,
+    FCEF_SYM_FUNC,
+    FCEF_SYM_OBJECT
+} fcef_symtype_t;
+
+typedef enum {
+    FCEF_RELOC_NONE = 0,
+    FCEF_RELOC_CALL26,      // bl/b: imm26, PC-relative, word scaled
+    FCEF_RELOC_ADR21,       // adr: imm21, PC-relative
+    FCEF_RELOC_ABS32,
+    FCEF_RELOC_ABS64
+} fcef_reloc_type_t;
+
+// 16 bytes in the file
+typedef struct {
+    uint32_t name;          // offset into string table
+    uint32_t value;         // offset inside section
+    uint32_t size;
+    uint8_t section;        // fcef_section_t
+    uint8_t bind;           // fcef_bind_t
+    uint8_t type;           // fcef_symtype_t
+    uint8_t pad;
+} fcef_symbol_t;
+
+// 16 bytes in the file
+typedef struct {
+    uint32_t offset;        // offset inside section
+    uint32_t symbol;        // symbol index
+    int32_t addend;
+    uint8_t section;        // section being patched
+    uint8_t type;           // fcef_reloc_type_t
+    uint16_t pad;
+} fcef_reloc_t;
+
+// GNU-style hash table header, followed by
+//   uint64_t bloom[bloom_size];
+//   uint32_t buckets[nbuckets];
+//   uint32_t chain[symbol_count - symoffset];
+// Symbols from symoffset on are defined, non-local and sorted by bucket.
+typedef struct {
+    uint32_t nbuckets;
+    uint32_t symoffset;
+    uint32_t bloom_size;    // in 64-bit words, power of two
+    uint32_t bloom_shift;
+} fcef_gnu_hash_t;
+
+// Link section header, placed right after the data section
+#define FCEF_LINK_MAGIC 0x4B4E4C46u  // "FLNK"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t symbol_count;
+    uint32_t reloc_count;
+    uint32_t hash_size;     // bytes
+    uint32_t strtab_size;   // bytes
+    uint32_t pad;
+} fcef_link_header_t;
+
+// Layout stored big-endian in the header's reserved bytes
+typedef struct {
+    uint32_t entry_point;
+    uint32_t text_addr;
+    uint32_t data_addr;
+    uint32_t code_size;
+    uint32_t rodata_size;
+    uint32_t data_size;
+    uint32_t bss_size;
+    uint32_t link_offset;   // 0 when there are no link tables
+} fcef_layout_t;
+
+typedef enum {
+    ECLC_FCEF_OK = 0,
+    ECLC_FCEF_TRUNCATED,    // smaller than a header
+    ECLC_FCEF_BAD_MAGIC,
+    ECLC_FCEF_BAD_VERSION,
+    ECLC_FCEF_BAD_SIZE,     // header file_size differs from the real size
+    ECLC_FCEF_BAD_LAYOUT,   // sections run past the end of the file
+    ECLC_FCEF_BAD_LINK,     // link section out of bounds or its tables inconsistent
+    ECLC_FCEF_BAD_CRC
+} eclc_fcef_status_t;
+
 // ==================== ECLC maked data typedef ====================
 typedef struct {
     uint8_t *code;         
@@ -41,6 +143,17 @@ typedef struct {
     uint32_t text_addr;     
     uint32_t data_addr;     
     uint32_t rodata_addr;   
+    fcef_symbol_t *symbols;
+    size_t symbol_count;
+    fcef_reloc_t *relocs;
+    size_t reloc_count;
+    char *strtab;
+    size_t strtab_size;
+    uint8_t *hash;          // fcef_gnu_hash_t blob, built by eclc_finalize_symbols
+    size_t hash_size;
+    size_t symbol_capacity; // allocation sizes of the tables above
+    size_t reloc_capacity;
+    size_t strtab_capacity;
 } eclc_output_t;
 
 
@@ -50,7 +163,7 @@ typedef struct {
 // From ECLC ouput create FCEF file
 void *eclc_to_fcef(const eclc_output_t *output, size_t *out_size);
 
-// save ECLC output FCEF file
+// save ECLC output FCEF file (written to a temporary file, then renamed)
 bool eclc_save_fcef(const eclc_output_t *output, const char *filename);
 
 // load ECLC compiltion FCEF file
@@ -62,6 +175,60 @@ void eclc_free_output(eclc_output_t *output);
 // Output ECLC information for debugging
 void eclc_print_output(const eclc_output_t *output);
 
+// Parse an FCEF image held in memory
+eclc_output_t *eclc_from_fcef(const void *data, size_t size);
+
+// Decode the layout from a header
+void eclc_fcef_layout(const fcef_header_t *header, fcef_layout_t *layout);
+
+// Decode the link section header of an image into host order.
+// False when the image has no link section or it is out of bounds.
+bool eclc_fcef_link_header(const void *data, size_t size, const fcef_layout_t *layout,
+                           fcef_link_header_t *link);
+
+// Check magic, version, size, section bounds, link tables and CRC of an image in memory.
+// `layout` (may be NULL) is filled as soon as the header is readable.
+eclc_fcef_status_t eclc_fcef_verify(const void *data, size_t size, fcef_layout_t *layout);
+
+// Short description of a verification result
+const char *eclc_fcef_status_string(eclc_fcef_status_t status);
+
+// CRC-32 (IEEE 802.3) continuing from `crc`, start with 0
+uint32_t eclc_crc32(uint32_t crc, const void *data, size_t size);
+
+// CRC-32 of an image with the header's crc32 field taken as zero
+uint32_t eclc_fcef_crc32(const void *data, size_t size);
+
+// Add a symbol, returns its index
+uint32_t eclc_add_symbol(eclc_output_t *output, const char *name,
+                         fcef_section_t section, uint32_t value, uint32_t size,
+                         fcef_bind_t bind, fcef_symtype_t type);
+
+// Add a relocation against symbol index `symbol`
+void eclc_add_reloc(eclc_output_t *output, fcef_section_t section,
+                    uint32_t offset, uint32_t symbol,
+                    fcef_reloc_type_t type, int32_t addend);
+
+// Symbol name from string table
+const char *eclc_symbol_name(const eclc_output_t *output, const fcef_symbol_t *sym);
+
+// Sort symbols for hashing, remap relocations and build the hash table
+void eclc_finalize_symbols(eclc_output_t *output);
+
+// Look up a defined global symbol, returns its index or -1
+long eclc_lookup_symbol(const eclc_output_t *output, const char *name);
+
+// Patch the instruction or word at `loc` (placed at address `place`) to reach `target`
+bool eclc_apply_reloc(uint8_t *loc, uint32_t place, uint64_t target,
+                      fcef_reloc_type_t type);
+
+// GNU hash of a symbol name
+uint32_t fcef_gnu_hash(const char *name);
+
+// Look up `name` through a serialized hash table (works on mmapped files)
+long fcef_hash_lookup(const void *hash, const fcef_symbol_t *symbols,
+                      size_t symbol_count, const char *strtab, const char *name);
+
 #ifdef __cplusplus
 }
 #endif
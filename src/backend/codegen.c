@@ -0,0 +1,466 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/codegen.h"
+#include "eclc/common.h"
+#include "eclc/consteval.h"
+#include "eclc/error.h"
+#include "eclc/inliner.h"
+#include "eclc/peephole.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// AArch64 encodings
+#define A64_RET          0xD65F03C0u  // ret
+#define A64_STP_FP_LR    0xA9BF7BFDu  // stp x29, x30, [sp, #-16]!
+#define A64_MOV_FP_SP    0x910003FDu  // mov x29, sp
+#define A64_LDP_FP_LR    0xA8C17BFDu  // ldp x29, x30, [sp], #16
+#define A64_BL           0x94000000u  // bl #0
+#define A64_B            0x14000000u  // b #0
+#define A64_MOVZ_W       0x52800000u  // movz wd, #imm16
+#define A64_MOVK_W_16    0x72A00000u  // movk wd, #imm16, lsl #16
+
+// Fewer functions than this aren't worth handing to the pool
+#define CODEGEN_PARALLEL_MIN 256
+
+// A call site of a function, resolved to a symbol once functions are laid out
+typedef struct {
+    uint32_t offset;            // From the start of the function
+    const char* symbol;
+    uint32_t hash;              // fcef_gnu_hash() of the symbol
+    fcef_reloc_type_t type;
+    int32_t addend;
+} FunctionReloc;
+
+// Code of one function. Functions are generated without touching the
+// output or each other, so they can be generated on any thread.
+typedef struct {
+    uint8_t* code;
+    size_t size;
+    size_t capacity;
+    FunctionReloc* relocs;
+    size_t reloc_count;
+    size_t reloc_capacity;
+    uint32_t hash;              // fcef_gnu_hash() of the function's name
+    bool reused;                // Copied from the previous object
+} FunctionCode;
+
+static void reserve(FunctionCode* fc, size_t size) {
+    if (fc->size + size > fc->capacity) {
+        while (fc->size + size > fc->capacity) {
+            fc->capacity = fc->capacity ? fc->capacity * 2 : 32;
+        }
+        fc->code = xrealloc(fc->code, fc->capacity);
+    }
+}
+
+static void emit(FunctionCode* fc, uint32_t insn) {
+    reserve(fc, 4);
+    uint8_t* p = fc->code + fc->size;
+    p[0] = insn & 0xFF;
+    p[1] = (insn >> 8) & 0xFF;
+    p[2] = (insn >> 16) & 0xFF;
+    p[3] = (insn >> 24) & 0xFF;
+    fc->size += 4;
+}
+
+static void emit_bytes(FunctionCode* fc, const uint8_t* bytes, size_t size) {
+    reserve(fc, size);
+    memcpy(fc->code + fc->size, bytes, size);
+    fc->size += size;
+}
+
+static void add_reloc_at(FunctionCode* fc, uint32_t offset, const char* symbol,
+                         fcef_reloc_type_t type, int32_t addend) {
+    if (fc->reloc_count == fc->reloc_capacity) {
+        fc->reloc_capacity = fc->reloc_capacity ? fc->reloc_capacity * 2 : 4;
+        fc->relocs = xrealloc(fc->relocs, fc->reloc_capacity * sizeof(FunctionReloc));
+    }
+    FunctionReloc* rel = &fc->relocs[fc->reloc_count++];
+    rel->offset = offset;
+    rel->symbol = symbol;
+    rel->type = type;
+    rel->addend = addend;
+}
+
+// Relocation at the current end of the code
+static void add_reloc(FunctionCode* fc, const char* symbol, fcef_reloc_type_t type, int32_t addend) {
+    add_reloc_at(fc, (uint32_t)fc->size, symbol, type, addend);
+}
+
+// mov w0, #value
+static void emit_mov_w0(FunctionCode* fc, uint32_t value) {
+    emit(fc, A64_MOVZ_W | ((value & 0xFFFF) << 5));
+    if (value >> 16) {
+        emit(fc, A64_MOVK_W_16 | ((value >> 16) << 5));
+    }
+}
+
+// The previous object's functions by name and its text relocations by offset
+typedef struct {
+    const eclc_output_t* object;
+    FunctionHash* functions;
+    size_t count;
+    const fcef_reloc_t** relocs;
+    size_t reloc_count;
+} ReuseIndex;
+
+static int compare_function_names(const void* a, const void* b) {
+    return strcmp(((const FunctionHash*)a)->name, ((const FunctionHash*)b)->name);
+}
+
+static int compare_reloc_offsets(const void* a, const void* b) {
+    uint32_t x = (*(const fcef_reloc_t* const*)a)->offset;
+    uint32_t y = (*(const fcef_reloc_t* const*)b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+static void reuse_index_init(ReuseIndex* index, const CodegenCache* cache) {
+    const eclc_output_t* object = cache->object;
+    index->object = object;
+    index->count = cache->count;
+    index->functions = xmalloc((cache->count ? cache->count : 1) * sizeof(FunctionHash));
+    memcpy(index->functions, cache->functions, cache->count * sizeof(FunctionHash));
+    qsort(index->functions, index->count, sizeof(FunctionHash), compare_function_names);
+    
+    index->relocs = xmalloc((object->reloc_count ? object->reloc_count : 1) * sizeof(fcef_reloc_t*));
+    index->reloc_count = 0;
+    for (size_t i = 0; i < object->reloc_count; i++) {
+        if (object->relocs[i].section == FCEF_SEC_TEXT) {
+            index->relocs[index->reloc_count++] = &object->relocs[i];
+        }
+    }
+    qsort(index->relocs, index->reloc_count, sizeof(fcef_reloc_t*), compare_reloc_offsets);
+}
+
+static void reuse_index_free(ReuseIndex* index) {
+    xfree(index->functions);
+    xfree(index->relocs);
+}
+
+// First text relocation at or after `offset`
+static size_t first_reloc(const ReuseIndex* index, uint32_t offset) {
+    size_t lo = 0, hi = index->reloc_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->relocs[mid]->offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Copy a function's code from the previous object when its tokens are
+// unchanged. The index is only read, so this runs on any thread.
+static bool copy_function(FunctionCode* fc, const ReuseIndex* index, const ASTNode* function) {
+    FunctionHash key = { function->token.value, 0 };
+    const FunctionHash* known = bsearch(&key, index->functions, index->count,
+                                        sizeof(FunctionHash), compare_function_names);
+    if (!known || known->hash != function->hash) {
+        return false;
+    }
+    const eclc_output_t* previous = index->object;
+    long found = eclc_lookup_symbol(previous, known->name);
+    if (found < 0) {
+        return false;
+    }
+    const fcef_symbol_t* old = &previous->symbols[found];
+    if (old->section != FCEF_SEC_TEXT || (uint64_t)old->value + old->size > previous->code_size) {
+        return false;
+    }
+    size_t first = first_reloc(index, old->value);
+    size_t last = first_reloc(index, old->value + old->size);
+    for (size_t i = first; i < last; i++) {
+        if (index->relocs[i]->type != FCEF_RELOC_CALL26) {
+            return false;
+        }
+    }
+    
+    emit_bytes(fc, previous->code + old->value, old->size);
+    for (size_t i = first; i < last; i++) {
+        const fcef_reloc_t* rel = index->relocs[i];
+        uint32_t offset = rel->offset - old->value;
+        add_reloc_at(fc, offset, eclc_symbol_name(previous, &previous->symbols[rel->symbol]),
+                     FCEF_RELOC_CALL26, rel->addend);
+        // Resolved for the old layout; put back the bl #0 a fresh emit writes
+        fc->code[offset] = 0;
+        fc->code[offset + 1] = 0;
+        fc->code[offset + 2] = 0;
+        fc->code[offset + 3] &= 0xFC;
+    }
+    return true;
+}
+
+// Leaves get no frame. A call is always in tail position, so with
+// `tail_calls` it becomes a branch and the callee returns for us; the
+// frame is then needed nowhere and isn't set up at all.
+static void emit_function(FunctionCode* fc, const ASTNode* function, bool tail_calls) {
+    ASTNode* value = function->left ? function->left->left : NULL;
+
+    if (value && value->type == NODE_CALL_EXPR && tail_calls) {
+        add_reloc(fc, value->token.value, FCEF_RELOC_CALL26, 0);
+        emit(fc, A64_B);
+        return;
+    } else if (value && value->type == NODE_CALL_EXPR) {
+        emit(fc, A64_STP_FP_LR);
+        emit(fc, A64_MOV_FP_SP);
+        add_reloc(fc, value->token.value, FCEF_RELOC_CALL26, 0);
+        emit(fc, A64_BL);
+        emit(fc, A64_LDP_FP_LR);
+    } else if (value && value->type == NODE_INTEGER_LITERAL && value->token.value) {
+        emit_mov_w0(fc, (uint32_t)strtoul(value->token.value, NULL, 10));
+    }
+    emit(fc, A64_RET);
+}
+
+// Run the peephole pass over a function's words. Call sites are pinned,
+// and their relocations move along with them.
+static void optimize_function(FunctionCode* fc) {
+    size_t count = fc->size / 4;
+    // Most functions are a handful of instructions
+    uint32_t local_insns[16], local_where[16];
+    uint8_t local_pinned[16] = {0};
+    bool small = count <= 16;
+    uint32_t* insns = small ? local_insns : xmalloc(count * sizeof(uint32_t));
+    uint32_t* where = small ? local_where : xmalloc(count * sizeof(uint32_t));
+    uint8_t* pinned = small ? local_pinned : xcalloc(count, 1);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* p = fc->code + i * 4;
+        insns[i] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    for (size_t r = 0; r < fc->reloc_count; r++) {
+        pinned[fc->relocs[r].offset / 4] = 1;
+    }
+    size_t n = peephole_optimize(insns, count, pinned, where);
+    fc->size = 0;
+    for (size_t i = 0; i < n; i++) {
+        emit(fc, insns[i]);
+    }
+    for (size_t r = 0; r < fc->reloc_count; r++) {
+        fc->relocs[r].offset = where[fc->relocs[r].offset / 4] * 4;
+    }
+    if (!small) {
+        xfree(pinned);
+        xfree(where);
+        xfree(insns);
+    }
+}
+
+typedef struct {
+    ASTNode** functions;
+    FunctionCode* code;
+    const ReuseIndex* reuse;    // NULL when there is nothing to copy from
+    bool optimize;
+} GenerateLoop;
+
+// Names are hashed here too, so that laying functions out is left with
+// as little work as possible
+static void generate_body(void* ctx, size_t i) {
+    GenerateLoop* loop = ctx;
+    FunctionCode* fc = &loop->code[i];
+    fc->reused = loop->reuse && copy_function(fc, loop->reuse, loop->functions[i]);
+    if (!fc->reused) {
+        emit_function(fc, loop->functions[i], loop->optimize);
+        if (loop->optimize) {
+            optimize_function(fc);
+        }
+    }
+    fc->hash = fcef_gnu_hash(loop->functions[i]->token.value);
+    for (size_t r = 0; r < fc->reloc_count; r++) {
+        fc->relocs[r].hash = fcef_gnu_hash(fc->relocs[r].symbol);
+    }
+}
+
+typedef struct {
+    uint32_t index;             // Symbol, 0 = free
+    uint32_t hash;
+} SymbolSlot;
+
+// Symbols of the output by name, open addressing
+typedef struct {
+    eclc_output_t* output;
+    SymbolSlot* slots;
+    size_t slot_count;          // Power of two, at least twice the symbols
+} SymbolTable;
+
+static SymbolSlot* symbol_slot(SymbolTable* table, const char* name, uint32_t hash) {
+    const eclc_output_t* out = table->output;
+    size_t mask = table->slot_count - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        SymbolSlot* slot = &table->slots[i];
+        if (slot->index == 0 || (slot->hash == hash &&
+            strcmp(eclc_symbol_name(out, &out->symbols[slot->index]), name) == 0)) {
+            return slot;
+        }
+    }
+}
+
+static void symbol_table_grow(SymbolTable* table, size_t symbols) {
+    SymbolSlot* old = table->slots;
+    size_t old_count = table->slot_count;
+    table->slot_count = 64;
+    while (table->slot_count < symbols * 2) {
+        table->slot_count *= 2;
+    }
+    table->slots = xcalloc(table->slot_count, sizeof(SymbolSlot));
+    for (size_t i = 0; i < old_count; i++) {
+        if (old[i].index != 0) {
+            const char* name = eclc_symbol_name(table->output, &table->output->symbols[old[i].index]);
+            *symbol_slot(table, name, old[i].hash) = old[i];
+        }
+    }
+    xfree(old);
+}
+
+static uint32_t find_or_add_symbol(SymbolTable* table, const char* name, uint32_t hash) {
+    eclc_output_t* out = table->output;
+    if ((out->symbol_count + 1) * 2 > table->slot_count) {
+        symbol_table_grow(table, out->symbol_count + 1);
+    }
+    SymbolSlot* slot = symbol_slot(table, name, hash);
+    if (slot->index == 0) {
+        slot->index = eclc_add_symbol(out, name, FCEF_SEC_UNDEF, 0, 0,
+                                      FCEF_BIND_GLOBAL, FCEF_SYM_NOTYPE);
+        slot->hash = hash;
+    }
+    return slot->index;
+}
+
+// Lay a function out after the previous one, in source order. Symbols are
+// added in the order a one-pass emit meets them, so the output doesn't
+// depend on which thread generated what.
+static void place_function(SymbolTable* table, const ASTNode* function, const FunctionCode* fc) {
+    eclc_output_t* out = table->output;
+    uint32_t sym = find_or_add_symbol(table, function->token.value, fc->hash);
+    uint32_t start = (uint32_t)out->code_size;
+    for (size_t r = 0; r < fc->reloc_count; r++) {
+        const FunctionReloc* rel = &fc->relocs[r];
+        eclc_add_reloc(out, FCEF_SEC_TEXT, start + rel->offset,
+                       find_or_add_symbol(table, rel->symbol, rel->hash), rel->type, rel->addend);
+    }
+    memcpy(out->code + start, fc->code, fc->size);
+    out->code_size += fc->size;
+
+    fcef_symbol_t* s = &out->symbols[sym];
+    if (s->section != FCEF_SEC_UNDEF) {
+        error_report("Redefinition of function '%s'", function->token.value);
+    }
+    s->section = FCEF_SEC_TEXT;
+    s->type = FCEF_SYM_FUNC;
+    s->value = start;
+    s->size = (uint32_t)fc->size;
+}
+
+// Resolve calls whose target lives in this program; the relocations stay
+// in the table so a later link can still redirect them
+static void resolve_local_calls(eclc_output_t* out) {
+    for (size_t i = 0; i < out->reloc_count; i++) {
+        const fcef_reloc_t* rel = &out->relocs[i];
+        const fcef_symbol_t* target = &out->symbols[rel->symbol];
+        if (rel->section != FCEF_SEC_TEXT || target->section != FCEF_SEC_TEXT) {
+            continue;
+        }
+        eclc_apply_reloc(out->code + rel->offset, out->text_addr + rel->offset,
+                         (uint64_t)out->text_addr + target->value + rel->addend,
+                         (fcef_reloc_type_t)rel->type);
+    }
+}
+
+eclc_output_t* codegen_generate(ASTNode* program) {
+    return codegen_generate_with(program, NULL);
+}
+
+eclc_output_t* codegen_generate_with(ASTNode* program, const CodegenOptions* options) {
+    if (!program || program->type != NODE_PROGRAM) {
+        return NULL;
+    }
+    CodegenCache* cache = options ? options->cache : NULL;
+    ThreadPool* pool = options ? options->pool : NULL;
+    if (options) {
+        consteval_calls(program, options->level);
+        inline_calls(program, options->level);
+    }
+
+    size_t count = 0;
+    for (ASTNode* fn = program->left; fn; fn = fn->right) {
+        if (fn->type == NODE_FUNCTION_DEF && fn->token.value) count++;
+    }
+    ASTNode** functions = xmalloc((count ? count : 1) * sizeof(ASTNode*));
+    count = 0;
+    for (ASTNode* fn = program->left; fn; fn = fn->right) {
+        if (fn->type == NODE_FUNCTION_DEF && fn->token.value) functions[count++] = fn;
+    }
+
+    ReuseIndex reuse;
+    bool reusing = cache && cache->object && cache->count > 0;
+    if (reusing) {
+        reuse_index_init(&reuse, cache);
+    }
+    GenerateLoop loop = { functions, xcalloc(count ? count : 1, sizeof(FunctionCode)),
+                          reusing ? &reuse : NULL, options && options->level >= 1 };
+    pool_for(count >= CODEGEN_PARALLEL_MIN ? pool : NULL, count, generate_body, &loop);
+    if (reusing) {
+        reuse_index_free(&reuse);
+    }
+
+    eclc_output_t* out = xcalloc(1, sizeof(eclc_output_t));
+    out->text_addr = ECLC_TEXT_ADDR;
+    out->rodata_addr = ECLC_RODATA_ADDR;
+    out->data_addr = ECLC_DATA_ADDR;
+
+    size_t code_size = 0;
+    size_t reloc_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        code_size += loop.code[i].size;
+        reloc_count += loop.code[i].reloc_count;
+    }
+    out->code = xmalloc(code_size ? code_size : 4);
+    SymbolTable table = { out, NULL, 0 };
+    symbol_table_grow(&table, count + reloc_count);
+    for (size_t i = 0; i < count; i++) {
+        FunctionCode* fc = &loop.code[i];
+        place_function(&table, functions[i], fc);
+        if (fc->reused) {
+            cache->reused++;
+        }
+        xfree(fc->code);
+        xfree(fc->relocs);
+    }
+    xfree(table.slots);
+    xfree(loop.code);
+    xfree(functions);
+
+    if (out->code_size == 0) {
+        FunctionCode ret = {0};
+        emit(&ret, A64_RET);
+        memcpy(out->code, ret.code, ret.size);
+        out->code_size = ret.size;
+        xfree(ret.code);
+    }
+
+    resolve_local_calls(out);
+    eclc_finalize_symbols(out);
+
+    long main_sym = eclc_lookup_symbol(out, "main");
+    if (main_sym >= 0) {
+        out->entry_point = out->text_addr + out->symbols[main_sym].value;
+    }
+    return out;
+}
@@ -0,0 +1,164 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/consteval.h"
+#include "eclc/common.h"
+#include "eclc/hash.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_CALLEE UINT32_MAX
+
+enum { PENDING, RUNNING, SETTLED };
+
+typedef struct {
+    ASTNode** functions;
+    const ASTNode** values;     // Literal each function ends in, NULL if none
+    size_t count;
+} Evaluation;
+
+// Slot of an interned name in a table of function index + 1 (0 = free),
+// open addressing over a power of two
+static size_t name_slot(const uint32_t* slots, size_t mask, ASTNode* const* functions,
+                        const char* name) {
+    for (size_t i = eclc_hash_combine(0, (u64)(uintptr_t)name) & mask;; i = (i + 1) & mask) {
+        if (slots[i] == 0 || functions[slots[i] - 1]->token.value == name) return i;
+    }
+}
+
+static ASTNode* return_value(const ASTNode* function) {
+    return function->left ? function->left->left : NULL;
+}
+
+static bool is_literal(const ASTNode* value) {
+    return value && value->type == NODE_INTEGER_LITERAL && value->token.value;
+}
+
+// Run each function once, following its calls until they end in a literal,
+// leave the program or come back to a call still running. Everything on
+// the way shares the outcome, so no function runs twice.
+static void evaluate(Evaluation* ev, const ASTNode* program) {
+    size_t count = 0;
+    for (ASTNode* fn = program->left; fn; fn = fn->right) {
+        if (fn->type == NODE_FUNCTION_DEF && fn->token.value) count++;
+    }
+    ev->count = count;
+    ev->functions = xmalloc((count ? count : 1) * sizeof(ASTNode*));
+    ev->values = xcalloc(count ? count : 1, sizeof(ASTNode*));
+    if (count == 0) return;
+
+    size_t slot_count = 64;
+    while (slot_count < count * 2) slot_count *= 2;
+    uint32_t* slots = xcalloc(slot_count, sizeof(uint32_t));
+    count = 0;
+    for (ASTNode* fn = program->left; fn; fn = fn->right) {
+        if (fn->type != NODE_FUNCTION_DEF || !fn->token.value) continue;
+        ev->functions[count] = fn;
+        // A call reaches the first definition of a name
+        size_t slot = name_slot(slots, slot_count - 1, ev->functions, fn->token.value);
+        if (slots[slot] == 0) slots[slot] = (uint32_t)count + 1;
+        count++;
+    }
+    uint32_t* callee = xmalloc(count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        const ASTNode* value = return_value(ev->functions[i]);
+        callee[i] = NO_CALLEE;
+        if (value && value->type == NODE_CALL_EXPR) {
+            uint32_t found = slots[name_slot(slots, slot_count - 1, ev->functions, value->token.value)];
+            if (found) callee[i] = found - 1;
+        }
+    }
+
+    uint8_t* state = xcalloc(count, 1);
+    uint32_t* path = xmalloc((count < CONSTEVAL_MAX_DEPTH ? count : CONSTEVAL_MAX_DEPTH) * sizeof(uint32_t));
+    size_t fuel = CONSTEVAL_FUEL;
+    for (size_t root = 0; root < count && fuel > 0; root++) {
+        if (state[root] != PENDING) continue;
+        const ASTNode* result = NULL;
+        size_t depth = 0;
+        for (uint32_t i = (uint32_t)root; depth < CONSTEVAL_MAX_DEPTH && fuel > 0; fuel--) {
+            path[depth++] = i;
+            state[i] = RUNNING;
+            const ASTNode* value = return_value(ev->functions[i]);
+            uint32_t c = callee[i];
+            if (is_literal(value)) {
+                result = value;
+                break;
+            }
+            if (c == NO_CALLEE || state[c] == RUNNING) {
+                break;          // Leaves the program, or never returns
+            }
+            if (state[c] == SETTLED) {
+                result = ev->values[c];
+                break;
+            }
+            i = c;
+        }
+        // Out of fuel or depth: nothing on the way is known either
+        while (depth > 0) {
+            uint32_t i = path[--depth];
+            ev->values[i] = result;
+            state[i] = SETTLED;
+        }
+    }
+
+    xfree(path);
+    xfree(state);
+    xfree(callee);
+    xfree(slots);
+}
+
+static void evaluation_free(Evaluation* ev) {
+    xfree(ev->values);
+    xfree(ev->functions);
+}
+
+bool consteval_function(const ASTNode* program, const char* name, int* value) {
+    if (!program || program->type != NODE_PROGRAM) return false;
+    Evaluation ev;
+    evaluate(&ev, program);
+    bool known = false;
+    for (size_t i = 0; i < ev.count; i++) {
+        if (strcmp(ev.functions[i]->token.value, name) == 0) {
+            known = ev.values[i] != NULL;
+            if (known) *value = atoi(ev.values[i]->token.value);
+            break;
+        }
+    }
+    evaluation_free(&ev);
+    return known;
+}
+
+size_t consteval_calls(ASTNode* program, int level) {
+    if (!program || program->type != NODE_PROGRAM || level < 2) return 0;
+    Evaluation ev;
+    evaluate(&ev, program);
+    size_t replaced = 0;
+    for (size_t i = 0; i < ev.count; i++) {
+        ASTNode* value = return_value(ev.functions[i]);
+        const ASTNode* result = ev.values[i];
+        if (!result || !value || value->type != NODE_CALL_EXPR) continue;
+        value->type = NODE_INTEGER_LITERAL;
+        value->token = result->token;
+        const char* text = result->token.value;
+        ev.functions[i]->hash = eclc_hash64(text, strlen(text), ev.functions[i]->hash);
+        replaced++;
+    }
+    evaluation_free(&ev);
+    return replaced;
+}
@@ -0,0 +1,175 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/inliner.h"
+#include "eclc/common.h"
+#include "eclc/hash.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+static const InlineLimits limits[] = {
+    { 0, 0 },                   // -O0: calls stay calls
+    { 1, 10 },                  // -O1: constants of one instruction, forwarders
+    { 2, 25 },                  // -O2: any constant
+    { 4, 50 },
+};
+
+#define LEVEL_COUNT (int)(sizeof(limits) / sizeof(limits[0]))
+
+const InlineLimits* inline_limits(int level) {
+    return &limits[level < 0 ? 0 : level >= LEVEL_COUNT ? LEVEL_COUNT - 1 : level];
+}
+
+enum { UNVISITED, ACTIVE, DONE };
+
+typedef struct {
+    ASTNode* function;
+    uint32_t callee;            // Function called in tail position, NO_CALLEE if none
+    uint8_t state;
+    bool recursive;             // On a call cycle
+} CallNode;
+
+#define NO_CALLEE UINT32_MAX
+
+// Slot of an interned name in a table of function index + 1 (0 = free),
+// open addressing over a power of two
+static size_t name_slot(const uint32_t* slots, size_t mask, const CallNode* nodes, const char* name) {
+    for (size_t i = eclc_hash_combine(0, (u64)(uintptr_t)name) & mask;; i = (i + 1) & mask) {
+        if (slots[i] == 0 || nodes[slots[i] - 1].function->token.value == name) return i;
+    }
+}
+
+static ASTNode* return_value(const ASTNode* function) {
+    return function->left ? function->left->left : NULL;
+}
+
+// Instructions of `return value;` at -O1, ret included, as the peephole
+// pass leaves them
+static size_t body_size(const ASTNode* value) {
+    if (!value || value->type != NODE_INTEGER_LITERAL || !value->token.value) {
+        return 1;               // ret, or a branch to the callee
+    }
+    uint32_t v = (uint32_t)strtoul(value->token.value, NULL, 10);
+    bool one = (v >> 16) == 0 || (v & 0xFFFF) == 0 || (v >> 16) == 0xFFFF;
+    return one ? 2 : 3;
+}
+
+// Every function from `top` on the DFS path is on the cycle closing there
+static void mark_cycle(CallNode* nodes, const uint32_t* path, size_t depth, uint32_t top) {
+    for (size_t k = depth; k-- > 0;) {
+        nodes[path[k]].recursive = true;
+        if (path[k] == top) break;
+    }
+}
+
+typedef struct {
+    const InlineLimits* limits;
+    size_t budget;              // Instructions the program may still grow by
+    size_t inlined;
+} Inliner;
+
+// Inline the call of a finished function if the cost model allows it
+static void inline_into(Inliner* inliner, CallNode* nodes, CallNode* caller) {
+    if (caller->callee == NO_CALLEE || caller->recursive) return;
+    const CallNode* callee = &nodes[caller->callee];
+    if (callee->recursive) return;
+
+    ASTNode* value = return_value(caller->function);
+    const ASTNode* body = return_value(callee->function);
+    // The caller was a single branch
+    size_t growth = body_size(body) - 1;
+    if (growth > inliner->limits->site_growth || growth > inliner->budget) return;
+    inliner->budget -= growth;
+    inliner->inlined++;
+
+    if (body) {
+        value->type = body->type;
+        value->token = body->token;
+    } else {
+        xfree(value);
+        caller->function->left->left = NULL;
+    }
+    caller->function->hash = eclc_hash_combine(caller->function->hash, callee->function->hash);
+    caller->callee = body && body->type == NODE_CALL_EXPR ? callee->callee : NO_CALLEE;
+}
+
+size_t inline_calls(ASTNode* program, int level) {
+    if (!program || level <= 0) return 0;
+
+    size_t count = 0;
+    for (ASTNode* fn = program->left; fn; fn = fn->right) {
+        if (fn->type == NODE_FUNCTION_DEF && fn->token.value) count++;
+    }
+    if (count == 0) return 0;
+
+    CallNode* nodes = xcalloc(count, sizeof(CallNode));
+    size_t slot_count = 64;
+    while (slot_count < count * 2) slot_count *= 2;
+    uint32_t* slots = xcalloc(slot_count, sizeof(uint32_t));
+    size_t size = 0;
+    count = 0;
+    for (ASTNode* fn = program->left; fn; fn = fn->right) {
+        if (fn->type != NODE_FUNCTION_DEF || !fn->token.value) continue;
+        nodes[count].function = fn;
+        size += body_size(return_value(fn));
+        count++;
+    }
+    // A redefined name calls its first definition, as it is laid out
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = name_slot(slots, slot_count - 1, nodes, nodes[i].function->token.value);
+        if (slots[slot] == 0) slots[slot] = (uint32_t)i + 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const ASTNode* value = return_value(nodes[i].function);
+        nodes[i].callee = NO_CALLEE;
+        if (value && value->type == NODE_CALL_EXPR) {
+            uint32_t found = slots[name_slot(slots, slot_count - 1, nodes, value->token.value)];
+            if (found) nodes[i].callee = found - 1;
+        }
+    }
+
+    // Bottom-up over the call graph. Each function calls at most one other,
+    // so the DFS path is a chain and a cycle is the part of it past the callee.
+    const InlineLimits* model = inline_limits(level);
+    Inliner inliner = { model, INLINE_UNIT_SLACK + size * model->unit_percent / 100, 0 };
+    uint32_t* path = xmalloc(count * sizeof(uint32_t));
+    for (size_t root = 0; root < count; root++) {
+        if (nodes[root].state != UNVISITED) continue;
+        size_t depth = 0;
+        path[depth++] = (uint32_t)root;
+        nodes[root].state = ACTIVE;
+        while (depth > 0) {
+            CallNode* node = &nodes[path[depth - 1]];
+            if (node->callee != NO_CALLEE && nodes[node->callee].state == UNVISITED) {
+                nodes[node->callee].state = ACTIVE;
+                path[depth++] = node->callee;
+                continue;
+            }
+            if (node->callee != NO_CALLEE && nodes[node->callee].state == ACTIVE) {
+                mark_cycle(nodes, path, depth, node->callee);
+            }
+            inline_into(&inliner, nodes, node);
+            node->state = DONE;
+            depth--;
+        }
+    }
+
+    xfree(path);
+    xfree(slots);
+    xfree(nodes);
+    return inliner.inlined;
+}
@@ -0,0 +1,347 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/interp.h"
+#include "eclc/common.h"
+#include "eclc/error.h"
+#include "eclc/hash.h"
+#include "eclc/intern.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct InterpProgram {
+    Insn* code;
+    size_t code_size;
+    size_t code_capacity;
+    InterpFunction* functions;
+    size_t function_count;
+    size_t function_capacity;
+    uint32_t* slots;            // Function index + 1 by name, 0 = free
+    size_t slot_count;          // Power of two, at least twice the functions
+    uint16_t max_registers;     // Of any function, to size register windows
+    bool linked;
+};
+
+InterpProgram* interp_create(void) {
+    return xcalloc(1, sizeof(InterpProgram));
+}
+
+void interp_free(InterpProgram* program) {
+    if (!program) return;
+    xfree(program->code);
+    xfree(program->functions);
+    xfree(program->slots);
+    xfree(program);
+}
+
+const Insn* interp_code(const InterpProgram* program, size_t* size) {
+    *size = program->code_size;
+    return program->code;
+}
+
+const InterpFunction* interp_functions(const InterpProgram* program, size_t* count) {
+    *count = program->function_count;
+    return program->functions;
+}
+
+// Names are interned, so a pointer identifies one
+static size_t name_slot(const InterpProgram* program, const char* name) {
+    size_t mask = program->slot_count - 1;
+    for (size_t i = eclc_hash_combine(0, (u64)(uintptr_t)name) & mask;; i = (i + 1) & mask) {
+        uint32_t index = program->slots[i];
+        if (index == 0 || program->functions[index - 1].name == name) {
+            return i;
+        }
+    }
+}
+
+static uint32_t function_index(InterpProgram* program, const char* name, const char* file) {
+    if ((program->function_count + 1) * 2 > program->slot_count) {
+        xfree(program->slots);
+        program->slot_count = program->slot_count ? program->slot_count * 2 : 64;
+        program->slots = xcalloc(program->slot_count, sizeof(uint32_t));
+        for (size_t i = 0; i < program->function_count; i++) {
+            program->slots[name_slot(program, program->functions[i].name)] = (uint32_t)i + 1;
+        }
+    }
+    size_t slot = name_slot(program, name);
+    if (program->slots[slot] == 0) {
+        if (program->function_count == program->function_capacity) {
+            program->function_capacity = program->function_capacity ? program->function_capacity * 2 : 64;
+            program->functions = xrealloc(program->functions,
+                                          program->function_capacity * sizeof(InterpFunction));
+        }
+        InterpFunction* fn = &program->functions[program->function_count];
+        memset(fn, 0, sizeof(InterpFunction));
+        fn->name = name;
+        fn->file = file;
+        program->slots[slot] = (uint32_t)++program->function_count;
+    }
+    return program->slots[slot] - 1;
+}
+
+static void emit(InterpProgram* program, Opcode op, uint8_t a, uint16_t b, int32_t imm) {
+    if (program->code_size == program->code_capacity) {
+        program->code_capacity = program->code_capacity ? program->code_capacity * 2 : 256;
+        program->code = xrealloc(program->code, program->code_capacity * sizeof(Insn));
+    }
+    Insn* insn = &program->code[program->code_size++];
+    insn->op = (uint8_t)op;
+    insn->a = a;
+    insn->b = b;
+    insn->imm = imm;
+}
+
+// Registers are handed out in order; a function only ever needs a few
+typedef struct {
+    InterpProgram* program;
+    const char* file;
+    uint16_t registers;
+} Lowering;
+
+// Evaluate an expression into a fresh register, or report why it can't be
+static bool lower_expression(Lowering* l, const ASTNode* node, uint8_t* reg) {
+    *reg = (uint8_t)l->registers++;
+    switch (node->type) {
+        case NODE_INTEGER_LITERAL:
+            // Wraps like the 32-bit move the AArch64 backend emits
+            emit(l->program, OP_LOADI, *reg, 0, (int32_t)(uint32_t)strtoul(node->token.value, NULL, 10));
+            return true;
+        case NODE_CALL_EXPR:
+            emit(l->program, OP_CALL, *reg, 0,
+                 (int32_t)function_index(l->program, node->token.value, l->file));
+            return true;
+        default:
+            error_report("%s:%d: Use of undeclared identifier '%s'", l->file, node->token.line,
+                         node->token.value ? node->token.value : "");
+            return false;
+    }
+}
+
+static bool lower_function(Lowering* l, const ASTNode* function) {
+    const ASTNode* value = function->left ? function->left->left : NULL;
+    if (!value) {
+        emit(l->program, OP_RETI, 0, 0, 0);
+    } else if (value->type == NODE_INTEGER_LITERAL) {
+        emit(l->program, OP_RETI, 0, 0, (int32_t)(uint32_t)strtoul(value->token.value, NULL, 10));
+    } else {
+        uint8_t reg;
+        if (!lower_expression(l, value, &reg)) {
+            return false;
+        }
+        emit(l->program, OP_RET, reg, 0, 0);
+    }
+    return true;
+}
+
+bool interp_add_unit(InterpProgram* program, const ASTNode* unit, const char* filename) {
+    ASSERT(!program->linked, "interp_add_unit after interp_link");
+    const char* file = intern_cstr(filename ? filename : "<input>");
+    bool ok = true;
+    for (const ASTNode* fn = unit ? unit->left : NULL; fn; fn = fn->right) {
+        if (fn->type != NODE_FUNCTION_DEF || !fn->token.value) {
+            continue;
+        }
+        uint32_t index = function_index(program, fn->token.value, file);
+        InterpFunction* function = &program->functions[index];
+        if (function->defined) {
+            if (function->file == file) {
+                error_report("Redefinition of function '%s'", function->name);
+            } else {
+                error_report("Redefinition of function '%s' (first defined in %s)",
+                             function->name, function->file);
+            }
+            ok = false;
+            continue;
+        }
+        Lowering l = { program, file, 0 };
+        uint32_t entry = (uint32_t)program->code_size;
+        if (!lower_function(&l, fn)) {
+            program->code_size = entry;
+            ok = false;
+            continue;
+        }
+        // Lowering may have added callees and moved the table
+        function = &program->functions[index];
+        function->defined = true;
+        function->file = file;
+        function->entry = entry;
+        function->size = (uint32_t)program->code_size - entry;
+        function->registers = l.registers;
+        if (l.registers > program->max_registers) {
+            program->max_registers = l.registers;
+        }
+    }
+    return ok;
+}
+
+bool interp_link(InterpProgram* program) {
+    bool ok = true;
+    for (size_t i = 0; i < program->function_count; i++) {
+        const InterpFunction* fn = &program->functions[i];
+        if (!fn->defined) {
+            error_report("Undefined function '%s' called in %s", fn->name, fn->file);
+            ok = false;
+        }
+    }
+    if (!ok) {
+        return false;
+    }
+    // Calls jump straight to the callee's code and open its registers
+    // right after the caller's
+    for (size_t f = 0; f < program->function_count; f++) {
+        const InterpFunction* fn = &program->functions[f];
+        for (size_t i = fn->entry; i < fn->entry + fn->size; i++) {
+            Insn* insn = &program->code[i];
+            if (insn->op == OP_CALL) {
+                insn->imm = (int32_t)program->functions[insn->imm].entry;
+                insn->b = fn->registers;
+            }
+        }
+    }
+    program->linked = true;
+    return true;
+}
+
+// Where to continue when a call returns. The value goes to the register
+// named by the call, which is the instruction before `ret`.
+typedef struct {
+    const Insn* ret;
+    size_t base;                // Caller's first register
+} Frame;
+
+long interp_find(const InterpProgram* program, const char* name) {
+    if (program->slot_count == 0) {
+        return -1;
+    }
+    uint32_t index = program->slots[name_slot(program, intern_cstr(name))];
+    return index != 0 && program->functions[index - 1].defined ? (long)index - 1 : -1;
+}
+
+// Move a stack buffer to the heap the first time it has to grow
+static void* grow(void* buffer, void* local, size_t count, size_t capacity, size_t elem) {
+    if (buffer != local) {
+        return xrealloc(buffer, capacity * elem);
+    }
+    void* heap = xmalloc(capacity * elem);
+    memcpy(heap, buffer, count * elem);
+    return heap;
+}
+
+bool interp_run(const InterpProgram* program, const char* entry, int* result, InterpStats* stats) {
+    ASSERT(program->linked, "interp_run before interp_link");
+    long found = interp_find(program, entry);
+    if (found < 0) {
+        error_report("Entry function '%s' is not defined", entry);
+        return false;
+    }
+
+    // Short programs run entirely in these and never allocate
+    Frame local_frames[64];
+    int32_t local_registers[256];
+    size_t frame_capacity = sizeof(local_frames) / sizeof(Frame);
+    size_t register_capacity = sizeof(local_registers) / sizeof(int32_t);
+    Frame* frames = local_frames;
+    int32_t* registers = local_registers;
+    size_t depth = 0;
+    size_t max_depth = 0;
+    u64 executed = 0;
+    u64 calls = 0;
+    bool ok = true;
+    int32_t value = 0;
+
+    // Threaded dispatch: every handler jumps straight to the next one,
+    // so each opcode's indirect branch is predicted on its own
+    static const void* const dispatch[OP_COUNT] = {
+        [OP_LOADI] = &&op_loadi,
+        [OP_CALL] = &&op_call,
+        [OP_RET] = &&op_ret,
+        [OP_RETI] = &&op_reti,
+    };
+#define DISPATCH() do { executed++; goto *dispatch[pc->op]; } while (0)
+
+    const Insn* code = program->code;
+    const Insn* pc = code + program->functions[found].entry;
+    int32_t* r = registers;
+    size_t max_registers = program->max_registers;
+    DISPATCH();
+
+op_loadi:
+    r[pc->a] = pc->imm;
+    pc++;
+    DISPATCH();
+
+op_call: {
+    if (depth + 1 == frame_capacity) {
+        if (frame_capacity >= INTERP_MAX_DEPTH) {
+            error_report("Call depth exceeded %u frames (unbounded recursion?)", INTERP_MAX_DEPTH);
+            ok = false;
+            goto done;
+        }
+        frames = grow(frames, local_frames, frame_capacity, frame_capacity * 2, sizeof(Frame));
+        frame_capacity *= 2;
+    }
+    size_t base = (size_t)(r - registers);
+    frames[depth].ret = pc + 1;
+    frames[depth].base = base;
+    depth++;
+    calls++;
+    if (depth > max_depth) max_depth = depth;
+    size_t callee = base + pc->b;
+    if (callee + max_registers > register_capacity) {
+        size_t capacity = register_capacity;
+        while (callee + max_registers > capacity) capacity *= 2;
+        registers = grow(registers, local_registers, register_capacity, capacity, sizeof(int32_t));
+        register_capacity = capacity;
+    }
+    r = registers + callee;
+    pc = code + pc->imm;
+    DISPATCH();
+}
+
+op_ret:
+    value = r[pc->a];
+    goto leave;
+
+op_reti:
+    value = pc->imm;
+    goto leave;
+
+leave:
+    if (depth == 0) {
+        goto done;
+    }
+    depth--;
+    pc = frames[depth].ret;
+    r = registers + frames[depth].base;
+    r[pc[-1].a] = value;
+    DISPATCH();
+
+#undef DISPATCH
+done:
+    if (frames != local_frames) xfree(frames);
+    if (registers != local_registers) xfree(registers);
+    if (ok) {
+        *result = value;
+    }
+    if (stats) {
+        stats->instructions = executed;
+        stats->calls = calls;
+        stats->max_depth = (u32)max_depth + 1;
+    }
+    return ok;
+}
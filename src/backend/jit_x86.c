@@ -0,0 +1,303 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/jit.h"
+#include "eclc/common.h"
+#include "eclc/error.h"
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <sys/mman.h>
+#include <unistd.h>
+
+// x86-64 encodings
+#define X64_RET          0xC3         // ret
+#define X64_CALL         0xE8         // call rel32
+#define X64_MOV_EAX      0xB8         // mov eax, imm32
+#define X64_JBE          0x860F       // jbe rel32
+#define X64_CMP_RSP_R15  0xFC394C     // cmp rsp, r15
+#define X64_SUB_RSP      0xEC8148     // sub rsp, imm32
+#define X64_ADD_RSP      0xC48148     // add rsp, imm32
+#define X64_MOV_RSP_IMM  0x2484C7     // mov dword [rsp + disp32], imm32
+#define X64_MOV_RSP_EAX  0x248489     // mov [rsp + disp32], eax
+#define X64_MOV_EAX_RSP  0x24848B     // mov eax, [rsp + disp32]
+
+// Switches to the run's stack, with its limit in r15, and calls the entry
+// point: uint64_t trampoline(void* stack_top, void* stack_limit, void* entry).
+// A call that finds rsp at the limit jumps to the overflow stub, which
+// unwinds to the caller's stack and returns bit 32 set.
+static const uint8_t trampoline[] = {
+    0x53,                           // push rbx
+    0x41, 0x57,                     // push r15
+    0x48, 0x89, 0xE3,               // mov rbx, rsp
+    0x49, 0x89, 0xF7,               // mov r15, rsi
+    0x48, 0x89, 0xFC,               // mov rsp, rdi
+    0xFF, 0xD2,                     // call rdx
+    0x48, 0x89, 0xDC,               // mov rsp, rbx
+    0x41, 0x5F,                     // pop r15
+    0x5B,                           // pop rbx
+    0xC3,                           // ret
+    // overflow:
+    0x48, 0x89, 0xDC,               // mov rsp, rbx
+    0x41, 0x5F,                     // pop r15
+    0x5B,                           // pop rbx
+    0x48, 0xB8, 0, 0, 0, 0, 1, 0, 0, 0, // mov rax, 1 << 32
+    0xC3,                           // ret
+};
+#define TRAMPOLINE_OVERFLOW 21
+
+// Room below the limit for the frame of a leaf function
+#define STACK_GUARD 4096
+
+typedef uint64_t (*Trampoline)(void* stack_top, void* stack_limit, const void* entry);
+
+struct JitCode {
+    const InterpProgram* program;
+    uint8_t* memory;
+    size_t mapped;
+    size_t size;
+    uint32_t* offsets;          // Machine code of each bytecode instruction
+    uint8_t* stack;             // Mapped by the first run and kept, so later
+                                // runs don't fault its pages in again
+};
+
+typedef struct {
+    uint8_t* bytes;
+    size_t size;
+    size_t capacity;
+} Buffer;
+
+static void put(Buffer* b, uint64_t value, size_t size) {
+    if (b->size + size > b->capacity) {
+        while (b->size + size > b->capacity) {
+            b->capacity = b->capacity ? b->capacity * 2 : 4096;
+        }
+        b->bytes = xrealloc(b->bytes, b->capacity);
+    }
+    for (size_t i = 0; i < size; i++) {
+        b->bytes[b->size++] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// A call whose rel32 is filled in once every function has its address
+typedef struct {
+    uint32_t at;                // Offset of the rel32
+    uint32_t target;            // Bytecode instruction called
+} CallFixup;
+
+typedef struct {
+    Buffer code;
+    uint32_t* offsets;
+    CallFixup* fixups;
+    size_t fixup_count;
+    size_t fixup_capacity;
+} Translation;
+
+static void put_call(Translation* t, uint32_t target) {
+    // Check the stack before every call; leaf frames fit in STACK_GUARD
+    put(&t->code, X64_CMP_RSP_R15, 3);
+    put(&t->code, X64_JBE, 2);
+    put(&t->code, (uint32_t)(TRAMPOLINE_OVERFLOW - (t->code.size + 4)), 4);
+    put(&t->code, X64_CALL, 1);
+    if (t->fixup_count == t->fixup_capacity) {
+        t->fixup_capacity = t->fixup_capacity ? t->fixup_capacity * 2 : 64;
+        t->fixups = xrealloc(t->fixups, t->fixup_capacity * sizeof(CallFixup));
+    }
+    t->fixups[t->fixup_count].at = (uint32_t)t->code.size;
+    t->fixups[t->fixup_count].target = target;
+    t->fixup_count++;
+    put(&t->code, 0, 4);
+}
+
+// A function with one register keeps it in eax, which is where calls
+// leave their result and returns want it. With more, every register gets
+// a stack slot, since eax doesn't survive a call.
+static void translate_function(Translation* t, const Insn* code, const InterpFunction* fn) {
+    bool framed = fn->registers > 1;
+    uint32_t frame = framed ? ((uint32_t)fn->registers * 4 + 15) & ~15u : 0;
+    t->offsets[fn->entry] = (uint32_t)t->code.size;
+    if (framed) {
+        put(&t->code, X64_SUB_RSP, 3);
+        put(&t->code, frame, 4);
+    }
+    for (uint32_t i = fn->entry; i < fn->entry + fn->size; i++) {
+        const Insn* insn = &code[i];
+        if (i != fn->entry) {
+            t->offsets[i] = (uint32_t)t->code.size;
+        }
+        uint32_t slot = (uint32_t)insn->a * 4;
+        switch (insn->op) {
+            case OP_LOADI:
+                if (framed) {
+                    put(&t->code, X64_MOV_RSP_IMM, 3);
+                    put(&t->code, slot, 4);
+                } else {
+                    put(&t->code, X64_MOV_EAX, 1);
+                }
+                put(&t->code, (uint32_t)insn->imm, 4);
+                break;
+            case OP_CALL:
+                put_call(t, (uint32_t)insn->imm);
+                if (framed) {
+                    put(&t->code, X64_MOV_RSP_EAX, 3);
+                    put(&t->code, slot, 4);
+                }
+                break;
+            case OP_RET:
+            case OP_RETI:
+                if (insn->op == OP_RETI) {
+                    put(&t->code, X64_MOV_EAX, 1);
+                    put(&t->code, (uint32_t)insn->imm, 4);
+                } else if (framed) {
+                    put(&t->code, X64_MOV_EAX_RSP, 3);
+                    put(&t->code, slot, 4);
+                }
+                if (framed) {
+                    put(&t->code, X64_ADD_RSP, 3);
+                    put(&t->code, frame, 4);
+                }
+                put(&t->code, X64_RET, 1);
+                break;
+        }
+    }
+}
+
+bool jit_available(void) {
+    return true;
+}
+
+JitCode* jit_compile(const InterpProgram* program) {
+    size_t insn_count, function_count;
+    const Insn* code = interp_code(program, &insn_count);
+    const InterpFunction* functions = interp_functions(program, &function_count);
+
+    Translation t = {0};
+    t.offsets = xmalloc((insn_count ? insn_count : 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < sizeof(trampoline); i++) {
+        put(&t.code, trampoline[i], 1);
+    }
+    for (size_t f = 0; f < function_count; f++) {
+        translate_function(&t, code, &functions[f]);
+    }
+    for (size_t i = 0; i < t.fixup_count; i++) {
+        const CallFixup* fix = &t.fixups[i];
+        uint32_t rel = t.offsets[fix->target] - (fix->at + 4);
+        memcpy(t.code.bytes + fix->at, &rel, 4);
+    }
+    xfree(t.fixups);
+
+    // Written while only writable, then only executable
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapped = (t.code.size + page - 1) / page * page;
+    void* memory = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        xfree(t.code.bytes);
+        xfree(t.offsets);
+        return NULL;
+    }
+    memcpy(memory, t.code.bytes, t.code.size);
+    xfree(t.code.bytes);
+    if (mprotect(memory, mapped, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, mapped);
+        xfree(t.offsets);
+        return NULL;
+    }
+
+    JitCode* jit = xcalloc(1, sizeof(JitCode));
+    jit->program = program;
+    jit->memory = memory;
+    jit->mapped = mapped;
+    jit->size = t.code.size;
+    jit->offsets = t.offsets;
+    return jit;
+}
+
+void jit_free(JitCode* code) {
+    if (!code) return;
+    munmap(code->memory, code->mapped);
+    if (code->stack) {
+        munmap(code->stack, JIT_STACK_SIZE);
+    }
+    xfree(code->offsets);
+    xfree(code);
+}
+
+size_t jit_code_size(const JitCode* code) {
+    return code->size;
+}
+
+bool jit_run(JitCode* code, const char* entry, int* result) {
+    size_t count;
+    long found = interp_find(code->program, entry);
+    if (found < 0) {
+        error_report("Entry function '%s' is not defined", entry);
+        return false;
+    }
+    const InterpFunction* fn = &interp_functions(code->program, &count)[found];
+
+    // Only the pages a run touches get memory
+    if (!code->stack) {
+        void* stack = mmap(NULL, JIT_STACK_SIZE, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (stack == MAP_FAILED) {
+            error_report("Cannot map a stack of %zu MiB to run '%s'", JIT_STACK_SIZE >> 20, entry);
+            return false;
+        }
+        code->stack = stack;
+    }
+    Trampoline call = (Trampoline)(void*)code->memory;
+    uint64_t value = call(code->stack + JIT_STACK_SIZE, code->stack + STACK_GUARD,
+                          code->memory + code->offsets[fn->entry]);
+    if (value >> 32) {
+        error_report("Call depth exceeded the %zu MiB stack (unbounded recursion?)",
+                     JIT_STACK_SIZE >> 20);
+        return false;
+    }
+    *result = (int)(uint32_t)value;
+    return true;
+}
+
+#else
+
+// Other hosts interpret
+
+bool jit_available(void) {
+    return false;
+}
+
+JitCode* jit_compile(const InterpProgram* program) {
+    (void)program;
+    return NULL;
+}
+
+void jit_free(JitCode* code) {
+    (void)code;
+}
+
+size_t jit_code_size(const JitCode* code) {
+    (void)code;
+    return 0;
+}
+
+bool jit_run(JitCode* code, const char* entry, int* result) {
+    (void)code;
+    (void)entry;
+    (void)result;
+    return false;
+}
+
+#endif
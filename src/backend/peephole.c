@@ -0,0 +1,285 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/peephole.h"
+#include "eclc/common.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Register fields
+#define RD(insn) ((insn) & 0x1F)
+#define RN(insn) (((insn) >> 5) & 0x1F)
+#define RM(insn) (((insn) >> 16) & 0x1F)
+#define IMM16(insn) (((insn) >> 5) & 0xFFFF)
+
+// AArch64 encodings, register and immediate fields zero
+#define A64_MOVZ_W       0x52800000u  // movz wd, #imm16
+#define A64_MOVZ_W_16    0x52A00000u  // movz wd, #imm16, lsl #16
+#define A64_MOVK_W_16    0x72A00000u  // movk wd, #imm16, lsl #16
+#define A64_MOVN_W       0x12800000u  // movn wd, #imm16
+#define A64_MOV_X        0xAA0003E0u  // mov xd, xm (orr xd, xzr, xm)
+#define A64_ADD_X        0x91000000u  // add xd, xn, #0
+#define A64_STR_X        0xF9000000u  // str xt, [xn, #imm]
+#define A64_LDR_X        0xF9400000u  // ldr xt, [xn, #imm]
+#define A64_B            0x14000000u  // b #imm26 * 4
+#define A64_STP_FP_LR    0xA9BF7BFDu  // stp x29, x30, [sp, #-16]!
+#define A64_MOV_FP_SP    0x910003FDu  // mov x29, sp
+#define A64_LDP_FP_LR    0xA8C17BFDu  // ldp x29, x30, [sp], #16
+
+// Masks that leave out the fields a pattern doesn't care about
+#define MASK_RD          0xFFFFFFE0u  // Everything but the destination
+#define MASK_IMM16       0xFFE00000u  // Also any 16-bit immediate
+#define MASK_MOV_X       0xFFE0FFE0u  // Any two registers
+#define MASK_ADD_ZERO    0xFFFFFC00u
+#define MASK_LDST        0xFFC00000u  // Any register pair and offset
+
+typedef struct {
+    const char* name;
+    int length;
+    uint32_t mask[PEEPHOLE_WINDOW];
+    uint32_t value[PEEPHOLE_WINDOW];
+    // Checks what the masks can't and writes the replacement; returns its
+    // length, which is less than `length`, or -1 when the window doesn't apply
+    int (*rewrite)(const uint32_t* in, uint32_t* out);
+} Pattern;
+
+// mov xd, xd: orr xd, xzr, xd
+static int rewrite_mov_self(const uint32_t* in, uint32_t* out) {
+    (void)out;
+    return RD(in[0]) == RM(in[0]) ? 0 : -1;
+}
+
+// mov xd, xd with sp: add xd, xn, #0
+static int rewrite_add_zero(const uint32_t* in, uint32_t* out) {
+    (void)out;
+    return RD(in[0]) == RN(in[0]) ? 0 : -1;
+}
+
+// mov xa, xb; mov xb, xa: the second copies back what is already there
+static int rewrite_mov_back(const uint32_t* in, uint32_t* out) {
+    // Not when the first targets xzr, which then still reads as zero
+    if (RD(in[0]) != RM(in[1]) || RM(in[0]) != RD(in[1]) || RD(in[0]) == 31) return -1;
+    out[0] = in[0];
+    return 1;
+}
+
+// str xt, [n, #imm]; ldr xt, [n, #imm]: xt still holds what was stored.
+// Store and load share every field but bit 22. Only the X form: ldr wt
+// also clears the top half of xt, which the store leaves as it was.
+static int rewrite_store_reload(const uint32_t* in, uint32_t* out) {
+    if ((in[0] | (1u << 22)) != in[1]) return -1;
+    out[0] = in[0];
+    return 1;
+}
+
+// b #4
+static int rewrite_branch_next(const uint32_t* in, uint32_t* out) {
+    (void)in;
+    (void)out;
+    return 0;
+}
+
+// movz wd, #x; movk wd, #0, lsl #16: movz already cleared the top half
+static int rewrite_movk_zero(const uint32_t* in, uint32_t* out) {
+    if (RD(in[0]) != RD(in[1])) return -1;
+    out[0] = in[0];
+    return 1;
+}
+
+// movz wd, #0; movk wd, #hi, lsl #16 -> movz wd, #hi, lsl #16
+static int rewrite_movz_high(const uint32_t* in, uint32_t* out) {
+    if (RD(in[0]) != RD(in[1])) return -1;
+    out[0] = A64_MOVZ_W_16 | (IMM16(in[1]) << 5) | RD(in[0]);
+    return 1;
+}
+
+// movz wd, #lo; movk wd, #0xffff, lsl #16 -> movn wd, #~lo
+static int rewrite_movn(const uint32_t* in, uint32_t* out) {
+    if (RD(in[0]) != RD(in[1])) return -1;
+    out[0] = A64_MOVN_W | ((~IMM16(in[0]) & 0xFFFF) << 5) | RD(in[0]);
+    return 1;
+}
+
+// stp x29, x30, [sp, #-16]!; [mov x29, sp;] ldp x29, x30, [sp], #16:
+// a frame that is torn down before anything used it
+static int rewrite_empty_frame(const uint32_t* in, uint32_t* out) {
+    (void)in;
+    (void)out;
+    return 0;
+}
+
+// Tried in order at the end of the code emitted so far; longer windows
+// first, so a whole empty frame goes before its parts are looked at
+static const Pattern patterns[] = {
+    { "empty-frame", 3, { 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu },
+                        { A64_STP_FP_LR, A64_MOV_FP_SP, A64_LDP_FP_LR }, rewrite_empty_frame },
+    { "empty-frame", 2, { 0xFFFFFFFFu, 0xFFFFFFFFu },
+                        { A64_STP_FP_LR, A64_LDP_FP_LR }, rewrite_empty_frame },
+    { "mov-back", 2, { MASK_MOV_X, MASK_MOV_X }, { A64_MOV_X, A64_MOV_X }, rewrite_mov_back },
+    { "store-reload", 2, { MASK_LDST, MASK_LDST }, { A64_STR_X, A64_LDR_X }, rewrite_store_reload },
+    { "movk-zero", 2, { MASK_IMM16, MASK_RD }, { A64_MOVZ_W, A64_MOVK_W_16 }, rewrite_movk_zero },
+    { "movz-high", 2, { MASK_RD, MASK_IMM16 }, { A64_MOVZ_W, A64_MOVK_W_16 }, rewrite_movz_high },
+    { "movn", 2, { MASK_IMM16, MASK_RD }, { A64_MOVZ_W, A64_MOVK_W_16 | (0xFFFFu << 5) }, rewrite_movn },
+    { "mov-self", 1, { MASK_MOV_X }, { A64_MOV_X }, rewrite_mov_self },
+    { "add-zero", 1, { MASK_ADD_ZERO }, { A64_ADD_X }, rewrite_add_zero },
+    { "branch-next", 1, { 0xFFFFFFFFu }, { A64_B | 1 }, rewrite_branch_next },
+};
+
+#define PATTERN_COUNT (sizeof(patterns) / sizeof(patterns[0]))
+
+typedef struct {
+    u64 hits;
+    u64 bytes;                  // Code removed
+} PatternCount;
+
+static PatternCount counts[PATTERN_COUNT];
+
+#define NOT_INPUT UINT32_MAX
+
+// Patterns whose last word can have a given top byte, as bits in table
+// order. Every pattern's masks cover the top byte.
+static uint16_t candidates[256];
+static pthread_once_t candidates_once = PTHREAD_ONCE_INIT;
+
+static void build_candidates(void) {
+    ASSERT(PATTERN_COUNT <= 16, "peephole candidate sets hold 16 patterns");
+    for (unsigned byte = 0; byte < 256; byte++) {
+        for (size_t p = 0; p < PATTERN_COUNT; p++) {
+            const Pattern* pattern = &patterns[p];
+            uint32_t mask = pattern->mask[pattern->length - 1];
+            uint32_t value = pattern->value[pattern->length - 1];
+            if (((byte << 24) & mask) == (value & mask & 0xFF000000u)) {
+                candidates[byte] |= (uint16_t)(1u << p);
+            }
+        }
+    }
+}
+
+// Rewrite the tail of the output until no pattern matches it any more.
+// Every rewrite removes at least one word, so there are fewer rewrites
+// than words overall.
+static size_t reduce(uint32_t* insns, uint32_t* src, size_t n, const uint8_t* pinned,
+                     PatternCount* local) {
+    unsigned bits = n ? candidates[insns[n - 1] >> 24] : 0;
+    while (bits) {
+        size_t p = (size_t)__builtin_ctz(bits);
+        bits &= bits - 1;
+        const Pattern* pattern = &patterns[p];
+        size_t length = (size_t)pattern->length;
+        if (length > n) {
+            continue;
+        }
+        uint32_t* window = insns + n - length;
+        bool match = true;
+        for (size_t k = 0; k < length && match; k++) {
+            uint32_t from = src[n - length + k];
+            match = (window[k] & pattern->mask[k]) == pattern->value[k] &&
+                    !(pinned && from != NOT_INPUT && pinned[from]);
+        }
+        uint32_t out[PEEPHOLE_WINDOW];
+        int replaced = match ? pattern->rewrite(window, out) : -1;
+        if (replaced < 0) {
+            continue;
+        }
+        // A kept word keeps its origin, in case a later pattern looks at it
+        for (int k = 0; k < replaced; k++) {
+            if (out[k] != window[k]) src[n - length + k] = NOT_INPUT;
+            window[k] = out[k];
+        }
+        n = n - length + (size_t)replaced;
+        local[p].hits++;
+        local[p].bytes += (length - replaced) * 4;
+        bits = n ? candidates[insns[n - 1] >> 24] : 0;     // Start over on the new tail
+    }
+    return n;
+}
+
+size_t peephole_optimize(uint32_t* insns, size_t count, const uint8_t* pinned, uint32_t* where) {
+    uint32_t local_src[64];
+    uint32_t* src = count <= 64 ? local_src : xmalloc(count * sizeof(uint32_t));
+    PatternCount local[PATTERN_COUNT] = {{0}};
+    pthread_once(&candidates_once, build_candidates);
+    size_t n = 0;
+    // The output never gets ahead of the input, so it overwrites words
+    // that were already read
+    for (size_t i = 0; i < count; i++) {
+        insns[n] = insns[i];
+        src[n] = (uint32_t)i;
+        n = reduce(insns, src, n + 1, pinned, local);
+    }
+    for (size_t j = 0; j < n; j++) {
+        if (src[j] != NOT_INPUT) where[src[j]] = (uint32_t)j;
+    }
+    if (src != local_src) {
+        xfree(src);
+    }
+    for (size_t p = 0; p < PATTERN_COUNT; p++) {
+        if (local[p].hits) {
+            __atomic_add_fetch(&counts[p].hits, local[p].hits, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&counts[p].bytes, local[p].bytes, __ATOMIC_RELAXED);
+        }
+    }
+    return n;
+}
+
+void peephole_reset(void) {
+    memset(counts, 0, sizeof(counts));
+}
+
+void peephole_report(FILE* out, bool json) {
+    u64 total = 0;
+    for (size_t p = 0; p < PATTERN_COUNT; p++) {
+        total += counts[p].hits;
+    }
+    if (total == 0) {
+        return;
+    }
+    // Patterns with several shapes share a name and a line
+    if (json) {
+        fprintf(out, "{\"peephole\":{");
+    } else {
+        fprintf(out, "\033[32m    Peephole\033[0m\n");
+        fprintf(out, "  %-14s %10s %12s\n", "pattern", "hits", "bytes saved");
+    }
+    bool first = true;
+    for (size_t p = 0; p < PATTERN_COUNT; p++) {
+        if (p > 0 && strcmp(patterns[p].name, patterns[p - 1].name) == 0) {
+            continue;
+        }
+        u64 hits = 0, bytes = 0;
+        for (size_t q = p; q < PATTERN_COUNT && strcmp(patterns[q].name, patterns[p].name) == 0; q++) {
+            hits += counts[q].hits;
+            bytes += counts[q].bytes;
+        }
+        if (hits == 0) {
+            continue;
+        }
+        if (json) {
+            fprintf(out, "%s\"%s\":{\"hits\":%llu,\"bytes\":%llu}", first ? "" : ",",
+                    patterns[p].name, (unsigned long long)hits, (unsigned long long)bytes);
+        } else {
+            fprintf(out, "  %-14s %10llu %12llu\n", patterns[p].name,
+                    (unsigned long long)hits, (unsigned long long)bytes);
+        }
+        first = false;
+    }
+    if (json) {
+        fprintf(out, "}}\n");
+    }
+}
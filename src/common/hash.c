@@ -0,0 +1,54 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/hash.h"
+#include <string.h>
+
+#define HASH_PRIME 0x9E3779B97F4A7C15ull
+
+static u64 mix64(u64 h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+u64 eclc_hash64(const void* data, size_t len, u64 seed) {
+    const uint8_t* p = data;
+    u64 h = seed ^ ((u64)len * HASH_PRIME);
+
+    while (len >= 8) {
+        u64 k;
+        memcpy(&k, p, 8);
+        h ^= mix64(k);
+        h = ((h << 27) | (h >> 37)) * HASH_PRIME;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        u64 k = 0;
+        memcpy(&k, p, len);
+        h ^= mix64(k ^ len);
+    }
+    return mix64(h);
+}
+
+u64 eclc_hash_combine(u64 hash, u64 value) {
+    return mix64(hash ^ (value + HASH_PRIME + (hash << 6) + (hash >> 2)));
+}
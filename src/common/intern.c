@@ -0,0 +1,133 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/intern.h"
+#include "eclc/hash.h"
+#include <pthread.h>
+#include <string.h>
+
+#define INTERN_SHARDS 64            // Independent locks, chosen by the top hash bits
+#define INTERN_CHUNK  (8 * 1024)    // Arena block for string bytes
+
+typedef struct {
+    u64 hash;
+    const char* str;
+    size_t len;
+} InternSlot;
+
+typedef struct {
+    pthread_mutex_t lock;
+    InternSlot* slots;          // Open addressing, power-of-two size
+    size_t capacity;
+    size_t count;
+    char* chunk;                // Current arena block, never freed
+    size_t chunk_used;
+    size_t bytes;
+    u64 lookups;
+    u64 hits;
+} InternShard;
+
+static InternShard shards[INTERN_SHARDS];
+static pthread_once_t shards_once = PTHREAD_ONCE_INIT;
+
+static void init_shards(void) {
+    for (int i = 0; i < INTERN_SHARDS; i++) {
+        pthread_mutex_init(&shards[i].lock, NULL);
+    }
+}
+
+static const char* arena_copy(InternShard* shard, const char* str, size_t len) {
+    char* copy;
+    if (len + 1 > INTERN_CHUNK / 4) {
+        copy = xmalloc(len + 1);
+    } else {
+        if (!shard->chunk || shard->chunk_used + len + 1 > INTERN_CHUNK) {
+            shard->chunk = xmalloc(INTERN_CHUNK);
+            shard->chunk_used = 0;
+        }
+        copy = shard->chunk + shard->chunk_used;
+        shard->chunk_used += len + 1;
+    }
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    shard->bytes += len + 1;
+    return copy;
+}
+
+static void grow(InternShard* shard) {
+    size_t capacity = shard->capacity ? shard->capacity * 2 : 64;
+    InternSlot* slots = xcalloc(capacity, sizeof(InternSlot));
+    for (size_t i = 0; i < shard->capacity; i++) {
+        const InternSlot* slot = &shard->slots[i];
+        if (!slot->str) continue;
+        size_t j = slot->hash & (capacity - 1);
+        while (slots[j].str) j = (j + 1) & (capacity - 1);
+        slots[j] = *slot;
+    }
+    xfree(shard->slots);
+    shard->slots = slots;
+    shard->capacity = capacity;
+}
+
+const char* intern(const char* str, size_t len) {
+    pthread_once(&shards_once, init_shards);
+    u64 hash = eclc_hash64(str, len, 0);
+    InternShard* shard = &shards[hash >> 58];
+    
+    pthread_mutex_lock(&shard->lock);
+    shard->lookups++;
+    // Keep the table at most half full
+    if ((shard->count + 1) * 2 > shard->capacity) {
+        grow(shard);
+    }
+    size_t mask = shard->capacity - 1;
+    size_t i = hash & mask;
+    for (; shard->slots[i].str; i = (i + 1) & mask) {
+        const InternSlot* slot = &shard->slots[i];
+        if (slot->hash == hash && slot->len == len && memcmp(slot->str, str, len) == 0) {
+            shard->hits++;
+            pthread_mutex_unlock(&shard->lock);
+            return slot->str;
+        }
+    }
+    InternSlot* slot = &shard->slots[i];
+    slot->hash = hash;
+    slot->len = len;
+    slot->str = arena_copy(shard, str, len);
+    shard->count++;
+    const char* result = slot->str;
+    pthread_mutex_unlock(&shard->lock);
+    return result;
+}
+
+const char* intern_cstr(const char* str) {
+    return intern(str, strlen(str));
+}
+
+void intern_stats(InternStats* stats) {
+    pthread_once(&shards_once, init_shards);
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < INTERN_SHARDS; i++) {
+        InternShard* shard = &shards[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->strings += shard->count;
+        stats->bytes += shard->bytes;
+        stats->lookups += shard->lookups;
+        stats->hits += shard->hits;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
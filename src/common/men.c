@@ -17,14 +17,36 @@
 
  */
 #include "eclc/common.h"
+#include "eclc/profile.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+// Real size of a heap block, so frees can be accounted without a header
+static size_t block_size(void* ptr) {
+#if defined(__GLIBC__)
+    return malloc_usable_size(ptr);
+#elif defined(__APPLE__)
+    return malloc_size(ptr);
+#else
+    (void)ptr;
+    return 0;
+#endif
+}
 
 void* xmalloc(size_t size) {
     void* ptr = malloc(size);
     if (!ptr) {
         PANIC("Out of memory: failed to allocate %zu bytes", size);
     }
+    if (profile_flags & PROFILE_MEM) {
+        profile_note_alloc(size, block_size(ptr));
+    }
     return ptr;
 }
 
@@ -33,19 +55,40 @@ void* xcalloc(size_t count, size_t size) {
     if (!ptr) {
         PANIC("Out of memory: failed to allocate %zu bytes", count * size);
     }
+    if (profile_flags & PROFILE_MEM) {
+        profile_note_alloc(count * size, block_size(ptr));
+    }
     return ptr;
 }
 
 void* xrealloc(void* ptr, size_t size) {
+    size_t old_size = 0;
+    bool accounting = profile_flags & PROFILE_MEM;
+    if (accounting && ptr) {
+        old_size = block_size(ptr);
+    }
     void* new_ptr = realloc(ptr, size);
     if (!new_ptr && size > 0) {
         PANIC("Out of memory: failed to reallocate %zu bytes", size);
     }
+    if (accounting) {
+        profile_note_realloc(old_size, size, new_ptr ? block_size(new_ptr) : 0);
+    }
     return new_ptr;
 }
 
 void xfree(void* ptr) {
     if (ptr) {
+        if (profile_flags & PROFILE_MEM) {
+            profile_note_free(block_size(ptr));
+        }
         free(ptr);
     }
-}
\ No newline at end of file
+}
+
+char* xstrdup(const char* str) {
+    size_t len = strlen(str) + 1;
+    char* copy = xmalloc(len);
+    memcpy(copy, str, len);
+    return copy;
+}
@@ -0,0 +1,366 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/pool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Work stealing: every worker owns a deque. It pushes and pops its own
+// jobs at the tail (newest first, cache-warm) while idle workers steal
+// from the head (oldest first, usually the biggest piece of work).
+// Jobs submitted from outside the pool go to a shared injection deque.
+
+typedef struct {
+    PoolJob job;
+    void* arg;
+} PoolTask;
+
+typedef struct {
+    pthread_mutex_t lock;
+    PoolTask* tasks;            // Ring buffer
+    size_t capacity;            // Power of two
+    size_t head;                // Next to steal
+    size_t tail;                // Next free slot
+} WorkDeque;
+
+struct ThreadPool {
+    pthread_t* threads;
+    int thread_count;
+    WorkDeque* deques;          // One per worker, then the injection deque
+    pthread_mutex_t lock;       // Guards sleeping and the condition waits
+    pthread_cond_t has_work;
+    pthread_cond_t idle;
+    size_t queued;              // Jobs sitting in deques (atomic)
+    size_t pending;             // Queued + running (atomic)
+    int sleeping;
+    bool stopping;
+};
+
+// Worker identity of the running thread, so nested submits stay local
+static __thread ThreadPool* current_pool;
+static __thread int current_worker = -1;
+static __thread uint32_t steal_seed;
+
+int pool_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+static void deque_init(WorkDeque* dq) {
+    pthread_mutex_init(&dq->lock, NULL);
+    dq->capacity = 64;
+    dq->tasks = xmalloc(dq->capacity * sizeof(PoolTask));
+    dq->head = dq->tail = 0;
+}
+
+static void deque_destroy(WorkDeque* dq) {
+    pthread_mutex_destroy(&dq->lock);
+    xfree(dq->tasks);
+}
+
+static void deque_push(WorkDeque* dq, PoolTask task) {
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail - dq->head == dq->capacity) {
+        PoolTask* tasks = xmalloc(dq->capacity * 2 * sizeof(PoolTask));
+        for (size_t i = dq->head; i != dq->tail; i++) {
+            tasks[i & (dq->capacity * 2 - 1)] = dq->tasks[i & (dq->capacity - 1)];
+        }
+        xfree(dq->tasks);
+        dq->tasks = tasks;
+        dq->capacity *= 2;
+    }
+    dq->tasks[dq->tail & (dq->capacity - 1)] = task;
+    __atomic_store_n(&dq->tail, dq->tail + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&dq->lock);
+}
+
+static bool deque_pop(WorkDeque* dq, PoolTask* task) {
+    pthread_mutex_lock(&dq->lock);
+    bool found = dq->tail != dq->head;
+    if (found) {
+        __atomic_store_n(&dq->tail, dq->tail - 1, __ATOMIC_RELAXED);
+        *task = dq->tasks[dq->tail & (dq->capacity - 1)];
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static bool deque_steal(WorkDeque* dq, PoolTask* task) {
+    // Peek without the lock so idle workers don't pile up on empty deques
+    if (__atomic_load_n(&dq->tail, __ATOMIC_RELAXED) == __atomic_load_n(&dq->head, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    pthread_mutex_lock(&dq->lock);
+    bool found = dq->tail != dq->head;
+    if (found) {
+        *task = dq->tasks[dq->head & (dq->capacity - 1)];
+        __atomic_store_n(&dq->head, dq->head + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static uint32_t next_victim(void) {
+    uint32_t x = steal_seed ? steal_seed : 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    steal_seed = x;
+    return x;
+}
+
+// Own deque first, then the injection deque, then steal from a random victim
+static bool find_task(ThreadPool* pool, int self, PoolTask* task) {
+    bool found = (self >= 0 && deque_pop(&pool->deques[self], task)) ||
+                 deque_steal(&pool->deques[pool->thread_count], task);
+    if (!found) {
+        int n = pool->thread_count;
+        int start = (int)(next_victim() % (uint32_t)n);
+        for (int k = 0; k < n && !found; k++) {
+            int victim = (start + k) % n;
+            if (victim != self) found = deque_steal(&pool->deques[victim], task);
+        }
+    }
+    if (found) {
+        __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    }
+    return found;
+}
+
+static void run_task(ThreadPool* pool, const PoolTask* task) {
+    task->job(task->arg);
+    if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->idle);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void* worker_main(void* arg) {
+    ThreadPool* pool = arg;
+    int self = current_worker;
+    for (;;) {
+        PoolTask task;
+        if (find_task(pool, self, &task)) {
+            run_task(pool, &task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0 && !pool->stopping) {
+            pool->sleeping++;
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+            pool->sleeping--;
+        }
+        bool stop = pool->stopping && __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (stop) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} WorkerStart;
+
+static void* worker_start(void* arg) {
+    WorkerStart start = *(WorkerStart*)arg;
+    xfree(arg);
+    current_pool = start.pool;
+    current_worker = start.index;
+    steal_seed = 2463534242u ^ ((uint32_t)start.index * 2654435761u);
+    return worker_main(start.pool);
+}
+
+ThreadPool* pool_create(int threads) {
+    ThreadPool* pool = xcalloc(1, sizeof(ThreadPool));
+    pool->thread_count = threads > 0 ? threads : pool_cpu_count();
+    pool->threads = xcalloc(pool->thread_count, sizeof(pthread_t));
+    pool->deques = xcalloc(pool->thread_count + 1, sizeof(WorkDeque));
+    for (int i = 0; i <= pool->thread_count; i++) {
+        deque_init(&pool->deques[i]);
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        WorkerStart* start = xmalloc(sizeof(WorkerStart));
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_start, start) != 0) {
+            PANIC("Cannot create worker thread %d", i);
+        }
+    }
+    return pool;
+}
+
+void pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i <= pool->thread_count; i++) {
+        deque_destroy(&pool->deques[i]);
+    }
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->has_work);
+    pthread_mutex_destroy(&pool->lock);
+    xfree(pool->deques);
+    xfree(pool->threads);
+    xfree(pool);
+}
+
+int pool_size(const ThreadPool* pool) {
+    return pool ? pool->thread_count : 1;
+}
+
+static int worker_index(const ThreadPool* pool) {
+    return current_pool == pool ? current_worker : -1;
+}
+
+void pool_submit(ThreadPool* pool, PoolJob job, void* arg) {
+    PoolTask task = { job, arg };
+    int self = worker_index(pool);
+
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL);
+    deque_push(&pool->deques[self >= 0 ? self : pool->thread_count], task);
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->sleeping > 0) {
+        pthread_cond_signal(&pool->has_work);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_wait(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// One pool_for call; runners claim index ranges until the loop is done
+typedef struct {
+    PoolForBody body;
+    void* ctx;
+    size_t count;
+    size_t next;                // Atomic
+    size_t chunk;
+    int running;                // Runners not finished yet, under lock
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+} PoolFor;
+
+static void pool_for_claim(PoolFor* loop) {
+    for (;;) {
+        size_t begin = __atomic_fetch_add(&loop->next, loop->chunk, __ATOMIC_RELAXED);
+        if (begin >= loop->count) {
+            break;
+        }
+        size_t end = begin + loop->chunk;
+        if (end > loop->count) end = loop->count;
+        for (size_t i = begin; i < end; i++) {
+            loop->body(loop->ctx, i);
+        }
+    }
+}
+
+static void pool_for_runner(void* arg) {
+    PoolFor* loop = arg;
+    pool_for_claim(loop);
+
+    pthread_mutex_lock(&loop->lock);
+    if (--loop->running == 0) {
+        pthread_cond_signal(&loop->done);
+    }
+    pthread_mutex_unlock(&loop->lock);
+}
+
+static bool pool_for_finished(PoolFor* loop) {
+    pthread_mutex_lock(&loop->lock);
+    bool finished = loop->running == 0;
+    pthread_mutex_unlock(&loop->lock);
+    return finished;
+}
+
+void pool_for(ThreadPool* pool, size_t count, PoolForBody body, void* ctx) {
+    if (count == 0) return;
+    if (!pool || pool->thread_count == 1 || count == 1) {
+        for (size_t i = 0; i < count; i++) {
+            body(ctx, i);
+        }
+        return;
+    }
+
+    PoolFor loop;
+    loop.body = body;
+    loop.ctx = ctx;
+    loop.count = count;
+    loop.next = 0;
+    // Small chunks keep uneven items balanced without hammering the counter
+    loop.chunk = count / ((size_t)pool->thread_count * 8);
+    if (loop.chunk == 0) loop.chunk = 1;
+    pthread_mutex_init(&loop.lock, NULL);
+    pthread_cond_init(&loop.done, NULL);
+
+    // The caller is one of the runners, so only thread_count - 1 are queued
+    int jobs = pool->thread_count - 1;
+    if ((size_t)jobs > count - 1) jobs = (int)(count - 1);
+    loop.running = jobs;
+    for (int i = 0; i < jobs; i++) {
+        pool_submit(pool, pool_for_runner, &loop);
+    }
+    pool_for_claim(&loop);
+
+    // A worker must not block here: nested loops would deadlock once every
+    // worker waits. It runs other jobs until its runners are done instead.
+    int self = worker_index(pool);
+    if (self >= 0) {
+        while (!pool_for_finished(&loop)) {
+            PoolTask task;
+            if (find_task(pool, self, &task)) {
+                run_task(pool, &task);
+            } else {
+                sched_yield();
+            }
+        }
+    } else {
+        pthread_mutex_lock(&loop.lock);
+        while (loop.running > 0) {
+            pthread_cond_wait(&loop.done, &loop.lock);
+        }
+        pthread_mutex_unlock(&loop.lock);
+    }
+
+    pthread_cond_destroy(&loop.done);
+    pthread_mutex_destroy(&loop.lock);
+}
@@ -0,0 +1,372 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/profile.h"
+#include "eclc/intern.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+unsigned profile_flags;
+
+typedef struct {
+    u64 ns;
+    u64 calls;
+} PhaseTime;
+
+typedef struct {
+    u64 allocs;
+    u64 reallocs;
+    u64 frees;
+    u64 bytes;                  // Requested by malloc, calloc and realloc
+    i64 peak;                   // Highest live total seen while in this phase
+} PhaseMemory;
+
+static PhaseTime phase_times[PHASE_COUNT];
+static u64 wall_start_ns;
+
+static PhaseMemory phase_memory[PHASE_COUNT];
+static u64 size_classes[MEM_SIZE_CLASSES];
+static i64 live_bytes;
+static i64 peak_bytes;
+
+typedef struct {
+    const char* file;           // Interned, or NULL
+    u64 size;
+    u64 start_ns;
+    u64 dur_ns;
+    Phase phase;
+} TraceEvent;
+
+// Spans recorded by one thread. Buffers stay on the global list after
+// their thread exits so they can still be written out.
+typedef struct TraceBuffer {
+    struct TraceBuffer* next;
+    int id;
+    TraceEvent* events;
+    size_t count;
+    size_t capacity;
+} TraceBuffer;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer* trace_buffers;
+static int trace_threads;
+
+// The phase the calling thread is in and when it was last charged
+static __thread Phase current_phase;
+static __thread u64 mark_ns;
+static __thread int depth;
+
+static __thread TraceBuffer* trace_buffer;
+static __thread const char* trace_file;
+static __thread u64 trace_size;
+
+static const char* const phase_names[PHASE_COUNT] = {
+    "other", "scan", "read", "lex", "parse", "codegen", "fcef", "cache", "link"
+};
+
+static u64 now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000u + (u64)ts.tv_nsec;
+}
+
+const char* phase_name(Phase phase) {
+    return phase < PHASE_COUNT ? phase_names[phase] : "?";
+}
+
+// Charge the time since the last mark to the current phase
+static void charge(u64 now) {
+    if (depth > 0 && (profile_flags & PROFILE_TIME)) {
+        __atomic_add_fetch(&phase_times[current_phase].ns, now - mark_ns, __ATOMIC_RELAXED);
+    }
+    mark_ns = now;
+}
+
+// Only this thread appends to its buffer; the lock guards the list
+static void trace_event(const PhaseScope* scope, u64 now) {
+    TraceBuffer* buffer = trace_buffer;
+    if (!buffer) {
+        buffer = xcalloc(1, sizeof(TraceBuffer));
+        pthread_mutex_lock(&trace_lock);
+        buffer->id = ++trace_threads;
+        buffer->next = trace_buffers;
+        trace_buffers = buffer;
+        pthread_mutex_unlock(&trace_lock);
+        trace_buffer = buffer;
+    }
+    if (buffer->count == buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        buffer->events = xrealloc(buffer->events, buffer->capacity * sizeof(TraceEvent));
+    }
+    TraceEvent* event = &buffer->events[buffer->count++];
+    event->file = trace_file;
+    event->size = trace_size;
+    event->start_ns = scope->start_ns;
+    event->dur_ns = now - scope->start_ns;
+    event->phase = scope->phase;
+}
+
+void phase_enter_slow(PhaseScope* scope, Phase phase) {
+    u64 now = (profile_flags & (PROFILE_TIME | PROFILE_TRACE)) ? now_ns() : 0;
+    charge(now);
+    scope->phase = phase;
+    scope->previous = current_phase;
+    scope->start_ns = now;
+    current_phase = phase;
+    depth++;
+}
+
+void phase_leave_slow(PhaseScope* scope) {
+    u64 now = (profile_flags & (PROFILE_TIME | PROFILE_TRACE)) ? now_ns() : 0;
+    charge(now);
+    if (profile_flags & PROFILE_TRACE) {
+        trace_event(scope, now);
+    }
+    __atomic_add_fetch(&phase_times[scope->phase].calls, 1, __ATOMIC_RELAXED);
+    current_phase = scope->previous;
+    depth--;
+}
+
+void profile_reset(void) {
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        __atomic_store_n(&phase_times[i].ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&phase_times[i].calls, 0, __ATOMIC_RELAXED);
+        memset(&phase_memory[i], 0, sizeof(PhaseMemory));
+    }
+    memset(size_classes, 0, sizeof(size_classes));
+    __atomic_store_n(&live_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&peak_bytes, 0, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&trace_lock);
+    for (TraceBuffer* buffer = trace_buffers; buffer; buffer = buffer->next) {
+        buffer->count = 0;
+    }
+    pthread_mutex_unlock(&trace_lock);
+    wall_start_ns = now_ns();
+}
+
+void profile_report_time(FILE* out, bool json) {
+    double wall_ms = (now_ns() - wall_start_ns) / 1e6;
+    u64 total_ns = 0;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        total_ns += phase_times[i].ns;
+    }
+
+    if (json) {
+        fprintf(out, "{\"wall_ms\":%.3f,\"total_ms\":%.3f,\"phases\":{", wall_ms, total_ns / 1e6);
+        bool first = true;
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            const PhaseTime* t = &phase_times[i];
+            if (t->calls == 0) continue;
+            fprintf(out, "%s\"%s\":{\"calls\":%llu,\"ms\":%.3f}", first ? "" : ",",
+                    phase_names[i], (unsigned long long)t->calls, t->ns / 1e6);
+            first = false;
+        }
+        fprintf(out, "}}\n");
+        return;
+    }
+
+    // Phase times are summed over threads, so the total can exceed wall time
+    fprintf(out, "\033[32m   Time report\033[0m\n");
+    fprintf(out, "  %-10s %10s %12s %8s %12s\n", "phase", "calls", "time (ms)", "share", "avg (us)");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseTime* t = &phase_times[i];
+        if (t->calls == 0) continue;
+        fprintf(out, "  %-10s %10llu %12.3f %7.1f%% %12.2f\n", phase_names[i],
+                (unsigned long long)t->calls, t->ns / 1e6,
+                total_ns ? 100.0 * t->ns / total_ns : 0.0, t->ns / 1e3 / t->calls);
+    }
+    fprintf(out, "  %-10s %10s %12.3f\n", "total", "", total_ns / 1e6);
+    fprintf(out, "  %-10s %10s %12.3f\n", "wall", "", wall_ms);
+}
+
+static int size_class(size_t size) {
+    if (size <= 16) return 0;
+    int bits = 64 - __builtin_clzll((unsigned long long)(size - 1));
+    return bits - 4 < MEM_SIZE_CLASSES ? bits - 4 : MEM_SIZE_CLASSES - 1;
+}
+
+static void store_max(i64* target, i64 value) {
+    i64 seen = __atomic_load_n(target, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(target, &seen, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void update_live(i64 delta) {
+    i64 live = __atomic_add_fetch(&live_bytes, delta, __ATOMIC_RELAXED);
+    if (delta > 0) {
+        store_max(&peak_bytes, live);
+        store_max(&phase_memory[current_phase].peak, live);
+    }
+}
+
+void profile_note_alloc(size_t requested, size_t usable) {
+    PhaseMemory* m = &phase_memory[current_phase];
+    __atomic_add_fetch(&m->allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m->bytes, requested, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&size_classes[size_class(requested)], 1, __ATOMIC_RELAXED);
+    update_live((i64)usable);
+}
+
+void profile_note_realloc(size_t old_usable, size_t requested, size_t usable) {
+    PhaseMemory* m = &phase_memory[current_phase];
+    __atomic_add_fetch(&m->reallocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m->bytes, requested, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&size_classes[size_class(requested)], 1, __ATOMIC_RELAXED);
+    update_live((i64)usable - (i64)old_usable);
+}
+
+void profile_note_free(size_t usable) {
+    __atomic_add_fetch(&phase_memory[current_phase].frees, 1, __ATOMIC_RELAXED);
+    update_live(-(i64)usable);
+}
+
+static size_t class_limit(int index) {
+    return (size_t)16 << index;
+}
+
+void profile_report_mem(FILE* out, bool json) {
+    PhaseMemory total = {0};
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        total.allocs += phase_memory[i].allocs;
+        total.reallocs += phase_memory[i].reallocs;
+        total.frees += phase_memory[i].frees;
+        total.bytes += phase_memory[i].bytes;
+    }
+
+    if (json) {
+        fprintf(out, "{\"peak_live\":%lld,\"live\":%lld,\"allocs\":%llu,\"bytes\":%llu,\"phases\":{",
+                (long long)peak_bytes, (long long)live_bytes,
+                (unsigned long long)(total.allocs + total.reallocs), (unsigned long long)total.bytes);
+        bool first = true;
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            const PhaseMemory* m = &phase_memory[i];
+            if (m->allocs + m->reallocs + m->frees == 0) continue;
+            fprintf(out, "%s\"%s\":{\"allocs\":%llu,\"reallocs\":%llu,\"frees\":%llu,"
+                         "\"bytes\":%llu,\"peak_live\":%lld}",
+                    first ? "" : ",", phase_names[i], (unsigned long long)m->allocs,
+                    (unsigned long long)m->reallocs, (unsigned long long)m->frees,
+                    (unsigned long long)m->bytes, (long long)m->peak);
+            first = false;
+        }
+        fprintf(out, "},\"size_classes\":[");
+        for (int i = 0; i < MEM_SIZE_CLASSES; i++) {
+            fprintf(out, "%s{\"max\":%lld,\"count\":%llu}", i ? "," : "",
+                    i + 1 < MEM_SIZE_CLASSES ? (long long)class_limit(i) : -1LL,
+                    (unsigned long long)size_classes[i]);
+        }
+        fprintf(out, "]}\n");
+        return;
+    }
+
+    // "peak live" of a phase is the process-wide total at its highest
+    // point while some thread was in that phase
+    fprintf(out, "\033[32m Memory report\033[0m\n");
+    fprintf(out, "  %-10s %10s %10s %10s %14s %14s\n",
+            "phase", "allocs", "reallocs", "frees", "bytes", "peak live");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseMemory* m = &phase_memory[i];
+        if (m->allocs + m->reallocs + m->frees == 0) continue;
+        fprintf(out, "  %-10s %10llu %10llu %10llu %14llu %14lld\n", phase_names[i],
+                (unsigned long long)m->allocs, (unsigned long long)m->reallocs,
+                (unsigned long long)m->frees, (unsigned long long)m->bytes, (long long)m->peak);
+    }
+    fprintf(out, "  %-10s %10llu %10llu %10llu %14llu %14lld\n", "total",
+            (unsigned long long)total.allocs, (unsigned long long)total.reallocs,
+            (unsigned long long)total.frees, (unsigned long long)total.bytes, (long long)peak_bytes);
+    fprintf(out, "  still live at exit: %lld bytes\n", (long long)live_bytes);
+
+    u64 most = 1;
+    for (int i = 0; i < MEM_SIZE_CLASSES; i++) {
+        if (size_classes[i] > most) most = size_classes[i];
+    }
+    fprintf(out, "  size classes:\n");
+    for (int i = 0; i < MEM_SIZE_CLASSES; i++) {
+        if (size_classes[i] == 0) continue;
+        char label[32];
+        if (i + 1 < MEM_SIZE_CLASSES) {
+            snprintf(label, sizeof(label), "<= %zu", class_limit(i));
+        } else {
+            snprintf(label, sizeof(label), "> %zu", class_limit(i - 1));
+        }
+        int bar = (int)(size_classes[i] * 40 / most);
+        fprintf(out, "    %-12s %10llu %.*s\n", label, (unsigned long long)size_classes[i],
+                bar > 0 ? bar : 1, "########################################");
+    }
+}
+
+void profile_trace_file(const char* name) {
+    if (profile_flags & PROFILE_TRACE) {
+        trace_file = name ? intern_cstr(name) : NULL;
+        trace_size = 0;
+    }
+}
+
+void profile_trace_size(u64 size) {
+    trace_size = size;
+}
+
+static void write_json_string(FILE* out, const char* s) {
+    fputc('"', out);
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04x", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+bool profile_write_trace(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        return false;
+    }
+    
+    // Times are microseconds from profile_reset, one track per thread
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    pthread_mutex_lock(&trace_lock);
+    for (const TraceBuffer* buffer = trace_buffers; buffer; buffer = buffer->next) {
+        if (buffer->count == 0) continue;
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                     "\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", buffer->id, buffer->id);
+        first = false;
+        for (size_t i = 0; i < buffer->count; i++) {
+            const TraceEvent* e = &buffer->events[i];
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"eclc\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                         "\"ts\":%.3f,\"dur\":%.3f",
+                    phase_names[e->phase], buffer->id,
+                    (e->start_ns - wall_start_ns) / 1e3, e->dur_ns / 1e3);
+            if (e->file) {
+                fprintf(out, ",\"args\":{\"file\":");
+                write_json_string(out, e->file);
+                fprintf(out, ",\"size\":%llu}", (unsigned long long)e->size);
+            }
+            fputc('}', out);
+        }
+    }
+    pthread_mutex_unlock(&trace_lock);
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
@@ -0,0 +1,189 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/queue.h"
+#include <pthread.h>
+#include <stdint.h>
+
+// Dmitry Vyukov's bounded MPMC ring: every slot carries a sequence number
+// that says whose turn it is. A producer at position p may fill the slot
+// once its sequence is p; a consumer may empty it once it is p + 1, and
+// hands it back for the next lap as p + capacity.
+
+#define QUEUE_LINE 64
+
+typedef struct {
+    size_t sequence;            // Atomic
+    void* item;
+} QueueSlot;
+
+struct BoundedQueue {
+    QueueSlot* slots;
+    size_t mask;
+    char pad0[QUEUE_LINE];
+    size_t head;                // Next to pop (atomic)
+    char pad1[QUEUE_LINE];
+    size_t tail;                // Next to push (atomic)
+    char pad2[QUEUE_LINE];
+    int sleepers;               // Threads waiting on `changed` (atomic)
+    bool closed;                // Atomic
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+BoundedQueue* queue_create(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    BoundedQueue* queue = xcalloc(1, sizeof(BoundedQueue));
+    queue->slots = xmalloc(size * sizeof(QueueSlot));
+    queue->mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        queue->slots[i].sequence = i;
+        queue->slots[i].item = NULL;
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    return queue;
+}
+
+void queue_destroy(BoundedQueue* queue) {
+    if (!queue) return;
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+    xfree(queue->slots);
+    xfree(queue);
+}
+
+bool queue_try_push(BoundedQueue* queue, void* item) {
+    size_t pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    for (;;) {
+        QueueSlot* slot = &queue->slots[pos & queue->mask];
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot->item = item;
+                __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;       // A whole lap behind: full
+        } else {
+            pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+bool queue_try_pop(BoundedQueue* queue, void** item) {
+    size_t pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    for (;;) {
+        QueueSlot* slot = &queue->slots[pos & queue->mask];
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *item = slot->item;
+                __atomic_store_n(&slot->sequence, pos + queue->mask + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;       // Not filled yet: empty
+        } else {
+            pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Wake sleepers after a push or pop. The fence pairs with the one in
+// register_sleeper: either the sleeper's retry sees our change, or we see it
+// registered and take the lock, which it only gives up inside the wait.
+static void wake(BoundedQueue* queue) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&queue->sleepers, __ATOMIC_RELAXED) > 0) {
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_broadcast(&queue->changed);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+// Announce a sleeper before its last try; called with the lock held
+static void register_sleeper(BoundedQueue* queue) {
+    __atomic_add_fetch(&queue->sleepers, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static void unregister_sleeper(BoundedQueue* queue) {
+    __atomic_sub_fetch(&queue->sleepers, 1, __ATOMIC_RELAXED);
+}
+
+void queue_push(BoundedQueue* queue, void* item) {
+    if (!queue_try_push(queue, item)) {
+        pthread_mutex_lock(&queue->lock);
+        register_sleeper(queue);
+        while (!queue_try_push(queue, item)) {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        unregister_sleeper(queue);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    wake(queue);
+}
+
+bool queue_pop(BoundedQueue* queue, void** item) {
+    bool popped = queue_try_pop(queue, item);
+    if (!popped) {
+        pthread_mutex_lock(&queue->lock);
+        register_sleeper(queue);
+        while (!(popped = queue_try_pop(queue, item)) &&
+               !__atomic_load_n(&queue->closed, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        // Closed: anything pushed before the close is still there
+        if (!popped) {
+            popped = queue_try_pop(queue, item);
+        }
+        unregister_sleeper(queue);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    if (popped) {
+        wake(queue);
+    }
+    return popped;
+}
+
+size_t queue_pop_many(BoundedQueue* queue, void** items, size_t max) {
+    if (max == 0 || !queue_pop(queue, &items[0])) {
+        return 0;
+    }
+    size_t count = 1;
+    while (count < max && queue_try_pop(queue, &items[count])) {
+        count++;
+    }
+    if (count > 1) {
+        wake(queue);
+    }
+    return count;
+}
+
+void queue_close(BoundedQueue* queue) {
+    __atomic_store_n(&queue->closed, true, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&queue->lock);
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+}
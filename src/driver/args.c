@@ -15,30 +15,30 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
-#include "eclc/common.h"
+#include "eclc/args.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-typedef struct {
-    char** input_files;
-    int file_count;
-    bool c_mode;
-    bool cpp_mode;
-    bool folder_mode;
-    char* folder_path;
-    char* output_file;
-    int optimization_level;
-    bool debug_info;
-    bool show_help;
-    bool show_version;
-} CompilerConfig;
+// Thread count from "-j N" or "-jN"
+static bool parse_jobs(int argc, char** argv, int* i, int* jobs) {
+    const char* value = argv[*i] + 2;
+    if (*value == '\0') {
+        if (*i + 1 >= argc) return false;
+        value = argv[++*i];
+    }
+    char* end;
+    long n = strtol(value, &end, 10);
+    if (*end != '\0' || n < 0 || n > 4096) return false;
+    *jobs = (int)n;
+    return true;
+}
 
 CompilerConfig parse_arguments(int argc, char** argv) {
     CompilerConfig config = {0};
     config.optimization_level = 0; // Default: no optimization
     
-    for (int i = 1; i < argc; i++) {
+    for (int i = 1; i < argc && !config.error; i++) {
         if (argv[i][0] == '-') {
             // Language specification
             if (strcmp(argv[i], "--c-code") == 0) {
@@ -50,13 +50,86 @@ CompilerConfig parse_arguments(int argc, char** argv) {
                 config.c_mode = false;
             }
             // Folder mode
-            else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
-                config.folder_mode = true;
-                config.folder_path = argv[++i];
+            else if (strcmp(argv[i], "-f") == 0) {
+                if (i + 1 >= argc) {
+                    config.error = "-f requires a folder";
+                } else {
+                    config.folder_mode = true;
+                    config.folder_path = argv[++i];
+                }
             }
             // Output file
-            else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
-                config.output_file = argv[++i];
+            else if (strcmp(argv[i], "-o") == 0) {
+                if (i + 1 >= argc) {
+                    config.error = "-o requires output filename";
+                } else {
+                    config.output_file = argv[++i];
+                }
+            }
+            // Threads for folder builds, multiple inputs and --inspect
+            else if (strncmp(argv[i], "-j", 2) == 0) {
+                if (!parse_jobs(argc, argv, &i, &config.jobs)) {
+                    config.error = "-j requires a thread count";
+                }
+            }
+            // Link passes
+            else if (strcmp(argv[i], "--icf") == 0) {
+                config.icf = true;
+            }
+            else if (strcmp(argv[i], "--gc-sections") == 0) {
+                config.gc_sections = true;
+            }
+            // Batches of files compiled as one object in folder builds
+            else if (strcmp(argv[i], "--unity") == 0) {
+                config.unity = ECLC_UNITY_DEFAULT;
+            }
+            else if (strncmp(argv[i], "--unity=", 8) == 0) {
+                char* end;
+                long n = strtol(argv[i] + 8, &end, 10);
+                if (end == argv[i] + 8 || *end != '\0' || n < 1 || n > 4096) {
+                    config.error = "--unity needs a batch size between 1 and 4096";
+                } else {
+                    config.unity = (int)n;
+                }
+            }
+            // Skip the shared build cache
+            else if (strcmp(argv[i], "--no-cache") == 0) {
+                config.no_cache = true;
+            }
+            // Interpret the program here instead of compiling it
+            else if (strcmp(argv[i], "--run") == 0) {
+                config.run = true;
+            }
+            // Validate existing FCEF files
+            else if (strcmp(argv[i], "--inspect") == 0) {
+                config.inspect = true;
+            }
+            else if (strcmp(argv[i], "--json") == 0) {
+                config.json = true;
+            }
+            // Where compile time goes, as a table or JSON on stderr
+            else if (strcmp(argv[i], "--time-report") == 0) {
+                config.time_report = true;
+            }
+            else if (strcmp(argv[i], "--time-report=json") == 0) {
+                config.time_report = true;
+                config.time_report_json = true;
+            }
+            // Allocations per phase and peak memory
+            else if (strcmp(argv[i], "--mem-report") == 0) {
+                config.mem_report = true;
+            }
+            else if (strcmp(argv[i], "--mem-report=json") == 0) {
+                config.mem_report = true;
+                config.mem_report_json = true;
+            }
+            // Chrome trace-event timeline of every phase of every file
+            else if (strncmp(argv[i], "--trace=", 8) == 0) {
+                if (argv[i][8] == '\0') {
+                    config.error = "--trace requires a file name";
+                } else {
+                    config.trace_path = argv[i] + 8;
+                }
             }
             // Optimization levels
             else if (strncmp(argv[i], "-O", 2) == 0) {
@@ -75,8 +148,8 @@ CompilerConfig parse_arguments(int argc, char** argv) {
             }
         } else {
             // Input file
-            config.input_files = realloc(config.input_files, 
-                                       (config.file_count + 1) * sizeof(char*));
+            config.input_files = xrealloc(config.input_files, 
+                                          (config.file_count + 1) * sizeof(char*));
             config.input_files[config.file_count++] = argv[i];
         }
     }
@@ -84,17 +157,40 @@ CompilerConfig parse_arguments(int argc, char** argv) {
     return config;
 }
 
-void print_help() {
+void free_config(CompilerConfig* config) {
+    xfree(config->input_files);
+    config->input_files = NULL;
+    config->file_count = 0;
+}
+
+void print_help(void) {
     printf("ECLC - E-comOS C/C++ Compiler\n\n");
     printf("Usage: eclc [options] <file1> [file2 ...]\n\n");
     printf("Basic Usage:\n");
     printf("  eclc hello.c                 # Compile C file\n");
     printf("  eclc hello.cpp              # Compile C++ file\n");
     printf("  eclc -f project/src         # Compile folder\n");
-    printf("  eclc main.c -o myapp        # Specify output\n\n");
+    printf("  eclc main.c -o myapp        # Specify output\n");
+    printf("  eclc a.c b.c c.c            # Compile each file to its own .fcef\n");
+    printf("  eclc a.c b.c -o app         # Compile and link into one executable\n\n");
+    printf("Build Options:\n");
+    printf("  -j N                        # Threads (default: one per CPU)\n");
+    printf("  --icf                       # Fold identical functions when linking\n");
+    printf("  --gc-sections               # Drop unreachable code when linking\n");
+    printf("  --unity[=N]                 # With -f, compile about N files as one unit (default %d)\n",
+           ECLC_UNITY_DEFAULT);
+    printf("  --no-cache                  # Don't use the build cache\n");
+    printf("  --time-report[=json]        # Time spent in each compiler phase\n");
+    printf("  --mem-report[=json]         # Allocations and peak memory per phase\n");
+    printf("  --trace=<file>              # Timeline for chrome://tracing or Perfetto\n\n");
     printf("Language Options:\n");
     printf("  --c-code                    # Force C mode\n");
     printf("  --cpp-code                  # Force C++ mode\n");
     printf("  (Usually auto-detected from file extension)\n\n");
+    printf("Other Modes:\n");
+    printf("  eclc --run <file>... | -f <folder>      # Run main() here, exit with its value\n");
+    printf("  eclc --inspect [--json] <file|dir>...   # Check FCEF files\n");
+    printf("  eclc --server [socket]                  # Run a compile server\n");
+    printf("  eclc --client <command>...              # Send a command to it\n\n");
     printf("Full help: eclc --help\n");
-}
\ No newline at end of file
+}
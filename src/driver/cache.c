@@ -0,0 +1,439 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/cache.h"
+#include "eclc/hash.h"
+#include "eclc/profile.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+// Entries live in <dir>/<first two hex digits of the key>/<rest>.fcef,
+// next to <dir>/stats which holds the total size under an flock(). The
+// mtime of <entry>.used, touched on every hit, is when an entry was last
+// used; entries never hit yet count from when they were stored.
+#define CACHE_STATS_FILE   "stats"
+#define CACHE_USED_SUFFIX  ".used"
+#define CACHE_EVICT_TO     90          // Percent of the limit left after eviction
+#define CACHE_TMP_MAX_AGE  3600        // Seconds before a crashed write's temp file goes
+
+struct ObjectCache {
+    char* dir;
+    u64 max_size;
+    u64 compiler;               // Identity of the running compiler
+    u64 added;                  // Bytes stored by this process (atomic)
+    CacheStats stats;           // Atomic counters
+};
+
+typedef struct {
+    char* path;
+    int64_t mtime_ns;
+    u64 size;
+} CacheEntry;
+
+static char* path_join(const char* dir, const char* name) {
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    char* path = xmalloc(dir_len + name_len + 2);
+    memcpy(path, dir, dir_len);
+    path[dir_len] = '/';
+    memcpy(path + dir_len + 1, name, name_len + 1);
+    return path;
+}
+
+// mkdir -p
+static bool make_dirs(const char* path) {
+    char* copy = xstrdup(path);
+    bool ok = true;
+    for (char* p = copy + 1; ok; p++) {
+        if (*p != '/' && *p != '\0') continue;
+        char c = *p;
+        *p = '\0';
+        ok = mkdir(copy, 0777) == 0 || errno == EEXIST;
+        *p = c;
+        if (c == '\0') break;
+    }
+    xfree(copy);
+    return ok;
+}
+
+static char* cache_dir(void) {
+    const char* dir = getenv("ECLC_CACHE_DIR");
+    if (dir && *dir) return xstrdup(dir);
+    const char* base = getenv("XDG_CACHE_HOME");
+    if (base && *base) return path_join(base, "eclc");
+    const char* home = getenv("HOME");
+    if (home && *home) return path_join(home, ".cache/eclc");
+    return NULL;
+}
+
+// "512M", "2G", "1048576"; `fallback` when unset or malformed
+static u64 parse_size(const char* text, u64 fallback) {
+    if (!text || !*text) return fallback;
+    char* end;
+    unsigned long long n = strtoull(text, &end, 10);
+    if (end == text) return fallback;
+    switch (*end) {
+        case 'k': case 'K': n <<= 10; end++; break;
+        case 'm': case 'M': n <<= 20; end++; break;
+        case 'g': case 'G': n <<= 30; end++; break;
+        default: break;
+    }
+    return *end == '\0' ? (u64)n : fallback;
+}
+
+// Hash of the compiler binary, so a rebuilt eclc never reuses objects
+// from an older one. Where the binary can't be read the object format
+// version and the build time of this file stand in. The binary doesn't
+// change while it runs, so it is hashed once per process.
+static u64 identity;
+static pthread_once_t identity_once = PTHREAD_ONCE_INIT;
+
+static void hash_compiler(void) {
+    u64 h = eclc_hash_combine(0, ECLC_OBJECT_VERSION);
+    int fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        const char* built = __DATE__ " " __TIME__;
+        identity = eclc_hash64(built, strlen(built), h);
+        return;
+    }
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR)) {
+        if (n > 0) h = eclc_hash_combine(h, eclc_hash64(buf, (size_t)n, 0));
+    }
+    close(fd);
+    identity = h;
+}
+
+static u64 compiler_identity(void) {
+    pthread_once(&identity_once, hash_compiler);
+    return identity;
+}
+
+ObjectCache* cache_open(void) {
+    u64 max_size = parse_size(getenv("ECLC_CACHE_SIZE"), ECLC_CACHE_SIZE_DEFAULT);
+    char* dir = max_size ? cache_dir() : NULL;
+    ObjectCache* cache = dir ? cache_open_at(dir, max_size, compiler_identity()) : NULL;
+    xfree(dir);
+    return cache;
+}
+
+ObjectCache* cache_open_at(const char* dir, u64 max_size, u64 compiler) {
+    if (!make_dirs(dir)) {
+        return NULL;
+    }
+    ObjectCache* cache = xcalloc(1, sizeof(ObjectCache));
+    cache->dir = xstrdup(dir);
+    cache->max_size = max_size;
+    cache->compiler = compiler;
+    return cache;
+}
+
+static char* entry_path(const ObjectCache* cache, const CacheKey* key) {
+    char name[48];
+    snprintf(name, sizeof(name), "%02x/%014" PRIx64 "%016" PRIx64 ".fcef",
+             (unsigned)(key->hi >> 56), (uint64_t)(key->hi & 0x00FFFFFFFFFFFFFFull),
+             (uint64_t)key->lo);
+    return path_join(cache->dir, name);
+}
+
+// Unique name next to `path` for writing before the final rename
+static char* temp_path(const char* path) {
+    static unsigned long counter;
+    size_t size = strlen(path) + 48;
+    char* tmp = xmalloc(size);
+    snprintf(tmp, size, "%s.%ld.%lu.tmp", path, (long)getpid(),
+             __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED));
+    return tmp;
+}
+
+static bool has_suffix(const char* s, const char* suffix) {
+    size_t len = strlen(s);
+    size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+CacheKey cache_key(ObjectCache* cache, const char* source, const char* path,
+                   const ManifestDep* deps, size_t dep_count, u64 flags) {
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_CACHE);
+    // The extension picks the language unless a flag forces it
+    const char* slash = strrchr(path, '/');
+    const char* dot = strrchr(path, '.');
+    const char* ext = dot && (!slash || dot > slash) ? dot : "";
+    
+    u64 h = eclc_hash_combine(cache->compiler, flags);
+    h = eclc_hash_combine(h, eclc_hash64(ext, strlen(ext), 0));
+    for (size_t i = 0; i < dep_count; i++) {
+        h = eclc_hash_combine(h, deps[i].stamp.hash);
+    }
+    h = eclc_hash_combine(h, dep_count);
+    
+    size_t len = strlen(source);
+    CacheKey key;
+    key.hi = eclc_hash64(source, len, h);
+    key.lo = eclc_hash64(source, len, eclc_hash_combine(h, key.hi));
+    phase_leave(&scope);
+    return key;
+}
+
+static bool copy_fd(int in, int out) {
+    char buf[65536];
+    for (;;) {
+        ssize_t n = read(in, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return n == 0;
+        for (ssize_t done = 0; done < n;) {
+            ssize_t w = write(out, buf + done, (size_t)(n - done));
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) return false;
+            done += w;
+        }
+    }
+}
+
+static void count(size_t* counter) {
+    __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+}
+
+// Mark an entry as just used
+static void touch_used(const char* entry) {
+    char* used = xmalloc(strlen(entry) + sizeof(CACHE_USED_SUFFIX));
+    strcpy(used, entry);
+    strcat(used, CACHE_USED_SUFFIX);
+    if (utimensat(AT_FDCWD, used, NULL, 0) != 0 && errno == ENOENT) {
+        int fd = open(used, O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+        if (fd >= 0) close(fd);
+    }
+    xfree(used);
+}
+
+bool cache_fetch(ObjectCache* cache, const CacheKey* key, const char* dest) {
+    if (!cache) return false;
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_CACHE);
+    char* entry = entry_path(cache, key);
+    int in = open(entry, O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        count(&cache->stats.misses);
+        xfree(entry);
+        phase_leave(&scope);
+        return false;
+    }
+    
+    // Build the copy under a temporary name so `dest` is replaced in one
+    // step. Never a hardlink: the output must be a file of its own that
+    // the build can stamp, touch or rewrite without reaching the cache.
+    char* tmp = temp_path(dest);
+    int out = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    bool placed = false;
+#ifdef FICLONE
+    placed = out >= 0 && ioctl(out, FICLONE, in) == 0;
+#endif
+    if (!placed && out >= 0) {
+        placed = copy_fd(in, out);
+    }
+    if (out >= 0 && close(out) != 0) placed = false;
+    if (!placed && out >= 0) unlink(tmp);
+    if (placed && rename(tmp, dest) != 0) {
+        unlink(tmp);
+        placed = false;
+    }
+    if (placed) {
+        touch_used(entry);
+        count(&cache->stats.hits);
+    } else {
+        count(&cache->stats.misses);
+    }
+    close(in);
+    xfree(tmp);
+    xfree(entry);
+    phase_leave(&scope);
+    return placed;
+}
+
+eclc_output_t* cache_load(ObjectCache* cache, const CacheKey* key) {
+    if (!cache) return NULL;
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_CACHE);
+    char* entry = entry_path(cache, key);
+    eclc_output_t* object = access(entry, F_OK) == 0 ? eclc_load_fcef(entry) : NULL;
+    if (object) {
+        touch_used(entry);
+        count(&cache->stats.hits);
+    } else {
+        count(&cache->stats.misses);
+    }
+    xfree(entry);
+    phase_leave(&scope);
+    return object;
+}
+
+bool cache_store(ObjectCache* cache, const CacheKey* key, const eclc_output_t* object) {
+    if (!cache) return false;
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_CACHE);
+    char* entry = entry_path(cache, key);
+    char* shard = xstrdup(entry);
+    *strrchr(shard, '/') = '\0';
+    
+    // Read-only: an entry never changes once it is stored
+    struct stat st;
+    bool stored = (mkdir(shard, 0777) == 0 || errno == EEXIST) &&
+                  eclc_save_fcef(object, entry) && chmod(entry, 0444) == 0 &&
+                  stat(entry, &st) == 0;
+    if (stored) {
+        __atomic_add_fetch(&cache->added, (u64)st.st_size, __ATOMIC_RELAXED);
+        count(&cache->stats.stores);
+    }
+    xfree(shard);
+    xfree(entry);
+    phase_leave(&scope);
+    return stored;
+}
+
+void cache_stats(const ObjectCache* cache, CacheStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (cache) {
+        stats->hits = __atomic_load_n(&cache->stats.hits, __ATOMIC_RELAXED);
+        stats->misses = __atomic_load_n(&cache->stats.misses, __ATOMIC_RELAXED);
+        stats->stores = __atomic_load_n(&cache->stats.stores, __ATOMIC_RELAXED);
+    }
+}
+
+static int compare_age(const void* a, const void* b) {
+    const CacheEntry* x = a;
+    const CacheEntry* y = b;
+    if (x->mtime_ns != y->mtime_ns) return x->mtime_ns < y->mtime_ns ? -1 : 1;
+    return strcmp(x->path, y->path);
+}
+
+// Delete the least recently used entries until at most `target` bytes
+// remain, along with temp files left by crashed writers. Returns the size
+// actually left.
+static u64 evict(const ObjectCache* cache, u64 target) {
+    CacheEntry* entries = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    u64 total = 0;
+    time_t now = time(NULL);
+    
+    for (int i = 0; i < 256; i++) {
+        char name[4];
+        snprintf(name, sizeof(name), "%02x", i);
+        char* shard = path_join(cache->dir, name);
+        DIR* dir = opendir(shard);
+        struct dirent* ent;
+        while (dir && (ent = readdir(dir)) != NULL) {
+            struct stat st;
+            if (ent->d_name[0] == '.' || fstatat(dirfd(dir), ent->d_name, &st, 0) != 0 ||
+                !S_ISREG(st.st_mode)) {
+                continue;
+            }
+            if (has_suffix(ent->d_name, ".tmp")) {
+                if (now - st.st_mtime > CACHE_TMP_MAX_AGE) {
+                    unlinkat(dirfd(dir), ent->d_name, 0);
+                }
+                continue;
+            }
+            if (has_suffix(ent->d_name, CACHE_USED_SUFFIX)) {
+                // Drop the mark of an entry another process evicted
+                char entry[NAME_MAX + 1];
+                size_t len = strlen(ent->d_name) - strlen(CACHE_USED_SUFFIX);
+                memcpy(entry, ent->d_name, len);
+                entry[len] = '\0';
+                if (faccessat(dirfd(dir), entry, F_OK, 0) != 0 && errno == ENOENT) {
+                    unlinkat(dirfd(dir), ent->d_name, 0);
+                }
+                continue;
+            }
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 256;
+                entries = xrealloc(entries, capacity * sizeof(CacheEntry));
+            }
+            entries[count].path = path_join(shard, ent->d_name);
+            entries[count].mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+            entries[count].size = (u64)st.st_size;
+            char used[NAME_MAX + sizeof(CACHE_USED_SUFFIX)];
+            snprintf(used, sizeof(used), "%s" CACHE_USED_SUFFIX, ent->d_name);
+            if (fstatat(dirfd(dir), used, &st, 0) == 0) {
+                int64_t used_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+                if (used_ns > entries[count].mtime_ns) entries[count].mtime_ns = used_ns;
+            }
+            total += entries[count].size;
+            count++;
+        }
+        if (dir) closedir(dir);
+        xfree(shard);
+    }
+    
+    qsort(entries, count, sizeof(CacheEntry), compare_age);
+    for (size_t i = 0; i < count; i++) {
+        if (total > target && unlink(entries[i].path) == 0) {
+            total -= entries[i].size;
+            char* used = xmalloc(strlen(entries[i].path) + sizeof(CACHE_USED_SUFFIX));
+            strcpy(used, entries[i].path);
+            strcat(used, CACHE_USED_SUFFIX);
+            unlink(used);
+            xfree(used);
+        }
+        xfree(entries[i].path);
+    }
+    xfree(entries);
+    return total;
+}
+
+void cache_close(ObjectCache* cache) {
+    if (!cache) return;
+    u64 added = __atomic_load_n(&cache->added, __ATOMIC_RELAXED);
+    char* stats_path = path_join(cache->dir, CACHE_STATS_FILE);
+    int fd = added ? open(stats_path, O_RDWR | O_CREAT | O_CLOEXEC, 0666) : -1;
+    if (fd >= 0 && flock(fd, LOCK_EX) == 0) {
+        // One process at a time updates the total and evicts
+        char buf[32];
+        ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+        buf[n > 0 ? n : 0] = '\0';
+        u64 total = strtoull(buf, NULL, 10) + added;
+        if (total > cache->max_size) {
+            total = evict(cache, cache->max_size / 100 * CACHE_EVICT_TO);
+        }
+        int len = snprintf(buf, sizeof(buf), "%" PRIu64 "\n", total);
+        if (ftruncate(fd, 0) == 0 && pwrite(fd, buf, (size_t)len, 0) != len) {
+            ftruncate(fd, 0);       // Recounted by the next eviction
+        }
+        flock(fd, LOCK_UN);
+    }
+    if (fd >= 0) close(fd);
+    xfree(stats_path);
+    xfree(cache->dir);
+    xfree(cache);
+}
@@ -0,0 +1,474 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/fileio.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#ifdef IORING_FEAT_NATIVE_WORKERS  // 5.12 headers, which have every opcode used here
+#define FILEIO_URING 1
+#endif
+#endif
+#endif
+
+static char* temp_name(const char* path) {
+    static unsigned long counter;
+    size_t size = strlen(path) + 48;
+    char* tmp = xmalloc(size);
+    snprintf(tmp, size, "%s.%ld.%lu.tmp", path, (long)getpid(),
+             __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED));
+    return tmp;
+}
+
+static void read_sync(FileRead* file) {
+    file->data = NULL;
+    file->size = 0;
+    int fd = open(file->path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        file->error = errno;
+        if (fd >= 0) close(fd);
+        return;
+    }
+    size_t capacity = (size_t)st.st_size + 1;
+    char* data = xmalloc(capacity);
+    size_t size = 0;
+    for (;;) {
+        if (size + 1 == capacity) {
+            capacity *= 2;      // Grew since the fstat()
+            data = xrealloc(data, capacity);
+        }
+        ssize_t n = read(fd, data + size, capacity - 1 - size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            file->error = errno;
+            close(fd);
+            xfree(data);
+            return;
+        }
+        if (n == 0) break;
+        size += (size_t)n;
+    }
+    close(fd);
+    data[size] = '\0';
+    file->data = data;
+    file->size = size;
+    file->error = 0;
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static void write_sync(FileWrite* file) {
+    char* tmp = temp_name(file->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    bool ok = fd >= 0 && write_all(fd, file->data, file->size);
+    file->error = ok ? 0 : errno;
+    if (fd >= 0 && close(fd) != 0 && ok) {
+        ok = false;
+        file->error = errno;
+    }
+    if (ok && rename(tmp, file->path) != 0) {
+        ok = false;
+        file->error = errno;
+    }
+    if (!ok && fd >= 0) {
+        unlink(tmp);
+    }
+    xfree(tmp);
+}
+
+#ifdef FILEIO_URING
+typedef struct {
+    int fd;                     // -1 when this thread has no ring
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    unsigned tail;              // Next SQE to fill
+    uint8_t* buffers;           // FILEIO_BATCH registered slots
+} Ring;
+
+// Several ops per file (open, read or write, close, rename), each posted once
+#define RING_ENTRIES (FILEIO_BATCH * 4)
+
+// Ops chained per file are told apart in user_data
+enum { OP_OPEN, OP_DATA, OP_CLOSE, OP_RENAME, OP_COUNT };
+
+static __thread Ring ring = { .fd = -2 };   // -2 = not set up yet
+static pthread_key_t ring_key;
+static pthread_once_t ring_once = PTHREAD_ONCE_INIT;
+
+static void ring_unmap(Ring* r) {
+    if (r->buffers) munmap(r->buffers, FILEIO_BATCH * FILEIO_SLOT);
+    if (r->sqes) munmap(r->sqes, r->sqes_size);
+    if (r->cq_ring && r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_ring_size);
+    if (r->sq_ring) munmap(r->sq_ring, r->sq_ring_size);
+    if (r->fd >= 0) close(r->fd);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+// Thread exit
+static void ring_free(void* arg) {
+    ring_unmap(arg);
+}
+
+static void make_ring_key(void) {
+    pthread_key_create(&ring_key, ring_free);
+}
+
+static bool ops_supported(int fd) {
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = xcalloc(1, size);
+    bool ok = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    static const int needed[] = {
+        IORING_OP_OPENAT, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED,
+        IORING_OP_WRITE, IORING_OP_CLOSE, IORING_OP_RENAMEAT,
+    };
+    for (size_t i = 0; ok && i < sizeof(needed) / sizeof(needed[0]); i++) {
+        ok = needed[i] <= probe->last_op && (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    xfree(probe);
+    return ok;
+}
+
+static bool ring_setup(Ring* r) {
+    memset(r, 0, sizeof(*r));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    r->fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (r->fd < 0 || !ops_supported(r->fd)) {
+        return false;
+    }
+    
+    r->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    r->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single && r->cq_ring_size > r->sq_ring_size) {
+        r->sq_ring_size = r->cq_ring_size;
+    }
+    r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ring == MAP_FAILED) {
+        r->sq_ring = NULL;
+        return false;
+    }
+    r->cq_ring = single ? r->sq_ring
+                        : mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+    if (r->cq_ring == MAP_FAILED) {
+        r->cq_ring = NULL;
+        return false;
+    }
+    r->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        r->sqes = NULL;
+        return false;
+    }
+    
+    uint8_t* sq = r->sq_ring;
+    uint8_t* cq = r->cq_ring;
+    r->sq_head = (unsigned*)(sq + params.sq_off.head);
+    r->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    r->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + params.sq_off.array);
+    r->cq_head = (unsigned*)(cq + params.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    r->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    r->tail = *r->sq_tail;
+    
+    // Pinned once, so reads and writes skip mapping the pages per call
+    r->buffers = mmap(NULL, FILEIO_BATCH * FILEIO_SLOT, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (r->buffers == MAP_FAILED) {
+        r->buffers = NULL;
+        return false;
+    }
+    struct iovec slots[FILEIO_BATCH];
+    for (int i = 0; i < FILEIO_BATCH; i++) {
+        slots[i].iov_base = r->buffers + (size_t)i * FILEIO_SLOT;
+        slots[i].iov_len = FILEIO_SLOT;
+    }
+    return syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_BUFFERS,
+                   slots, FILEIO_BATCH) == 0;
+}
+
+static Ring* thread_ring(void) {
+    if (ring.fd == -2) {
+        const char* env = getenv("ECLC_IO_URING");
+        if (env && strcmp(env, "0") == 0) {
+            ring.fd = -1;
+        } else if (!ring_setup(&ring)) {
+            ring_unmap(&ring);
+        } else {
+            pthread_once(&ring_once, make_ring_key);
+            pthread_setspecific(ring_key, &ring);
+        }
+    }
+    return ring.fd >= 0 ? &ring : NULL;
+}
+
+static struct io_uring_sqe* ring_sqe(Ring* r, int op, size_t file, unsigned flags) {
+    unsigned index = r->tail++ & r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->flags = (uint8_t)flags;
+    sqe->user_data = (uint64_t)file * OP_COUNT + (uint64_t)op;
+    r->sq_array[index] = index;
+    return sqe;
+}
+
+// Submit what was queued and wait for all of it. results[file][op] gets
+// each completion; false if the ring broke, leaving the rest unset.
+static bool ring_run(Ring* r, int results[][OP_COUNT]) {
+    __atomic_store_n(r->sq_tail, r->tail, __ATOMIC_RELEASE);
+    unsigned outstanding = r->tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    while (outstanding > 0) {
+        unsigned submit = r->tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+        long n = syscall(__NR_io_uring_enter, r->fd, submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            return false;
+        }
+        unsigned head = *r->cq_head;
+        unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail && outstanding > 0; head++, outstanding--) {
+            const struct io_uring_cqe* cqe = &r->cqes[head & r->cq_mask];
+            results[cqe->user_data / OP_COUNT][cqe->user_data % OP_COUNT] = cqe->res;
+        }
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+static void reset_results(int results[][OP_COUNT], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            results[i][op] = -ECANCELED;
+        }
+    }
+}
+
+// Round 1 opens the whole batch; round 2 reads each file into its slot
+// with the close hard-linked behind the read, since reading less than the
+// slot holds counts as a failure that would cancel a plain link
+static bool read_batch(Ring* r, FileRead* files, size_t count) {
+    int results[FILEIO_BATCH][OP_COUNT];
+    reset_results(results, count);
+    for (size_t i = 0; i < count; i++) {
+        struct io_uring_sqe* sqe = ring_sqe(r, OP_OPEN, i, 0);
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uintptr_t)files[i].path;
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    }
+    bool ran = ring_run(r, results);
+    
+    for (size_t i = 0; ran && i < count; i++) {
+        int fd = results[i][OP_OPEN];
+        if (fd < 0) continue;
+        struct io_uring_sqe* sqe = ring_sqe(r, OP_DATA, i, IOSQE_IO_HARDLINK);
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = fd;
+        sqe->addr = (uintptr_t)(r->buffers + i * FILEIO_SLOT);
+        sqe->len = FILEIO_SLOT;
+        sqe->buf_index = (uint16_t)i;
+        sqe = ring_sqe(r, OP_CLOSE, i, 0);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fd;
+    }
+    ran = ran && ring_run(r, results);
+    
+    for (size_t i = 0; i < count; i++) {
+        FileRead* file = &files[i];
+        int fd = results[i][OP_OPEN];
+        int size = results[i][OP_DATA];
+        if (fd >= 0 && results[i][OP_CLOSE] == -ECANCELED) {
+            close(fd);          // The ring broke before the close ran
+        }
+        if (!ran || size == FILEIO_SLOT) {
+            read_sync(file);    // The ring broke, or the file is too large for a slot
+        } else if (fd < 0 || size < 0) {
+            file->data = NULL;
+            file->size = 0;
+            file->error = fd < 0 ? -fd : -size;
+        } else {
+            file->data = xmalloc((size_t)size + 1);
+            memcpy(file->data, r->buffers + i * FILEIO_SLOT, (size_t)size);
+            file->data[size] = '\0';
+            file->size = (size_t)size;
+            file->error = 0;
+        }
+    }
+    return ran;
+}
+
+// Round 1 creates the temporary files; round 2 chains write, close and
+// rename per file, so a failed or short write never replaces the file.
+// Data that doesn't fit a slot is written straight from the caller.
+static bool write_batch(Ring* r, FileWrite* files, size_t count) {
+    int results[FILEIO_BATCH][OP_COUNT];
+    char* temps[FILEIO_BATCH];
+    reset_results(results, count);
+    for (size_t i = 0; i < count; i++) {
+        temps[i] = temp_name(files[i].path);
+        struct io_uring_sqe* sqe = ring_sqe(r, OP_OPEN, i, 0);
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uintptr_t)temps[i];
+        sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        sqe->len = 0666;
+    }
+    bool ran = ring_run(r, results);
+    
+    for (size_t i = 0; ran && i < count; i++) {
+        const FileWrite* file = &files[i];
+        int fd = results[i][OP_OPEN];
+        if (fd < 0) continue;
+        struct io_uring_sqe* sqe = ring_sqe(r, OP_DATA, i, IOSQE_IO_LINK);
+        sqe->fd = fd;
+        sqe->len = (unsigned)file->size;
+        if (file->size <= FILEIO_SLOT) {
+            memcpy(r->buffers + i * FILEIO_SLOT, file->data, file->size);
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->addr = (uintptr_t)(r->buffers + i * FILEIO_SLOT);
+            sqe->buf_index = (uint16_t)i;
+        } else {
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->addr = (uintptr_t)file->data;
+        }
+        sqe = ring_sqe(r, OP_CLOSE, i, IOSQE_IO_LINK);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fd;
+        sqe = ring_sqe(r, OP_RENAME, i, 0);
+        sqe->opcode = IORING_OP_RENAMEAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uintptr_t)temps[i];
+        sqe->len = (unsigned)AT_FDCWD;
+        sqe->addr2 = (uintptr_t)file->path;
+    }
+    ran = ran && ring_run(r, results);
+    
+    for (size_t i = 0; i < count; i++) {
+        FileWrite* file = &files[i];
+        int fd = results[i][OP_OPEN];
+        int written = results[i][OP_DATA];
+        int closed = results[i][OP_CLOSE];
+        if (fd >= 0 && closed == -ECANCELED) {
+            close(fd);          // Cancelled by a failed write
+        }
+        if (results[i][OP_RENAME] == 0) {
+            file->error = 0;
+            xfree(temps[i]);
+            continue;
+        }
+        if (fd >= 0) {
+            unlink(temps[i]);
+        }
+        if (!ran) {
+            write_sync(file);
+        } else if (fd < 0) {
+            file->error = -fd;
+        } else if (written < 0) {
+            file->error = -written;
+        } else if ((size_t)written != file->size) {
+            file->error = EIO;
+        } else if (closed < 0) {
+            file->error = -closed;
+        } else {
+            file->error = -results[i][OP_RENAME];
+        }
+        xfree(temps[i]);
+    }
+    return ran;
+}
+#endif
+
+void fileio_read(FileRead* files, size_t count) {
+    size_t done = 0;
+#ifdef FILEIO_URING
+    Ring* r;
+    while (done < count && (r = thread_ring()) != NULL) {
+        size_t batch = count - done < FILEIO_BATCH ? count - done : FILEIO_BATCH;
+        if (!read_batch(r, files + done, batch)) {
+            ring_unmap(r);      // The rest goes through plain syscalls
+        }
+        done += batch;
+    }
+#endif
+    for (; done < count; done++) {
+        read_sync(&files[done]);
+    }
+}
+
+void fileio_write(FileWrite* files, size_t count) {
+    size_t done = 0;
+#ifdef FILEIO_URING
+    Ring* r;
+    while (done < count && (r = thread_ring()) != NULL) {
+        size_t batch = count - done < FILEIO_BATCH ? count - done : FILEIO_BATCH;
+        if (!write_batch(r, files + done, batch)) {
+            ring_unmap(r);
+        }
+        done += batch;
+    }
+#endif
+    for (; done < count; done++) {
+        write_sync(&files[done]);
+    }
+}
+
+bool fileio_uring(void) {
+#ifdef FILEIO_URING
+    return thread_ring() != NULL;
+#else
+    return false;
+#endif
+}
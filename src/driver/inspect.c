@@ -0,0 +1,276 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/inspect.h"
+#include "eclc/pool.h"
+#include "eclc/scan.h"
+#include "fcef/eclc_fcef.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    char** items;
+    size_t count;
+    size_t capacity;
+} PathList;
+
+typedef struct {
+    const char* path;
+    size_t size;
+    int error;                  // errno when the file could not be mapped
+    eclc_fcef_status_t status;
+    uint16_t version_major;
+    uint16_t version_minor;
+    uint32_t crc;               // Stored checksum, 0 when the file has none
+    fcef_layout_t layout;
+    uint32_t symbols;
+    uint32_t relocs;
+} InspectResult;
+
+static void path_add(PathList* list, const char* path) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->items = xrealloc(list->items, list->capacity * sizeof(char*));
+    }
+    list->items[list->count++] = xstrdup(path);
+}
+
+static bool is_fcef_file(const char* name) {
+    const char* ext = strrchr(name, '.');
+    return ext && strcmp(ext, ".fcef") == 0;
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void found_fcef(void* ctx, const char* name, const char* path) {
+    (void)name;
+    path_add(ctx, path);
+}
+
+// Files named on the command line are checked whatever their extension
+static void collect(PathList* list, const char* path) {
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        // Walked like folder builds: hidden entries and .eclcignore matches
+        // are skipped, and symlinks are never followed into directories
+        size_t first = list->count;
+        if (!scan_files(path, is_fcef_file, found_fcef, list, NULL)) {
+            path_add(list, path);   // Reported as unreadable
+        }
+        qsort(list->items + first, list->count - first, sizeof(char*), compare_paths);
+    } else {
+        path_add(list, path);
+    }
+}
+
+static void inspect_image(InspectResult* r, const uint8_t* data, size_t size) {
+    r->status = eclc_fcef_verify(data, size, &r->layout);
+    if (r->status == ECLC_FCEF_TRUNCATED) {
+        return;
+    }
+
+    const fcef_header_t* header = (const fcef_header_t*)data;
+    r->version_major = header->version_major;
+    r->version_minor = header->version_minor;
+    r->crc = header->crc32;
+    fcef_link_header_t link;
+    if (r->status == ECLC_FCEF_OK && eclc_fcef_link_header(data, size, &r->layout, &link)) {
+        r->symbols = link.symbol_count ? link.symbol_count - 1 : 0;
+        r->relocs = link.reloc_count;
+    }
+}
+
+static void inspect_file(void* ctx, size_t i) {
+    InspectResult* r = &((InspectResult*)ctx)[i];
+
+    int fd = open(r->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        r->error = errno;
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        r->error = errno;
+        close(fd);
+        return;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        r->error = S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+        close(fd);
+        return;
+    }
+
+    r->size = (size_t)st.st_size;
+    if (r->size < sizeof(fcef_header_t)) {
+        r->status = ECLC_FCEF_TRUNCATED;
+        close(fd);
+        return;
+    }
+
+    // Mapping avoids a copy; the CRC pass then reads the page cache directly
+    void* data = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        r->error = errno;
+        return;
+    }
+    madvise(data, r->size, MADV_SEQUENTIAL);
+    inspect_image(r, data, r->size);
+    munmap(data, r->size);
+}
+
+static bool result_ok(const InspectResult* r) {
+    return r->error == 0 && r->status == ECLC_FCEF_OK;
+}
+
+static const char* result_message(const InspectResult* r) {
+    return r->error ? strerror(r->error) : eclc_fcef_status_string(r->status);
+}
+
+static void print_json_string(const char* s) {
+    putchar('"');
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            putchar('\\');
+            putchar(*p);
+        } else if (*p < 0x20) {
+            printf("\\u%04x", *p);
+        } else {
+            putchar(*p);
+        }
+    }
+    putchar('"');
+}
+
+static void print_json(const InspectResult* r) {
+    printf("{\"file\":");
+    print_json_string(r->path);
+    printf(",\"size\":%zu,\"valid\":%s,\"status\":", r->size, result_ok(r) ? "true" : "false");
+    print_json_string(result_message(r));
+    if (r->error == 0 && r->status != ECLC_FCEF_TRUNCATED) {
+        const fcef_layout_t* l = &r->layout;
+        printf(",\"version\":\"%u.%u\",\"crc32\":%u,\"entry\":%u,"
+               "\"text\":{\"addr\":%u,\"size\":%u},\"rodata\":{\"size\":%u},"
+               "\"data\":{\"addr\":%u,\"size\":%u},\"bss\":{\"size\":%u},"
+               "\"symbols\":%u,\"relocs\":%u",
+               r->version_major, r->version_minor, r->crc, l->entry_point,
+               l->text_addr, l->code_size, l->rodata_size,
+               l->data_addr, l->data_size, l->bss_size, r->symbols, r->relocs);
+    }
+    printf("}\n");
+}
+
+static void print_table_header(void) {
+    printf("%-22s %8s %4s %-10s %-18s %7s %-18s %7s %5s %6s %-8s %s\n",
+           "STATUS", "SIZE", "VER", "ENTRY", "TEXT", "RODATA", "DATA", "BSS",
+           "SYMS", "RELOCS", "CRC", "FILE");
+}
+
+static void print_row(const InspectResult* r) {
+    const char* color = result_ok(r) ? "\033[32m" : "\033[31m";
+    printf("%s%-22.22s\033[0m %8zu ", color, result_message(r), r->size);
+    if (r->error || r->status == ECLC_FCEF_TRUNCATED) {
+        printf("%4s %-10s %-18s %7s %-18s %7s %5s %6s %-8s %s\n",
+               "-", "-", "-", "-", "-", "-", "-", "-", "-", r->path);
+        return;
+    }
+
+    const fcef_layout_t* l = &r->layout;
+    char text[32], data[32], crc[16];
+    snprintf(text, sizeof(text), "0x%08x+%u", l->text_addr, l->code_size);
+    snprintf(data, sizeof(data), "0x%08x+%u", l->data_addr, l->data_size);
+    if (r->crc) {
+        snprintf(crc, sizeof(crc), "%08x", r->crc);
+    } else {
+        snprintf(crc, sizeof(crc), "none");
+    }
+    printf("%2u.%-1u 0x%08x %-18s %7u %-18s %7u %5u %6u %-8s %s\n",
+           r->version_major, r->version_minor, l->entry_point, text, l->rodata_size,
+           data, l->bss_size, r->symbols, r->relocs, crc, r->path);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int eclc_inspect(const char* const* paths, int count, const InspectOptions* options) {
+    InspectOptions defaults = {0};
+    if (!options) options = &defaults;
+
+    PathList list = {0};
+    for (int i = 0; i < count; i++) {
+        collect(&list, paths[i]);
+    }
+    if (list.count == 0) {
+        fprintf(stderr, "Error: No FCEF files to inspect\n");
+        xfree(list.items);
+        return 1;
+    }
+
+    InspectResult* results = xcalloc(list.count, sizeof(InspectResult));
+    for (size_t i = 0; i < list.count; i++) {
+        results[i].path = list.items[i];
+    }
+
+    double start = now_seconds();
+    ThreadPool* pool = options->threads == 1 ? NULL : pool_create(options->threads);
+    pool_for(pool, list.count, inspect_file, results);
+    int threads = pool_size(pool);
+    pool_destroy(pool);
+    double elapsed = now_seconds() - start;
+
+    // Results come back in input order whatever thread produced them
+    size_t invalid = 0;
+    size_t bytes = 0;
+    if (!options->json) print_table_header();
+    for (size_t i = 0; i < list.count; i++) {
+        const InspectResult* r = &results[i];
+        if (!result_ok(r)) invalid++;
+        bytes += r->size;
+        if (options->json) {
+            print_json(r);
+        } else {
+            print_row(r);
+        }
+    }
+
+    // Keep stdout pure JSON lines; the summary goes to stderr then
+    fflush(stdout);
+    FILE* summary = options->json ? stderr : stdout;
+    fprintf(summary, "%s    Finished\033[0m %zu files (%zu valid, %zu invalid), "
+            "%.1f MB in %.3fs (%.0f MB/s, %d threads)\n",
+            invalid ? "\033[31m" : "\033[32m", list.count, list.count - invalid, invalid,
+            bytes / 1e6, elapsed, elapsed > 0 ? bytes / 1e6 / elapsed : 0.0, threads);
+
+    for (size_t i = 0; i < list.count; i++) {
+        xfree(list.items[i]);
+    }
+    xfree(list.items);
+    xfree(results);
+    return invalid ? 1 : 0;
+}
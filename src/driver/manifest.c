@@ -0,0 +1,497 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/manifest.h"
+#include "eclc/hash.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MANIFEST_MAGIC   "eclc-manifest 1"
+#define MANIFEST_ROOT    ".eclc"
+#define INCLUDE_DEPTH    32
+
+static char* path_join(const char* dir, const char* name) {
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    char* path = xmalloc(dir_len + name_len + 2);
+    memcpy(path, dir, dir_len);
+    path[dir_len] = '/';
+    memcpy(path + dir_len + 1, name, name_len + 1);
+    return path;
+}
+
+// Directory part of a path, "." when there is none
+static char* path_dir(const char* path) {
+    const char* slash = strrchr(path, '/');
+    if (!slash) return xstrdup(".");
+    size_t len = slash == path ? 1 : (size_t)(slash - path);
+    char* dir = xmalloc(len + 1);
+    memcpy(dir, path, len);
+    dir[len] = '\0';
+    return dir;
+}
+
+static char* read_all(const char* path, size_t* size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    size_t capacity = (size_t)st.st_size;
+    char* data = xmalloc(capacity + 1);
+    size_t used = 0;
+    for (;;) {
+        if (used == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            data = xrealloc(data, capacity + 1);
+        }
+        ssize_t n = read(fd, data + used, capacity - used);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            xfree(data);
+            close(fd);
+            return NULL;
+        }
+        if (n == 0) break;
+        used += (size_t)n;
+    }
+    close(fd);
+    data[used] = '\0';
+    *size = used;
+    return data;
+}
+
+bool file_stamp_stat(const char* path, FileStamp* stamp) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    stamp->mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    stamp->size = (uint64_t)st.st_size;
+    stamp->hash = 0;
+    return true;
+}
+
+bool file_stamp_fresh(const char* path, const FileStamp* recorded, FileStamp* current) {
+    if (!file_stamp_stat(path, current)) {
+        return false;
+    }
+    if (current->mtime_ns == recorded->mtime_ns && current->size == recorded->size) {
+        current->hash = recorded->hash;
+        return true;
+    }
+    if (current->size != recorded->size) {
+        return false;
+    }
+
+    // Touched but maybe not changed (checkout, copy): compare contents
+    size_t size;
+    char* data = read_all(path, &size);
+    if (!data) {
+        return false;
+    }
+    current->hash = eclc_hash64(data, size, 0);
+    xfree(data);
+    return current->hash == recorded->hash;
+}
+
+void manifest_deps_free(ManifestDep* deps, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        xfree(deps[i].path);
+    }
+    xfree(deps);
+}
+
+void manifest_functions_free(ManifestFunction* functions, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        xfree(functions[i].name);
+    }
+    xfree(functions);
+}
+
+static ManifestFunction* copy_functions(const ManifestFunction* functions, size_t count) {
+    ManifestFunction* copy = xmalloc((count ? count : 1) * sizeof(ManifestFunction));
+    for (size_t i = 0; i < count; i++) {
+        copy[i].name = xstrdup(functions[i].name);
+        copy[i].hash = functions[i].hash;
+    }
+    return copy;
+}
+
+bool manifest_entry_fresh(const ManifestEntry* entry, const char* path,
+                          ManifestEntry* updated) {
+    FileStamp stamp;
+    if (!file_stamp_fresh(path, &entry->stamp, &stamp)) {
+        return false;
+    }
+
+    ManifestDep* deps = xcalloc(entry->dep_count + 1, sizeof(ManifestDep));
+    for (size_t i = 0; i < entry->dep_count; i++) {
+        const ManifestDep* dep = &entry->deps[i];
+        if (!file_stamp_fresh(dep->path, &dep->stamp, &deps[i].stamp)) {
+            manifest_deps_free(deps, i);
+            return false;
+        }
+        deps[i].path = xstrdup(dep->path);
+    }
+
+    if (!updated) {
+        manifest_deps_free(deps, entry->dep_count);
+        return true;
+    }
+    updated->name = xstrdup(entry->name);
+    updated->stamp = stamp;
+    updated->object = xstrdup(entry->object);
+    updated->deps = deps;
+    updated->dep_count = entry->dep_count;
+    updated->functions = copy_functions(entry->functions, entry->function_count);
+    updated->function_count = entry->function_count;
+    return true;
+}
+
+// ==================== Include discovery ====================
+
+typedef struct {
+    ManifestDep* items;
+    size_t count;
+    size_t capacity;
+} DepList;
+
+static bool dep_known(const DepList* list, const char* path) {
+    for (size_t i = 0; i < list->count; i++) {
+        if (strcmp(list->items[i].path, path) == 0) return true;
+    }
+    return false;
+}
+
+// Next `#include "name"` at or after `p`; returns the line end
+static const char* next_include(const char* p, const char** name, size_t* len) {
+    *name = NULL;
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '#') {
+        p++;
+        while (*p == ' ' || *p == '\t') p++;
+        if (strncmp(p, "include", 7) == 0) {
+            p += 7;
+            while (*p == ' ' || *p == '\t') p++;
+            if (*p == '"') {
+                const char* end = strchr(p + 1, '"');
+                const char* eol = strchr(p + 1, '\n');
+                if (end && (!eol || end < eol)) {
+                    *name = p + 1;
+                    *len = (size_t)(end - p - 1);
+                }
+            }
+        }
+    }
+    const char* eol = strchr(p, '\n');
+    return eol ? eol + 1 : p + strlen(p);
+}
+
+static void scan_includes(DepList* list, const char* source, const char* source_path, int depth) {
+    if (depth > INCLUDE_DEPTH) return;
+
+    char* dir = path_dir(source_path);
+    for (const char* p = source; *p;) {
+        const char* name;
+        size_t len;
+        p = next_include(p, &name, &len);
+        if (!name || len == 0) continue;
+
+        char* include = xmalloc(len + 1);
+        memcpy(include, name, len);
+        include[len] = '\0';
+        char* path = include[0] == '/' ? xstrdup(include) : path_join(dir, include);
+        xfree(include);
+
+        size_t size;
+        char* data = dep_known(list, path) ? NULL : read_all(path, &size);
+        if (!data) {
+            xfree(path);            // Seen already, or missing (then it's the compiler's error)
+            continue;
+        }
+
+        if (list->count == list->capacity) {
+            list->capacity = list->capacity ? list->capacity * 2 : 8;
+            list->items = xrealloc(list->items, list->capacity * sizeof(ManifestDep));
+        }
+        ManifestDep* dep = &list->items[list->count++];
+        dep->path = path;
+        file_stamp_stat(path, &dep->stamp);
+        dep->stamp.hash = eclc_hash64(data, size, 0);
+        scan_includes(list, data, path, depth + 1);
+        xfree(data);
+    }
+    xfree(dir);
+}
+
+size_t manifest_scan_includes(const char* source, const char* source_path,
+                              ManifestDep** deps) {
+    DepList list = {0};
+    scan_includes(&list, source, source_path, 0);
+    *deps = list.items;
+    return list.count;
+}
+
+// ==================== Manifest file ====================
+
+static Manifest* manifest_new(const char* dir, u64 flags) {
+    Manifest* manifest = xcalloc(1, sizeof(Manifest));
+    manifest->dir = xstrdup(dir);
+    manifest->flags = flags;
+    return manifest;
+}
+
+Manifest* manifest_create(const Manifest* previous) {
+    return manifest_new(previous->dir, previous->flags);
+}
+
+void manifest_add(Manifest* manifest, ManifestEntry* entry) {
+    if (manifest->count == manifest->capacity) {
+        manifest->capacity = manifest->capacity ? manifest->capacity * 2 : 64;
+        manifest->entries = xrealloc(manifest->entries, manifest->capacity * sizeof(ManifestEntry));
+    }
+    manifest->entries[manifest->count++] = *entry;
+    memset(entry, 0, sizeof(*entry));
+}
+
+static bool parse_stamp(const char** p, FileStamp* stamp) {
+    char* end;
+    stamp->mtime_ns = strtoll(*p, &end, 10);
+    if (end == *p) return false;
+    *p = end;
+    stamp->size = strtoull(*p, &end, 10);
+    if (end == *p) return false;
+    *p = end;
+    stamp->hash = strtoull(*p, &end, 16);
+    if (end == *p) return false;
+    *p = end;
+    return true;
+}
+
+// Rest of the line after one separating space
+static char* parse_rest(const char* p, const char* eol) {
+    if (*p == ' ') p++;
+    size_t len = (size_t)(eol - p);
+    char* s = xmalloc(len + 1);
+    memcpy(s, p, len);
+    s[len] = '\0';
+    return s;
+}
+
+static bool parse_manifest(Manifest* manifest, char* text, u64 flags) {
+    char* line = text;
+    size_t magic_len = strlen(MANIFEST_MAGIC);
+    if (strncmp(line, MANIFEST_MAGIC, magic_len) != 0 || line[magic_len] != '\n') {
+        return false;
+    }
+
+    ManifestEntry* current = NULL;
+    for (line += magic_len + 1; *line; ) {
+        char* eol = strchr(line, '\n');
+        if (!eol) return false;
+        const char* p = line;
+
+        if (strncmp(p, "flags ", 6) == 0) {
+            if (strtoull(p + 6, NULL, 16) != flags) return false;
+        } else if (strncmp(p, "link ", 5) == 0) {
+            manifest->link_flags = strtoull(p + 5, NULL, 16);
+        } else if (strncmp(p, "output ", 7) == 0) {
+            p += 7;
+            if (!parse_stamp(&p, &manifest->output)) return false;
+        } else if (strncmp(p, "file ", 5) == 0) {
+            ManifestEntry entry = {0};
+            p += 5;
+            if (!parse_stamp(&p, &entry.stamp)) return false;
+            while (*p == ' ') p++;
+            const char* object_end = strchr(p, ' ');
+            if (!object_end || object_end > eol) return false;
+            entry.object = parse_rest(p, object_end);
+            entry.name = parse_rest(object_end, eol);
+            manifest_add(manifest, &entry);
+            current = &manifest->entries[manifest->count - 1];
+        } else if (strncmp(p, "dep ", 4) == 0 && current) {
+            ManifestDep dep;
+            p += 4;
+            if (!parse_stamp(&p, &dep.stamp)) return false;
+            dep.path = parse_rest(p, eol);
+            current->deps = xrealloc(current->deps, (current->dep_count + 1) * sizeof(ManifestDep));
+            current->deps[current->dep_count++] = dep;
+        } else if (strncmp(p, "fn ", 3) == 0 && current) {
+            ManifestFunction function;
+            char* end;
+            p += 3;
+            function.hash = strtoull(p, &end, 16);
+            if (end == p) return false;
+            function.name = parse_rest(end, eol);
+            current->functions = xrealloc(current->functions,
+                                          (current->function_count + 1) * sizeof(ManifestFunction));
+            current->functions[current->function_count++] = function;
+        }
+        line = eol + 1;
+    }
+    return true;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    return strcmp(((const ManifestEntry*)a)->name, ((const ManifestEntry*)b)->name);
+}
+
+Manifest* manifest_load(const char* output_file, u64 flags) {
+    // One directory per output, so builds of different folders into the
+    // same directory keep their own state
+    char* out_dir = path_dir(output_file);
+    char* root = path_join(out_dir, MANIFEST_ROOT);
+    const char* slash = strrchr(output_file, '/');
+    char* dir = path_join(root, slash ? slash + 1 : output_file);
+    Manifest* manifest = manifest_new(dir, flags);
+    xfree(out_dir);
+    xfree(root);
+    xfree(dir);
+
+    char* path = path_join(manifest->dir, "manifest");
+    size_t size;
+    char* text = read_all(path, &size);
+    xfree(path);
+    if (!text) {
+        return manifest;
+    }
+
+    if (!parse_manifest(manifest, text, flags)) {
+        // Stale format or other flags: start over
+        Manifest* empty = manifest_create(manifest);
+        manifest_free(manifest);
+        manifest = empty;
+    }
+    xfree(text);
+    qsort(manifest->entries, manifest->count, sizeof(ManifestEntry), compare_entries);
+    return manifest;
+}
+
+const ManifestEntry* manifest_find(const Manifest* manifest, const char* name) {
+    ManifestEntry key;
+    key.name = (char*)name;
+    return bsearch(&key, manifest->entries, manifest->count, sizeof(ManifestEntry),
+                   compare_entries);
+}
+
+bool manifest_prepare_dirs(const Manifest* manifest) {
+    char* root = path_dir(manifest->dir);
+    char* objects = path_join(manifest->dir, "objects");
+    bool ok = (mkdir(root, 0777) == 0 || errno == EEXIST) &&
+              (mkdir(manifest->dir, 0777) == 0 || errno == EEXIST) &&
+              (mkdir(objects, 0777) == 0 || errno == EEXIST);
+    xfree(objects);
+    xfree(root);
+    return ok;
+}
+
+char* manifest_object_name(const char* name) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%016" PRIx64 ".fcef", eclc_hash64(name, strlen(name), 0));
+    return xstrdup(buf);
+}
+
+char* manifest_object_path(const Manifest* manifest, const char* object) {
+    char* objects = path_join(manifest->dir, "objects");
+    char* path = path_join(objects, object);
+    xfree(objects);
+    return path;
+}
+
+static void write_stamp(FILE* file, const FileStamp* stamp) {
+    fprintf(file, "%" PRId64 " %" PRIu64 " %" PRIx64, stamp->mtime_ns, stamp->size, stamp->hash);
+}
+
+bool manifest_save(const Manifest* manifest) {
+    if (!manifest_prepare_dirs(manifest)) {
+        return false;
+    }
+    char* path = path_join(manifest->dir, "manifest");
+    char* tmp = path_join(manifest->dir, "manifest.tmp");
+    FILE* file = fopen(tmp, "w");
+    if (!file) {
+        xfree(tmp);
+        xfree(path);
+        return false;
+    }
+
+    fprintf(file, MANIFEST_MAGIC "\n");
+    fprintf(file, "flags %" PRIx64 "\n", manifest->flags);
+    fprintf(file, "link %" PRIx64 "\n", manifest->link_flags);
+    fprintf(file, "output ");
+    write_stamp(file, &manifest->output);
+    fprintf(file, "\n");
+    for (size_t i = 0; i < manifest->count; i++) {
+        const ManifestEntry* entry = &manifest->entries[i];
+        fprintf(file, "file ");
+        write_stamp(file, &entry->stamp);
+        fprintf(file, " %s %s\n", entry->object, entry->name);
+        for (size_t d = 0; d < entry->dep_count; d++) {
+            fprintf(file, "dep ");
+            write_stamp(file, &entry->deps[d].stamp);
+            fprintf(file, " %s\n", entry->deps[d].path);
+        }
+        for (size_t f = 0; f < entry->function_count; f++) {
+            fprintf(file, "fn %" PRIx64 " %s\n", entry->functions[f].hash, entry->functions[f].name);
+        }
+    }
+
+    bool ok = fclose(file) == 0 && rename(tmp, path) == 0;
+    if (!ok) unlink(tmp);
+    xfree(tmp);
+    xfree(path);
+    return ok;
+}
+
+void manifest_prune(const Manifest* previous, const Manifest* next) {
+    for (size_t i = 0; i < previous->count; i++) {
+        const ManifestEntry* entry = &previous->entries[i];
+        const ManifestEntry* kept = manifest_find(next, entry->name);
+        if (kept && strcmp(kept->object, entry->object) == 0) continue;
+        char* path = manifest_object_path(previous, entry->object);
+        unlink(path);
+        xfree(path);
+    }
+}
+
+void manifest_entry_free(ManifestEntry* entry) {
+    xfree(entry->name);
+    xfree(entry->object);
+    manifest_deps_free(entry->deps, entry->dep_count);
+    manifest_functions_free(entry->functions, entry->function_count);
+    memset(entry, 0, sizeof(*entry));
+}
+
+void manifest_free(Manifest* manifest) {
+    if (!manifest) return;
+    for (size_t i = 0; i < manifest->count; i++) {
+        manifest_entry_free(&manifest->entries[i]);
+    }
+    xfree(manifest->entries);
+    xfree(manifest->dir);
+    xfree(manifest);
+}
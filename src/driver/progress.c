@@ -0,0 +1,238 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/progress.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PROGRESS_BAR_WIDTH 20
+#define PROGRESS_LINE_MAX 1024
+
+struct Progress {
+    FILE* out;
+    const char* verb;
+    bool tty;
+    int columns;                // Terminal width, lines are cut to fit
+    long interval_ms;
+    
+    // Written by workers (atomic)
+    int total;
+    int done;
+    int worked;
+    int failed;
+    const char* name;           // Last item that did work
+    
+    pthread_t thread;
+    pthread_mutex_t lock;       // Held while drawing or paused
+    pthread_cond_t wake;
+    bool stopping;
+    bool drawn;                 // Status line on screen (TTY only)
+    int drawn_done;             // State of the last draw
+    int drawn_total;
+};
+
+static int load(const int* counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static int terminal_columns(FILE* out) {
+    struct winsize ws;
+    if (ioctl(fileno(out), TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+        return ws.ws_col;
+    }
+    return 80;
+}
+
+// Format the status line into one buffer and write it with a single call
+static void draw(Progress* p, bool final) {
+    int worked = load(&p->worked);
+    if (worked == 0) {
+        return;
+    }
+    int done = load(&p->done);
+    int total = load(&p->total);
+    if (done == p->drawn_done && total == p->drawn_total && !(final && p->tty)) {
+        return;
+    }
+    int failed = load(&p->failed);
+    const char* name = __atomic_load_n(&p->name, __ATOMIC_ACQUIRE);
+    if (!name) name = "";
+    
+    char line[PROGRESS_LINE_MAX];
+    size_t len = 0;
+    size_t cap = sizeof(line);
+    if (p->tty) {
+        char counts[32];
+        int counts_len = snprintf(counts, sizeof(counts), "[%d/%d]", done, total);
+        int filled = total > 0 ? (int)((long)done * PROGRESS_BAR_WIDTH / total) : 0;
+        char bar[PROGRESS_BAR_WIDTH + 16];
+        memcpy(bar, "\033[32m", 5);
+        size_t bar_len = 5;
+        for (int i = 0; i < PROGRESS_BAR_WIDTH; i++) {
+            if (i < filled) {
+                bar[bar_len++] = '=';
+            } else if (i == filled && done < total) {
+                memcpy(bar + bar_len, "\033[33m>", 6);
+                bar_len += 6;
+            } else {
+                bar[bar_len++] = ' ';
+            }
+        }
+        bar[bar_len] = '\0';
+        
+        // Keep the tail of the name so the line never wraps
+        int used = 12 + 1 + counts_len + 1 + PROGRESS_BAR_WIDTH + 1 +
+                   (failed ? 16 : 0);
+        int room = p->columns - 1 - used;
+        size_t name_len = strlen(name);
+        const char* ellipsis = "";
+        if (room < 4) {
+            name += name_len;
+        } else if ((int)name_len > room) {
+            name += name_len - (room - 3);
+            ellipsis = "...";
+        }
+        len = snprintf(line, cap, "\r\033[2K\033[32m%12s\033[0m %s %s\033[0m %s%s",
+                       p->verb, counts, bar, ellipsis, name);
+        if (failed && len < cap) {
+            len += snprintf(line + len, cap - len, "  \033[31m%d failed\033[0m", failed);
+        }
+        p->drawn = true;
+    } else {
+        int percent = total > 0 ? (int)((long)done * 100 / total) : 0;
+        len = snprintf(line, cap, "%12s [%d/%d] %3d%% %s", p->verb, done, total, percent, name);
+        if (failed && len < cap) {
+            len += snprintf(line + len, cap - len, " (%d failed)", failed);
+        }
+        if (len >= cap) len = cap - 2;
+        line[len++] = '\n';
+    }
+    if (len >= cap) len = cap - 1;
+    fwrite(line, 1, len, p->out);
+    fflush(p->out);
+    p->drawn_done = done;
+    p->drawn_total = total;
+}
+
+static void* render_loop(void* arg) {
+    Progress* p = arg;
+    pthread_mutex_lock(&p->lock);
+    while (!p->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += p->interval_ms * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&p->wake, &p->lock, &deadline);
+        if (!p->stopping) {
+            draw(p, false);
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+Progress* progress_start(FILE* out, const char* verb, int total) {
+    Progress* p = xcalloc(1, sizeof(Progress));
+    p->out = out;
+    p->verb = verb;
+    p->tty = isatty(fileno(out));
+    p->columns = p->tty ? terminal_columns(out) : 0;
+    p->interval_ms = p->tty ? 50 : 1000;
+    p->total = total;
+    p->drawn_done = -1;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->wake, NULL);
+    if (pthread_create(&p->thread, NULL, render_loop, p) != 0) {
+        pthread_cond_destroy(&p->wake);
+        pthread_mutex_destroy(&p->lock);
+        xfree(p);
+        return NULL;
+    }
+    return p;
+}
+
+void progress_add_total(Progress* progress, int count) {
+    if (progress) {
+        __atomic_add_fetch(&progress->total, count, __ATOMIC_RELAXED);
+    }
+}
+
+void progress_done(Progress* progress, const char* name, bool ok) {
+    if (!progress) {
+        return;
+    }
+    __atomic_store_n(&progress->name, name, __ATOMIC_RELEASE);
+    if (!ok) {
+        __atomic_add_fetch(&progress->failed, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&progress->worked, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&progress->done, 1, __ATOMIC_RELAXED);
+}
+
+void progress_skip(Progress* progress) {
+    if (progress) {
+        __atomic_add_fetch(&progress->done, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void progress_pause(Progress* progress) {
+    if (!progress) {
+        return;
+    }
+    pthread_mutex_lock(&progress->lock);
+    if (progress->drawn) {
+        fputs("\r\033[2K", progress->out);
+        fflush(progress->out);
+        progress->drawn = false;
+    }
+}
+
+void progress_resume(Progress* progress) {
+    if (!progress) {
+        return;
+    }
+    fflush(progress->out);
+    if (progress->tty) {
+        progress->drawn_done = -1;  // Redraw on the next tick
+    }
+    pthread_mutex_unlock(&progress->lock);
+}
+
+void progress_finish(Progress* progress) {
+    if (!progress) {
+        return;
+    }
+    pthread_mutex_lock(&progress->lock);
+    progress->stopping = true;
+    pthread_cond_signal(&progress->wake);
+    pthread_mutex_unlock(&progress->lock);
+    pthread_join(progress->thread, NULL);
+    
+    draw(progress, true);
+    if (progress->drawn) {
+        fputc('\n', progress->out);
+        fflush(progress->out);
+    }
+    pthread_cond_destroy(&progress->wake);
+    pthread_mutex_destroy(&progress->lock);
+    xfree(progress);
+}
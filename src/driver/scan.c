@@ -0,0 +1,331 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/scan.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#define SCAN_BATCH (32 * 1024)  // getdents64 buffer, several hundred entries per call
+
+typedef struct {
+    char* pattern;
+    bool negate;                // "!pattern" takes a file back
+    bool dir_only;              // "pattern/" only matches directories
+    bool anchored;              // Has a '/', so it matches the path from the rule's directory
+} IgnoreRule;
+
+// Rules of one .eclcignore, chained to those of the directories above
+typedef struct IgnoreSet {
+    const struct IgnoreSet* parent;
+    size_t base;                // Where paths relative to its directory start
+    IgnoreRule* rules;
+    size_t count;
+} IgnoreSet;
+
+typedef struct {
+    size_t name;                // Offset into the listing's names
+    unsigned char type;         // DT_* from the directory entry
+} ListEntry;
+
+// Everything in one directory, read before any of it is visited
+typedef struct {
+    char* names;
+    size_t size;
+    size_t capacity;
+    ListEntry* entries;
+    size_t count;
+    size_t entry_capacity;
+} Listing;
+
+typedef struct {
+    bool (*match)(const char* name);
+    ScanCallback found;
+    void* ctx;
+    ScanStats* stats;
+    char* path;                 // Root, then the relative path being visited
+    size_t len;
+    size_t capacity;
+    size_t rel;                 // Start of the relative part of `path`
+    char* batch;
+} Scanner;
+
+bool scan_is_source(const char* name) {
+    const char* ext = strrchr(name, '.');
+    return ext && (strcmp(ext, ".c") == 0 || strcmp(ext, ".cpp") == 0);
+}
+
+static void listing_add(Listing* list, const char* name, unsigned char type) {
+    size_t len = strlen(name) + 1;
+    if (list->size + len > list->capacity) {
+        while (list->size + len > list->capacity) {
+            list->capacity = list->capacity ? list->capacity * 2 : 1024;
+        }
+        list->names = xrealloc(list->names, list->capacity);
+    }
+    if (list->count == list->entry_capacity) {
+        list->entry_capacity = list->entry_capacity ? list->entry_capacity * 2 : 32;
+        list->entries = xrealloc(list->entries, list->entry_capacity * sizeof(ListEntry));
+    }
+    memcpy(list->names + list->size, name, len);
+    list->entries[list->count].name = list->size;
+    list->entries[list->count].type = type;
+    list->count++;
+    list->size += len;
+}
+
+#ifdef __linux__
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Whole batches of entries per system call instead of one readdir() each
+static bool read_listing(Scanner* scanner, int fd, Listing* list) {
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, scanner->batch, SCAN_BATCH);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) return true;
+        for (long offset = 0; offset < n;) {
+            const struct linux_dirent64* d = (const void*)(scanner->batch + offset);
+            offset += d->d_reclen;
+            if (d->d_name[0] != '.' || strcmp(d->d_name, ECLC_IGNORE_FILE) == 0) {
+                listing_add(list, d->d_name, d->d_type);
+            }
+        }
+    }
+}
+#else
+static bool read_listing(Scanner* scanner, int fd, Listing* list) {
+    (void)scanner;
+    int dir_fd = dup(fd);
+    DIR* dir = dir_fd >= 0 ? fdopendir(dir_fd) : NULL;
+    if (!dir) {
+        if (dir_fd >= 0) close(dir_fd);
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.' || strcmp(entry->d_name, ECLC_IGNORE_FILE) == 0) {
+            listing_add(list, entry->d_name, entry->d_type);
+        }
+    }
+    closedir(dir);
+    return true;
+}
+#endif
+
+static char* read_at(int dir_fd, const char* name) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    size_t capacity = 4096;
+    size_t used = 0;
+    char* data = xmalloc(capacity + 1);
+    for (;;) {
+        if (used == capacity) {
+            capacity *= 2;
+            data = xrealloc(data, capacity + 1);
+        }
+        ssize_t n = read(fd, data + used, capacity - used);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        used += (size_t)n;
+    }
+    close(fd);
+    data[used] = '\0';
+    return data;
+}
+
+// One pattern per line; blank lines and '#' comments are skipped
+static void load_ignore(IgnoreSet* set, int dir_fd) {
+    char* text = read_at(dir_fd, ECLC_IGNORE_FILE);
+    if (!text) return;
+    size_t capacity = 0;
+    for (char* line = text; *line;) {
+        char* end = strchr(line, '\n');
+        char* next = end ? end + 1 : line + strlen(line);
+        if (!end) end = next;
+        while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) end--;
+        *end = '\0';
+        
+        IgnoreRule rule = {0};
+        if (*line == '!') {
+            rule.negate = true;
+            line++;
+        }
+        if (end > line && end[-1] == '/') {
+            rule.dir_only = true;
+            *--end = '\0';
+        }
+        rule.anchored = strchr(line, '/') != NULL;
+        if (*line == '/') line++;
+        
+        if (*line && *line != '#') {
+            if (set->count == capacity) {
+                capacity = capacity ? capacity * 2 : 8;
+                set->rules = xrealloc(set->rules, capacity * sizeof(IgnoreRule));
+            }
+            rule.pattern = xstrdup(line);
+            set->rules[set->count++] = rule;
+        }
+        line = next;
+    }
+    xfree(text);
+}
+
+// The nearest .eclcignore decides, and within it the last matching line
+static bool is_ignored(const IgnoreSet* set, const char* rel, const char* name, bool is_dir) {
+    for (; set; set = set->parent) {
+        for (size_t i = set->count; i-- > 0;) {
+            const IgnoreRule* rule = &set->rules[i];
+            if (rule->dir_only && !is_dir) continue;
+            bool match = rule->anchored
+                ? fnmatch(rule->pattern, rel + set->base, FNM_PATHNAME) == 0
+                : fnmatch(rule->pattern, name, 0) == 0;
+            if (match) return !rule->negate;
+        }
+    }
+    return false;
+}
+
+static void path_push(Scanner* scanner, const char* name) {
+    size_t len = strlen(name);
+    if (scanner->len + len + 2 > scanner->capacity) {
+        while (scanner->len + len + 2 > scanner->capacity) {
+            scanner->capacity *= 2;
+        }
+        scanner->path = xrealloc(scanner->path, scanner->capacity);
+    }
+    if (scanner->len > 0 && scanner->path[scanner->len - 1] != '/') {
+        scanner->path[scanner->len++] = '/';
+    }
+    memcpy(scanner->path + scanner->len, name, len + 1);
+    scanner->len += len;
+}
+
+// Read the directory, report its files, then descend into its directories
+static void scan_dir(Scanner* scanner, int fd, const IgnoreSet* parent) {
+    Listing list = {0};
+    if (!read_listing(scanner, fd, &list)) {
+        fprintf(stderr, "Warning: Cannot read directory '%s'\n", scanner->path);
+        return;
+    }
+    scanner->stats->dirs++;
+    
+    size_t dir_len = scanner->len;
+    IgnoreSet set = { parent, 0, NULL, 0 };
+    for (size_t i = 0; i < list.count; i++) {
+        if (strcmp(list.names + list.entries[i].name, ECLC_IGNORE_FILE) == 0) {
+            set.base = dir_len > scanner->rel ? dir_len - scanner->rel + 1 : 0;
+            load_ignore(&set, fd);
+        }
+    }
+    const IgnoreSet* rules = set.count ? &set : parent;
+    
+    // Files first so their compiles start before the subtrees are walked
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < list.count; i++) {
+            ListEntry* entry = &list.entries[i];
+            const char* name = list.names + entry->name;
+            if (name[0] == '.') continue;
+            
+            // Symlinks are followed to files but never to directories
+            if (entry->type == DT_UNKNOWN || entry->type == DT_LNK) {
+                struct stat st;
+                if (fstatat(fd, name, &st, 0) != 0) continue;
+                entry->type = S_ISREG(st.st_mode) ? DT_REG
+                            : S_ISDIR(st.st_mode) && entry->type == DT_UNKNOWN ? DT_DIR : DT_LNK;
+            }
+            bool is_dir = entry->type == DT_DIR;
+            if (entry->type != (pass == 0 ? DT_REG : DT_DIR)) continue;
+            if (!is_dir && !scanner->match(name)) continue;
+            
+            path_push(scanner, name);
+            const char* rel = scanner->path + scanner->rel;
+            if (is_ignored(rules, rel, name, is_dir)) {
+                scanner->stats->ignored++;
+            } else if (!is_dir) {
+                scanner->stats->files++;
+                scanner->found(scanner->ctx, rel, scanner->path);
+            } else {
+                int child = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                if (child >= 0) {
+                    scan_dir(scanner, child, rules);
+                    close(child);
+                } else {
+                    fprintf(stderr, "Warning: Cannot open directory '%s'\n", scanner->path);
+                }
+            }
+            scanner->len = dir_len;
+            scanner->path[dir_len] = '\0';
+        }
+    }
+    
+    for (size_t i = 0; i < set.count; i++) {
+        xfree(set.rules[i].pattern);
+    }
+    xfree(set.rules);
+    xfree(list.entries);
+    xfree(list.names);
+}
+
+bool scan_project(const char* root, ScanCallback found, void* ctx, ScanStats* stats) {
+    return scan_files(root, scan_is_source, found, ctx, stats);
+}
+
+bool scan_files(const char* root, bool (*match)(const char* name),
+                ScanCallback found, void* ctx, ScanStats* stats) {
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    
+    ScanStats local = {0};
+    Scanner scanner = {0};
+    scanner.match = match;
+    scanner.found = found;
+    scanner.ctx = ctx;
+    scanner.stats = stats ? stats : &local;
+    scanner.capacity = 256;
+    scanner.path = xmalloc(scanner.capacity);
+    scanner.path[0] = '\0';
+    path_push(&scanner, root);
+    while (scanner.len > 1 && scanner.path[scanner.len - 1] == '/') {
+        scanner.path[--scanner.len] = '\0';
+    }
+    scanner.rel = scanner.len + (scanner.path[scanner.len - 1] == '/' ? 0 : 1);
+    scanner.batch = xmalloc(SCAN_BATCH);
+    
+    *scanner.stats = (ScanStats){0};
+    scan_dir(&scanner, fd, NULL);
+    
+    close(fd);
+    xfree(scanner.batch);
+    xfree(scanner.path);
+    return true;
+}
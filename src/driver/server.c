@@ -0,0 +1,439 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _GNU_SOURCE             // struct ucred
+#include "eclc/server.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SERVER_MAGIC    "ECLS"
+#define SERVER_VERSION  1
+#define SERVER_MAX_REQUEST (1u << 20)
+#define SERVER_RECV_TIMEOUT 10      // Seconds a client may stall while sending
+
+// Sent with the client's stdout and stderr attached (SCM_RIGHTS), then
+// `size` bytes: the working directory and argv, NUL-terminated each.
+// The reply is the command's exit status as an int32.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t argc;
+    uint32_t size;
+} ServerRequest;
+
+static volatile sig_atomic_t stopping;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stopping = 1;
+}
+
+// A directory only we can enter: ours, mode 0700, not a symlink
+static bool private_dir(const char* dir) {
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    struct stat st;
+    return lstat(dir, &st) == 0 && S_ISDIR(st.st_mode) &&
+           st.st_uid == getuid() && (st.st_mode & 077) == 0;
+}
+
+char* server_socket_path(void) {
+    const char* env = getenv("ECLC_SOCKET");
+    if (env && *env) {
+        return xstrdup(env);
+    }
+    char buf[256];
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+    if (runtime && *runtime) {
+        snprintf(buf, sizeof(buf), "%s/eclc.sock", runtime);
+        return xstrdup(buf);
+    }
+    // /tmp is shared, so the socket goes in a directory nobody else can
+    // create files in
+    snprintf(buf, sizeof(buf), "/tmp/eclc-%u", (unsigned)getuid());
+    if (!private_dir(buf)) {
+        fprintf(stderr, "Warning: '%s' is not a private directory, not using it\n", buf);
+        return NULL;
+    }
+    strcat(buf, "/eclc.sock");
+    return xstrdup(buf);
+}
+
+// Whether the process at the other end runs as our user
+static bool peer_is_us(int fd) {
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    return getpeereid(fd, &uid, &gid) == 0 && uid == getuid();
+#endif
+}
+
+static bool socket_address(const char* path, struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Error: Socket path '%s' is too long\n", path);
+        return false;
+    }
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+static bool read_full(int fd, void* data, size_t size) {
+    char* p = data;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+// send() rather than write() so a vanished peer is an error, not SIGPIPE
+static bool write_full(int fd, const void* data, size_t size) {
+    const char* p = data;
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+// Header plus the passed descriptors; fds[] are -1 when none came along.
+// `closed` is set when the peer hung up without sending anything.
+static bool receive_request(int conn, ServerRequest* request, int fds[2], bool* closed) {
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    struct iovec iov = { request, sizeof(*request) };
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    fds[0] = fds[1] = -1;
+    ssize_t n;
+    do {
+        n = recvmsg(conn, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    *closed = n == 0;
+    if (n <= 0) return false;
+
+    for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS &&
+            c->cmsg_len == CMSG_LEN(2 * sizeof(int))) {
+            memcpy(fds, CMSG_DATA(c), 2 * sizeof(int));
+            fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        }
+    }
+    if ((size_t)n < sizeof(*request) &&
+        !read_full(conn, (char*)request + n, sizeof(*request) - (size_t)n)) {
+        return false;
+    }
+    return memcmp(request->magic, SERVER_MAGIC, 4) == 0 &&
+           request->version == SERVER_VERSION &&
+           request->size <= SERVER_MAX_REQUEST && request->argc > 0 &&
+           request->argc < request->size && fds[0] >= 0 && fds[1] >= 0;
+}
+
+// Split the payload into the working directory and argv
+static char** parse_payload(char* payload, uint32_t size, uint32_t argc, const char** cwd) {
+    if (size == 0 || payload[size - 1] != '\0') return NULL;
+    char** argv = xcalloc(argc + 1, sizeof(char*));
+    char* p = payload;
+    char* end = payload + size;
+    *cwd = p;
+    p += strlen(p) + 1;
+    for (uint32_t i = 0; i < argc; i++) {
+        if (p >= end) {
+            xfree(argv);
+            return NULL;
+        }
+        argv[i] = p;
+        p += strlen(p) + 1;
+    }
+    return argv;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Run the request with the client's stdout, stderr and directory
+static int run_request(ServerCommand command, int argc, char** argv, const char* cwd,
+                       const int fds[2], int home) {
+    fflush(stdout);
+    fflush(stderr);
+    int saved_out = dup(STDOUT_FILENO);
+    int saved_err = dup(STDERR_FILENO);
+    dup2(fds[0], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+
+    int status;
+    if (chdir(cwd) != 0) {
+        fprintf(stderr, "Error: Compile server cannot enter '%s'\n", cwd);
+        status = 1;
+    } else {
+        status = command(argc, argv);
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(saved_out);
+    close(saved_err);
+    if (fchdir(home) != 0) {
+        fprintf(stderr, "Warning: Compile server cannot return to its directory\n");
+    }
+    return status;
+}
+
+static void serve(int conn, ServerCommand command, int home) {
+    ServerRequest request;
+    int fds[2];
+    bool closed;
+    bool valid = receive_request(conn, &request, fds, &closed);
+    char* payload = valid ? xmalloc(request.size) : NULL;
+    char** argv = NULL;
+    const char* cwd = NULL;
+    if (valid && read_full(conn, payload, request.size)) {
+        argv = parse_payload(payload, request.size, request.argc, &cwd);
+    }
+
+    if (argv) {
+        double start = now_ms();
+        int32_t status = run_request(command, (int)request.argc, argv, cwd, fds, home);
+        fprintf(stderr, "\033[32m      Served\033[0m");
+        for (uint32_t i = 1; i < request.argc; i++) {
+            fprintf(stderr, " %s", argv[i]);
+        }
+        fprintf(stderr, " (exit %d, %.1f ms)\n", (int)status, now_ms() - start);
+        write_full(conn, &status, sizeof(status));
+    } else if (!closed) {
+        fprintf(stderr, "Warning: Dropped a malformed compile server request\n");
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    xfree(argv);
+    xfree(payload);
+}
+
+// Bind, replacing a socket file left behind by a server that is gone
+static int listen_socket(const char* path) {
+    struct sockaddr_un addr;
+    if (!socket_address(path, &addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot create socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    int rc = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    if (rc != 0 && errno == EADDRINUSE) {
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool alive = probe >= 0 && connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (alive) {
+            fprintf(stderr, "Error: A compile server is already listening on '%s'\n", path);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+        rc = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    if (rc != 0 || listen(fd, 64) != 0) {
+        fprintf(stderr, "Error: Cannot listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int eclc_server(const char* socket_path, ServerCommand command) {
+    int fd = listen_socket(socket_path);
+    if (fd < 0) {
+        return 1;
+    }
+    int home = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    // No SA_RESTART, so a signal breaks accept() and the loop sees `stopping`
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "\033[32m   Listening\033[0m on %s\n", socket_path);
+    while (!stopping) {
+        int conn = accept(fd, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "Error: accept failed: %s\n", strerror(errno));
+            break;
+        }
+        fcntl(conn, F_SETFD, FD_CLOEXEC);
+        if (!peer_is_us(conn)) {
+            fprintf(stderr, "Warning: Refused a compile server request from another user\n");
+            close(conn);
+            continue;
+        }
+        // Requests are served one at a time, so a client that stops
+        // sending mid-request must not hold up the ones behind it
+        struct timeval timeout = { SERVER_RECV_TIMEOUT, 0 };
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        serve(conn, command, home);
+        close(conn);
+    }
+
+    close(fd);
+    unlink(socket_path);
+    if (home >= 0) close(home);
+    fprintf(stderr, "\033[32m     Stopped\033[0m compile server\n");
+    return 0;
+}
+
+static char* current_dir(void) {
+    size_t size = 256;
+    char* buf = xmalloc(size);
+    while (!getcwd(buf, size)) {
+        if (errno != ERANGE) {
+            xfree(buf);
+            return NULL;
+        }
+        size *= 2;
+        buf = xrealloc(buf, size);
+    }
+    return buf;
+}
+
+int eclc_client(const char* socket_path, int argc, char* argv[]) {
+    struct sockaddr_un addr;
+    if (!socket_address(socket_path, &addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    // Our argv and output descriptors only go to a server of our own
+    if (!peer_is_us(fd)) {
+        fprintf(stderr, "Warning: Compile server on '%s' belongs to another user, not using it\n",
+                socket_path);
+        close(fd);
+        return -1;
+    }
+
+    char* cwd = current_dir();
+    if (!cwd) {
+        close(fd);
+        return -1;
+    }
+    size_t size = strlen(cwd) + 1;
+    for (int i = 0; i < argc; i++) {
+        size += strlen(argv[i]) + 1;
+    }
+    if (size > SERVER_MAX_REQUEST) {
+        xfree(cwd);
+        close(fd);
+        return -1;
+    }
+    char* payload = xmalloc(size);
+    size_t used = strlen(cwd) + 1;
+    memcpy(payload, cwd, used);
+    for (int i = 0; i < argc; i++) {
+        size_t len = strlen(argv[i]) + 1;
+        memcpy(payload + used, argv[i], len);
+        used += len;
+    }
+    xfree(cwd);
+
+    ServerRequest request;
+    memcpy(request.magic, SERVER_MAGIC, 4);
+    request.version = SERVER_VERSION;
+    request.argc = (uint32_t)argc;
+    request.size = (uint32_t)size;
+
+    int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov = { &request, sizeof(request) };
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(c), fds, sizeof(fds));
+
+    // Our own output may still be buffered; the server writes to the same fds
+    fflush(stdout);
+    fflush(stderr);
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    bool ok = sent == (ssize_t)sizeof(request) && write_full(fd, payload, size);
+    xfree(payload);
+    if (!ok) {
+        close(fd);
+        return -1;
+    }
+
+    int32_t status;
+    if (!read_full(fd, &status, sizeof(status))) {
+        fprintf(stderr, "Error: Compile server closed the connection\n");
+        status = 1;
+    }
+    close(fd);
+    return status;
+}
@@ -0,0 +1,80 @@
+/**
+ * ECLC - E-comOS C/C++ Language Compiler
+ * Copyright (C) 2025  Saladin5101
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "fcef/eclc_fcef.h"
+#include <pthread.h>
+#include <stddef.h>
+
+// Slicing-by-8: eight bytes per step through eight 256-entry tables
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+        }
+        crc_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            uint32_t prev = crc_table[t - 1][i];
+            crc_table[t][i] = (prev >> 8) ^ crc_table[0][prev & 0xFF];
+        }
+    }
+}
+
+static uint32_t load_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint32_t eclc_crc32(uint32_t crc, const void *data, size_t size) {
+    pthread_once(&crc_once, crc_init);
+
+    const uint8_t *p = data;
+    crc = ~crc;
+    while (size >= 8) {
+        uint32_t lo = load_le32(p) ^ crc;
+        uint32_t hi = load_le32(p + 4);
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^
+              crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^
+              crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    }
+    return ~crc;
+}
+
+uint32_t eclc_fcef_crc32(const void *data, size_t size) {
+    static const uint8_t zero[sizeof(((fcef_header_t *)0)->crc32)];
+    const size_t field = offsetof(fcef_header_t, crc32);
+    const size_t after = field + sizeof(zero);
+    if (size < after) {
+        return eclc_crc32(0, data, size);
+    }
+
+    const uint8_t *bytes = data;
+    uint32_t crc = eclc_crc32(0, bytes, field);
+    crc = eclc_crc32(crc, zero, sizeof(zero));
+    return eclc_crc32(crc, bytes + after, size - after);
+}
@@ -1,8 +1,145 @@
 #include "fcef/eclc_fcef.h"
 #include "fcef.h"
+#include "eclc/common.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+// 保留字段至少要放下 32 字节的布局信息
+typedef char fcef_reserved_fits[sizeof(((fcef_header_t *)0)->reserved) >= 32 ? 1 : -1];
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (v >> 24) & 0xFF;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+static uint32_t get_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+// 链接段在文件里是小端的, 内存里的表是本机字节序, 读写时逐字段转换
+typedef char fcef_link_sizes_fixed[sizeof(fcef_symbol_t) == 16 && sizeof(fcef_reloc_t) == 16 &&
+                                   sizeof(fcef_gnu_hash_t) == 16 &&
+                                   sizeof(fcef_link_header_t) == 24 ? 1 : -1];
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_le64(uint8_t *p, uint64_t v) {
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get_le64(const uint8_t *p) {
+    return (uint64_t)get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+static void put_symbol(uint8_t *p, const fcef_symbol_t *sym) {
+    put_le32(p, sym->name);
+    put_le32(p + 4, sym->value);
+    put_le32(p + 8, sym->size);
+    p[12] = sym->section;
+    p[13] = sym->bind;
+    p[14] = sym->type;
+    p[15] = sym->pad;
+}
+
+static void get_symbol(const uint8_t *p, fcef_symbol_t *sym) {
+    sym->name = get_le32(p);
+    sym->value = get_le32(p + 4);
+    sym->size = get_le32(p + 8);
+    sym->section = p[12];
+    sym->bind = p[13];
+    sym->type = p[14];
+    sym->pad = p[15];
+}
+
+static void put_reloc(uint8_t *p, const fcef_reloc_t *rel) {
+    put_le32(p, rel->offset);
+    put_le32(p + 4, rel->symbol);
+    put_le32(p + 8, (uint32_t)rel->addend);
+    p[12] = rel->section;
+    p[13] = rel->type;
+    p[14] = rel->pad & 0xFF;
+    p[15] = (rel->pad >> 8) & 0xFF;
+}
+
+static void get_reloc(const uint8_t *p, fcef_reloc_t *rel) {
+    rel->offset = get_le32(p);
+    rel->symbol = get_le32(p + 4);
+    rel->addend = (int32_t)get_le32(p + 8);
+    rel->section = p[12];
+    rel->type = p[13];
+    rel->pad = (uint16_t)(p[14] | (p[15] << 8));
+}
+
+static void get_gnu_hash(const uint8_t *p, fcef_gnu_hash_t *gnu) {
+    gnu->nbuckets = get_le32(p);
+    gnu->symoffset = get_le32(p + 4);
+    gnu->bloom_size = get_le32(p + 8);
+    gnu->bloom_shift = get_le32(p + 12);
+}
+
+// 哈希表: 头部 4 个字, bloom_size 个 64 位字, 其余都是 32 位字 (桶和链).
+// to_file 为真时从本机字节序写成小端, 否则反过来
+static void convert_hash(uint8_t *dst, const uint8_t *src, size_t size, bool to_file) {
+    fcef_gnu_hash_t gnu;
+    if (to_file) {
+        memcpy(&gnu, src, sizeof(gnu));
+    } else {
+        get_gnu_hash(src, &gnu);
+    }
+    size_t bloom_end = sizeof(gnu) + (size_t)gnu.bloom_size * 8;
+    size_t i = 0;
+    while (i + 4 <= size) {
+        if (i >= sizeof(gnu) && i < bloom_end && i + 8 <= size) {
+            uint64_t word;
+            if (to_file) {
+                memcpy(&word, src + i, 8);
+                put_le64(dst + i, word);
+            } else {
+                word = get_le64(src + i);
+                memcpy(dst + i, &word, 8);
+            }
+            i += 8;
+        } else {
+            uint32_t word;
+            if (to_file) {
+                memcpy(&word, src + i, 4);
+                put_le32(dst + i, word);
+            } else {
+                word = get_le32(src + i);
+                memcpy(dst + i, &word, 4);
+            }
+            i += 4;
+        }
+    }
+    memcpy(dst + i, src + i, size - i);
+}
+
+// 链接段放在数据段之后, 按 8 字节对齐
+static size_t link_section_offset(const eclc_output_t *output) {
+    size_t offset = sizeof(fcef_header_t) + output->code_size +
+                    output->rodata_size + output->data_size;
+    return (offset + 7) & ~(size_t)7;
+}
+
+static bool has_link_tables(const eclc_output_t *output) {
+    return output->symbol_count > 0 || output->reloc_count > 0;
+}
 
 // 从 ECLC 输出创建 FCEF 文件
 void fcef_init_header(fcef_header_t *header) {
@@ -31,18 +168,22 @@ void *eclc_to_fcef(const eclc_output_t *output, size_t *out_size) {
         return NULL;
     }
     
-    // 计算总大小: 头部 + 代码 + 只读数据 + 数据
+    // 计算总大小: 头部 + 代码 + 只读数据 + 数据 [+ 链接段]
     size_t total_size = sizeof(fcef_header_t) + 
                        output->code_size + 
                        output->rodata_size + 
                        output->data_size;
+    size_t link_offset = 0;
+    if (has_link_tables(output)) {
+        link_offset = link_section_offset(output);
+        total_size = link_offset + sizeof(fcef_link_header_t) +
+                     output->symbol_count * sizeof(fcef_symbol_t) +
+                     output->reloc_count * sizeof(fcef_reloc_t) +
+                     output->hash_size + output->strtab_size;
+    }
     
     // 分配内存
-    uint8_t *buffer = (uint8_t *)malloc(total_size);
-    if (!buffer) {
-        if (out_size) *out_size = 0;
-        return NULL;
-    }
+    uint8_t *buffer = xcalloc(1, total_size);
     
     // 初始化头部
     fcef_header_t *header = (fcef_header_t *)buffer;
@@ -76,6 +217,12 @@ void *eclc_to_fcef(const eclc_output_t *output, size_t *out_size) {
     header->reserved[14] = (output->code_size >> 8) & 0xFF;
     header->reserved[15] = output->code_size & 0xFF;
     
+    // 字节 16-31: 只读数据大小, 数据大小, BSS 大小, 链接段偏移 (0 表示没有)
+    put_be32(&header->reserved[16], (uint32_t)output->rodata_size);
+    put_be32(&header->reserved[20], (uint32_t)output->data_size);
+    put_be32(&header->reserved[24], (uint32_t)output->bss_size);
+    put_be32(&header->reserved[28], (uint32_t)link_offset);
+    
     // 复制代码段
     uint8_t *ptr = buffer + sizeof(fcef_header_t);
     memcpy(ptr, output->code, output->code_size);
@@ -92,6 +239,36 @@ void *eclc_to_fcef(const eclc_output_t *output, size_t *out_size) {
         memcpy(ptr, output->data, output->data_size);
     }
     
+    // 链接段: 头 | 符号表 | 重定位表 | 哈希表 | 字符串表
+    if (link_offset) {
+        ptr = buffer + link_offset;
+        put_le32(ptr, FCEF_LINK_MAGIC);
+        put_le32(ptr + 4, (uint32_t)output->symbol_count);
+        put_le32(ptr + 8, (uint32_t)output->reloc_count);
+        put_le32(ptr + 12, (uint32_t)output->hash_size);
+        put_le32(ptr + 16, (uint32_t)output->strtab_size);
+        ptr += sizeof(fcef_link_header_t);
+        
+        for (size_t i = 0; i < output->symbol_count; i++) {
+            put_symbol(ptr, &output->symbols[i]);
+            ptr += sizeof(fcef_symbol_t);
+        }
+        for (size_t i = 0; i < output->reloc_count; i++) {
+            put_reloc(ptr, &output->relocs[i]);
+            ptr += sizeof(fcef_reloc_t);
+        }
+        if (output->hash_size) {
+            convert_hash(ptr, output->hash, output->hash_size, true);
+            ptr += output->hash_size;
+        }
+        if (output->strtab_size) {
+            memcpy(ptr, output->strtab, output->strtab_size);
+        }
+    }
+    
+    // 校验和最后计算, 覆盖整个文件 (crc32 字段按 0 计)
+    header->crc32 = eclc_fcef_crc32(buffer, total_size);
+    
     if (out_size) {
         *out_size = total_size;
     }
@@ -112,17 +289,285 @@ bool eclc_save_fcef(const eclc_output_t *output, const char *filename) {
         return false;
     }
     
-    FILE *file = fopen(filename, "wb");
+    // 先写临时文件再改名: 读者看不到写了一半的文件,
+    // 与缓存共享 inode 的硬链接也不会被原地改写
+    static unsigned long save_counter;
+    size_t tmp_size = strlen(filename) + 48;
+    char *tmp = xmalloc(tmp_size);
+    snprintf(tmp, tmp_size, "%s.%ld.%lu.tmp", filename, (long)getpid(),
+             __atomic_add_fetch(&save_counter, 1, __ATOMIC_RELAXED));
+    
+    FILE *file = fopen(tmp, "wb");
     if (!file) {
-        free(fcef_data);
+        xfree(tmp);
+        xfree(fcef_data);
         return false;
     }
     
     size_t written = fwrite(fcef_data, 1, file_size, file);
+    bool ok = fclose(file) == 0 && written == file_size && rename(tmp, filename) == 0;
+    if (!ok) {
+        remove(tmp);
+    }
+    xfree(tmp);
+    xfree(fcef_data);
+    
+    return ok;
+}
+
+static void *copy_bytes(const uint8_t *src, size_t size) {
+    if (size == 0) return NULL;
+    void *dst = xmalloc(size);
+    memcpy(dst, src, size);
+    return dst;
+}
+
+// 从头部的保留字段读出布局
+void eclc_fcef_layout(const fcef_header_t *header, fcef_layout_t *layout) {
+    layout->entry_point = get_be32(&header->reserved[0]);
+    layout->text_addr = get_be32(&header->reserved[4]);
+    layout->data_addr = get_be32(&header->reserved[8]);
+    layout->code_size = get_be32(&header->reserved[12]);
+    layout->rodata_size = get_be32(&header->reserved[16]);
+    layout->data_size = get_be32(&header->reserved[20]);
+    layout->bss_size = get_be32(&header->reserved[24]);
+    layout->link_offset = get_be32(&header->reserved[28]);
+}
+
+static size_t sections_end(const fcef_layout_t *layout) {
+    return sizeof(fcef_header_t) + (size_t)layout->code_size +
+           layout->rodata_size + layout->data_size;
+}
+
+// 链接段头和各个表都必须在文件范围内. 成功时把头解码到 link,
+// 返回紧跟其后的表
+static const uint8_t *link_header(const uint8_t *bytes, size_t file_size,
+                                  const fcef_layout_t *layout, fcef_link_header_t *link) {
+    size_t offset = layout->link_offset;
+    if (offset < sections_end(layout) || (offset & 7) ||
+        offset + sizeof(fcef_link_header_t) > file_size) {
+        return NULL;
+    }
+    const uint8_t *ptr = bytes + offset;
+    link->magic = get_le32(ptr);
+    link->symbol_count = get_le32(ptr + 4);
+    link->reloc_count = get_le32(ptr + 8);
+    link->hash_size = get_le32(ptr + 12);
+    link->strtab_size = get_le32(ptr + 16);
+    link->pad = get_le32(ptr + 20);
+    size_t tables = (size_t)link->symbol_count * sizeof(fcef_symbol_t) +
+                    (size_t)link->reloc_count * sizeof(fcef_reloc_t) +
+                    link->hash_size + link->strtab_size;
+    if (link->magic != FCEF_LINK_MAGIC ||
+        offset + sizeof(fcef_link_header_t) + tables > file_size) {
+        return NULL;
+    }
+    return ptr + sizeof(fcef_link_header_t);
+}
+
+// 表的内容也要检查: 哈希表头里的参数和符号名偏移都来自文件,
+// 不合法的值会让 fcef_hash_lookup 除零或越界读
+static bool link_tables_valid(const fcef_link_header_t *link, const uint8_t *ptr) {
+    const uint8_t *relocs = ptr + (size_t)link->symbol_count * sizeof(fcef_symbol_t);
+    const uint8_t *hash = relocs + (size_t)link->reloc_count * sizeof(fcef_reloc_t);
+    const char *strtab = (const char *)hash + link->hash_size;
+    
+    if (link->strtab_size && strtab[link->strtab_size - 1] != '\0') {
+        return false;
+    }
+    for (uint32_t i = 0; i < link->symbol_count; i++) {
+        if (get_le32(ptr + (size_t)i * sizeof(fcef_symbol_t)) >= link->strtab_size) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < link->reloc_count; i++) {
+        if (get_le32(relocs + (size_t)i * sizeof(fcef_reloc_t) + 4) >= link->symbol_count) {
+            return false;
+        }
+    }
+    
+    // 没有哈希表时按名字线性查找
+    if (link->hash_size == 0) {
+        return true;
+    }
+    fcef_gnu_hash_t gnu;
+    if (link->hash_size < sizeof(gnu)) {
+        return false;
+    }
+    get_gnu_hash(hash, &gnu);
+    if (gnu.nbuckets == 0 || gnu.bloom_size == 0 ||
+        (gnu.bloom_size & (gnu.bloom_size - 1)) || gnu.bloom_shift >= 64 ||
+        gnu.symoffset > link->symbol_count) {
+        return false;
+    }
+    size_t needed = sizeof(gnu) + (size_t)gnu.bloom_size * 8 + (size_t)gnu.nbuckets * 4 +
+                    (size_t)(link->symbol_count - gnu.symoffset) * 4;
+    return link->hash_size >= needed;
+}
+
+bool eclc_fcef_link_header(const void *data, size_t size, const fcef_layout_t *layout,
+                           fcef_link_header_t *link) {
+    return layout->link_offset && link_header(data, size, layout, link) != NULL;
+}
+
+static bool has_fcef_magic(const uint8_t *bytes) {
+    return bytes[0] == 0x46 && bytes[1] == 0x43 && bytes[2] == 0x45 && bytes[3] == 0x46;
+}
+
+// 校验内存中的 FCEF 映像; crc32 为 0 的旧文件不检查校验和
+eclc_fcef_status_t eclc_fcef_verify(const void *data, size_t size, fcef_layout_t *layout) {
+    if (!data || size < sizeof(fcef_header_t)) {
+        return ECLC_FCEF_TRUNCATED;
+    }
+    
+    const uint8_t *bytes = (const uint8_t *)data;
+    const fcef_header_t *header = (const fcef_header_t *)data;
+    fcef_layout_t local;
+    if (!layout) layout = &local;
+    eclc_fcef_layout(header, layout);
+    
+    if (!has_fcef_magic(bytes)) {
+        return ECLC_FCEF_BAD_MAGIC;
+    }
+    if (header->version_major != 1) {
+        return ECLC_FCEF_BAD_VERSION;
+    }
+    if (header->file_size != size) {
+        return ECLC_FCEF_BAD_SIZE;
+    }
+    if (sections_end(layout) > size) {
+        return ECLC_FCEF_BAD_LAYOUT;
+    }
+    if (layout->link_offset) {
+        fcef_link_header_t link;
+        const uint8_t *tables = link_header(bytes, size, layout, &link);
+        if (!tables || !link_tables_valid(&link, tables)) {
+            return ECLC_FCEF_BAD_LINK;
+        }
+    }
+    if (header->crc32 && header->crc32 != eclc_fcef_crc32(data, size)) {
+        return ECLC_FCEF_BAD_CRC;
+    }
+    return ECLC_FCEF_OK;
+}
+
+const char *eclc_fcef_status_string(eclc_fcef_status_t status) {
+    switch (status) {
+        case ECLC_FCEF_OK: return "ok";
+        case ECLC_FCEF_TRUNCATED: return "truncated header";
+        case ECLC_FCEF_BAD_MAGIC: return "bad magic";
+        case ECLC_FCEF_BAD_VERSION: return "unsupported version";
+        case ECLC_FCEF_BAD_SIZE: return "size mismatch";
+        case ECLC_FCEF_BAD_LAYOUT: return "sections out of bounds";
+        case ECLC_FCEF_BAD_LINK: return "bad link section";
+        case ECLC_FCEF_BAD_CRC: return "crc mismatch";
+    }
+    return "unknown";
+}
+
+// 从内存中的 FCEF 映像解析 ECLC 输出
+eclc_output_t *eclc_from_fcef(const void *data, size_t size) {
+    if (!data || size < sizeof(fcef_header_t)) {
+        return NULL;
+    }
+    
+    const uint8_t *bytes = (const uint8_t *)data;
+    const fcef_header_t *header = (const fcef_header_t *)data;
+    if (!has_fcef_magic(bytes)) {
+        return NULL;
+    }
+    if (header->file_size > size) {
+        return NULL;
+    }
+    if (header->crc32 && header->crc32 != eclc_fcef_crc32(data, header->file_size)) {
+        return NULL;
+    }
+    
+    fcef_layout_t layout;
+    eclc_fcef_layout(header, &layout);
+    if (sections_end(&layout) > header->file_size) {
+        return NULL;
+    }
+    
+    eclc_output_t *output = xcalloc(1, sizeof(eclc_output_t));
+    
+    output->entry_point = layout.entry_point;
+    output->text_addr = layout.text_addr;
+    output->data_addr = layout.data_addr;
+    output->code_size = layout.code_size;
+    output->rodata_size = layout.rodata_size;
+    output->data_size = layout.data_size;
+    output->bss_size = layout.bss_size;
+    
+    const uint8_t *ptr = bytes + sizeof(fcef_header_t);
+    output->code = copy_bytes(ptr, output->code_size);
+    ptr += output->code_size;
+    output->rodata = copy_bytes(ptr, output->rodata_size);
+    ptr += output->rodata_size;
+    output->data = copy_bytes(ptr, output->data_size);
+    
+    if (layout.link_offset) {
+        fcef_link_header_t link;
+        ptr = link_header(bytes, header->file_size, &layout, &link);
+        if (!ptr || !link_tables_valid(&link, ptr)) {
+            eclc_free_output(output);
+            return NULL;
+        }
+        
+        output->symbol_count = output->symbol_capacity = link.symbol_count;
+        if (link.symbol_count) {
+            output->symbols = xmalloc(link.symbol_count * sizeof(fcef_symbol_t));
+        }
+        for (uint32_t i = 0; i < link.symbol_count; i++) {
+            get_symbol(ptr, &output->symbols[i]);
+            ptr += sizeof(fcef_symbol_t);
+        }
+        output->reloc_count = output->reloc_capacity = link.reloc_count;
+        if (link.reloc_count) {
+            output->relocs = xmalloc(link.reloc_count * sizeof(fcef_reloc_t));
+        }
+        for (uint32_t i = 0; i < link.reloc_count; i++) {
+            get_reloc(ptr, &output->relocs[i]);
+            ptr += sizeof(fcef_reloc_t);
+        }
+        output->hash_size = link.hash_size;
+        if (link.hash_size) {
+            output->hash = xmalloc(link.hash_size);
+            convert_hash(output->hash, ptr, link.hash_size, false);
+            ptr += link.hash_size;
+        }
+        output->strtab_size = output->strtab_capacity = link.strtab_size;
+        output->strtab = copy_bytes(ptr, link.strtab_size);
+    }
+    
+    return output;
+}
+
+// 加载 ECLC 编译的 FCEF 文件
+eclc_output_t *eclc_load_fcef(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        return NULL;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(file);
+        return NULL;
+    }
+    
+    uint8_t *buffer = xmalloc(size);
+    size_t read = fread(buffer, 1, size, file);
     fclose(file);
-    free(fcef_data);
     
-    return written == file_size;
+    eclc_output_t *output = NULL;
+    if (read == (size_t)size) {
+        output = eclc_from_fcef(buffer, read);
+    }
+    xfree(buffer);
+    return output;
 }
 
 // 打印 ECLC 输出信息
@@ -146,6 +591,8 @@ void eclc_print_output(const eclc_output_t *output) {
     printf("│ 总代码大小: %zu 字节                    │\n", output->code_size);
     printf("│ 总数据大小: %zu 字节                    │\n", 
            output->rodata_size + output->data_size);
+    printf("│ 符号:       %zu 个, 重定位: %zu 个          │\n",
+           output->symbol_count ? output->symbol_count - 1 : 0, output->reloc_count);
     printf("└─────────────────────────────────────────────┘\n");
 }
 
@@ -153,10 +600,14 @@ void eclc_print_output(const eclc_output_t *output) {
 void eclc_free_output(eclc_output_t *output) {
     if (!output) return;
     
-    if (output->code) free(output->code);
-    if (output->data) free(output->data);
-    if (output->rodata) free(output->rodata);
-    if (output->bss) free(output->bss);
+    xfree(output->code);
+    xfree(output->data);
+    xfree(output->rodata);
+    xfree(output->bss);
+    xfree(output->symbols);
+    xfree(output->relocs);
+    xfree(output->strtab);
+    xfree(output->hash);
     
-    free(output);
+    xfree(output);
 }
\ No newline at end of file
@@ -0,0 +1,300 @@
+/**
+ * ECLC - E-comOS C/C++ Language Compiler
+ * Copyright (C) 2025  Saladin5101
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "fcef/eclc_fcef.h"
+#include "eclc/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void *grow(void *ptr, size_t *capacity, size_t needed, size_t elem) {
+    if (needed <= *capacity) {
+        return ptr;
+    }
+    size_t cap = *capacity ? *capacity : 16;
+    while (cap < needed) {
+        cap *= 2;
+    }
+    void *new_ptr = xrealloc(ptr, cap * elem);
+    *capacity = cap;
+    return new_ptr;
+}
+
+uint32_t fcef_gnu_hash(const char *name) {
+    uint32_t h = 5381;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h = (h << 5) + h + *p;
+    }
+    return h;
+}
+
+uint32_t eclc_add_symbol(eclc_output_t *output, const char *name,
+                         fcef_section_t section, uint32_t value, uint32_t size,
+                         fcef_bind_t bind, fcef_symtype_t type) {
+    // Index 0 is the null symbol and string offset 0 the empty name, as in ELF
+    if (output->symbol_count == 0) {
+        output->symbols = grow(output->symbols, &output->symbol_capacity, 1, sizeof(fcef_symbol_t));
+        memset(&output->symbols[0], 0, sizeof(fcef_symbol_t));
+        output->symbol_count = 1;
+    }
+    if (output->strtab_size == 0) {
+        output->strtab = grow(output->strtab, &output->strtab_capacity, 1, 1);
+        output->strtab[0] = '\0';
+        output->strtab_size = 1;
+    }
+
+    size_t len = strlen(name) + 1;
+    output->strtab = grow(output->strtab, &output->strtab_capacity,
+                          output->strtab_size + len, 1);
+    memcpy(output->strtab + output->strtab_size, name, len);
+
+    output->symbols = grow(output->symbols, &output->symbol_capacity,
+                           output->symbol_count + 1, sizeof(fcef_symbol_t));
+    fcef_symbol_t *sym = &output->symbols[output->symbol_count];
+    sym->name = (uint32_t)output->strtab_size;
+    sym->value = value;
+    sym->size = size;
+    sym->section = (uint8_t)section;
+    sym->bind = (uint8_t)bind;
+    sym->type = (uint8_t)type;
+    sym->pad = 0;
+
+    output->strtab_size += len;
+    return (uint32_t)output->symbol_count++;
+}
+
+void eclc_add_reloc(eclc_output_t *output, fcef_section_t section,
+                    uint32_t offset, uint32_t symbol,
+                    fcef_reloc_type_t type, int32_t addend) {
+    output->relocs = grow(output->relocs, &output->reloc_capacity,
+                          output->reloc_count + 1, sizeof(fcef_reloc_t));
+    fcef_reloc_t *rel = &output->relocs[output->reloc_count++];
+    rel->offset = offset;
+    rel->symbol = symbol;
+    rel->addend = addend;
+    rel->section = (uint8_t)section;
+    rel->type = (uint8_t)type;
+    rel->pad = 0;
+}
+
+const char *eclc_symbol_name(const eclc_output_t *output, const fcef_symbol_t *sym) {
+    if (!output->strtab || sym->name >= output->strtab_size) {
+        return "";
+    }
+    return output->strtab + sym->name;
+}
+
+// Only defined, non-local symbols are reachable through the hash table
+static bool is_hashed(const fcef_symbol_t *sym) {
+    return sym->section != FCEF_SEC_UNDEF && sym->bind != FCEF_BIND_LOCAL;
+}
+
+typedef struct {
+    uint32_t bucket;
+    uint32_t hash;
+    uint32_t index;
+} hash_entry_t;
+
+static int compare_entries(const void *a, const void *b) {
+    const hash_entry_t *x = a;
+    const hash_entry_t *y = b;
+    if (x->bucket != y->bucket) return x->bucket < y->bucket ? -1 : 1;
+    if (x->index != y->index) return x->index < y->index ? -1 : 1;
+    return 0;
+}
+
+void eclc_finalize_symbols(eclc_output_t *output) {
+    if (!output || output->symbol_count == 0) {
+        return;
+    }
+
+    size_t count = output->symbol_count;
+    size_t hashed = 0;
+    for (size_t i = 1; i < count; i++) {
+        if (is_hashed(&output->symbols[i])) hashed++;
+    }
+
+    // About two symbols per bucket, and 8 bloom bits per symbol which puts
+    // the false positive rate of the two-bit filter near 5%
+    uint32_t nbuckets = (uint32_t)(hashed / 2) | 1;
+    size_t bloom_bits = 64;
+    uint32_t bloom_log2 = 6;
+    while (bloom_bits < hashed * 8) {
+        bloom_bits <<= 1;
+        bloom_log2++;
+    }
+    uint32_t bloom_size = (uint32_t)(bloom_bits / 64);
+
+    hash_entry_t *entries = xmalloc((hashed ? hashed : 1) * sizeof(hash_entry_t));
+    uint32_t *remap = xmalloc(count * sizeof(uint32_t));
+    fcef_symbol_t *sorted = xmalloc(count * sizeof(fcef_symbol_t));
+
+    // Unhashed symbols keep their order at the front of the table
+    size_t next = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const fcef_symbol_t *sym = &output->symbols[i];
+        if (i > 0 && is_hashed(sym)) {
+            uint32_t h = fcef_gnu_hash(eclc_symbol_name(output, sym));
+            entries[n].bucket = h % nbuckets;
+            entries[n].hash = h;
+            entries[n].index = (uint32_t)i;
+            n++;
+        } else {
+            remap[i] = (uint32_t)next;
+            sorted[next++] = *sym;
+        }
+    }
+    uint32_t symoffset = (uint32_t)next;
+
+    qsort(entries, hashed, sizeof(hash_entry_t), compare_entries);
+
+    size_t hash_size = sizeof(fcef_gnu_hash_t) +
+                       bloom_size * sizeof(uint64_t) +
+                       nbuckets * sizeof(uint32_t) +
+                       hashed * sizeof(uint32_t);
+    uint8_t *blob = xcalloc(1, hash_size);
+    fcef_gnu_hash_t *header = (fcef_gnu_hash_t *)blob;
+    header->nbuckets = nbuckets;
+    header->symoffset = symoffset;
+    header->bloom_size = bloom_size;
+    header->bloom_shift = bloom_log2;
+    uint64_t *bloom = (uint64_t *)(header + 1);
+    uint32_t *buckets = (uint32_t *)(bloom + bloom_size);
+    uint32_t *chain = buckets + nbuckets;
+
+    for (size_t i = 0; i < hashed; i++) {
+        const hash_entry_t *e = &entries[i];
+        uint32_t index = (uint32_t)next;
+        remap[e->index] = index;
+        sorted[next++] = output->symbols[e->index];
+
+        bloom[(e->hash / 64) & (bloom_size - 1)] |=
+            (1ull << (e->hash % 64)) | (1ull << ((e->hash >> bloom_log2) % 64));
+        if (buckets[e->bucket] == 0) {
+            buckets[e->bucket] = index;
+        }
+        // Low bit marks the last entry of a bucket
+        bool last = i + 1 == hashed || entries[i + 1].bucket != e->bucket;
+        chain[index - symoffset] = (e->hash & ~1u) | (last ? 1u : 0u);
+    }
+
+    memcpy(output->symbols, sorted, count * sizeof(fcef_symbol_t));
+    for (size_t i = 0; i < output->reloc_count; i++) {
+        output->relocs[i].symbol = remap[output->relocs[i].symbol];
+    }
+
+    xfree(output->hash);
+    output->hash = blob;
+    output->hash_size = hash_size;
+
+    xfree(sorted);
+    xfree(remap);
+    xfree(entries);
+}
+
+long fcef_hash_lookup(const void *hash, const fcef_symbol_t *symbols,
+                      size_t symbol_count, const char *strtab, const char *name) {
+    const fcef_gnu_hash_t *header = hash;
+    const uint64_t *bloom = (const uint64_t *)(header + 1);
+    const uint32_t *buckets = (const uint32_t *)(bloom + header->bloom_size);
+    const uint32_t *chain = buckets + header->nbuckets;
+
+    uint32_t h = fcef_gnu_hash(name);
+    uint64_t word = bloom[(h / 64) & (header->bloom_size - 1)];
+    uint64_t mask = (1ull << (h % 64)) | (1ull << ((h >> header->bloom_shift) % 64));
+    if ((word & mask) != mask) {
+        return -1;
+    }
+
+    uint32_t index = buckets[h % header->nbuckets];
+    if (index == 0 || index < header->symoffset) {
+        return -1;
+    }
+
+    for (; index < symbol_count; index++) {
+        uint32_t entry = chain[index - header->symoffset];
+        if ((entry | 1u) == (h | 1u) &&
+            strcmp(strtab + symbols[index].name, name) == 0) {
+            return (long)index;
+        }
+        if (entry & 1u) {
+            break;
+        }
+    }
+    return -1;
+}
+
+long eclc_lookup_symbol(const eclc_output_t *output, const char *name) {
+    if (!output || output->symbol_count == 0) {
+        return -1;
+    }
+    if (output->hash) {
+        return fcef_hash_lookup(output->hash, output->symbols, output->symbol_count,
+                                output->strtab, name);
+    }
+    for (size_t i = 1; i < output->symbol_count; i++) {
+        const fcef_symbol_t *sym = &output->symbols[i];
+        if (is_hashed(sym) && strcmp(eclc_symbol_name(output, sym), name) == 0) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+bool eclc_apply_reloc(uint8_t *loc, uint32_t place, uint64_t target,
+                      fcef_reloc_type_t type) {
+    int64_t delta = (int64_t)target - (int64_t)place;
+    uint32_t insn = (uint32_t)loc[0] | ((uint32_t)loc[1] << 8) |
+                    ((uint32_t)loc[2] << 16) | ((uint32_t)loc[3] << 24);
+
+    switch (type) {
+        case FCEF_RELOC_CALL26:
+            if ((delta & 3) || delta < -(1ll << 27) || delta >= (1ll << 27)) {
+                return false;
+            }
+            insn = (insn & 0xFC000000u) | ((uint32_t)(delta >> 2) & 0x03FFFFFFu);
+            break;
+        case FCEF_RELOC_ADR21:
+            if (delta < -(1ll << 20) || delta >= (1ll << 20)) {
+                return false;
+            }
+            insn = (insn & 0x9F00001Fu) |
+                   (((uint32_t)delta & 3u) << 29) |
+                   ((((uint32_t)delta >> 2) & 0x7FFFFu) << 5);
+            break;
+        case FCEF_RELOC_ABS32:
+            if (target > 0xFFFFFFFFull) {
+                return false;
+            }
+            insn = (uint32_t)target;
+            break;
+        case FCEF_RELOC_ABS64:
+            for (int i = 0; i < 8; i++) {
+                loc[i] = (uint8_t)(target >> (8 * i));
+            }
+            return true;
+        default:
+            return false;
+    }
+
+    loc[0] = (uint8_t)insn;
+    loc[1] = (uint8_t)(insn >> 8);
+    loc[2] = (uint8_t)(insn >> 16);
+    loc[3] = (uint8_t)(insn >> 24);
+    return true;
+}
@@ -0,0 +1,89 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/error.h"
+#include <stdarg.h>
+#include <string.h>
+
+static __thread ErrorBuffer* capture;
+static __thread int reported;
+
+static void buffer_append(ErrorBuffer* buffer, const char* format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (len < 0) return;
+
+    size_t needed = buffer->size + (size_t)len + 1;
+    if (needed > buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        if (buffer->capacity < needed) buffer->capacity = needed;
+        buffer->text = xrealloc(buffer->text, buffer->capacity);
+    }
+    vsnprintf(buffer->text + buffer->size, (size_t)len + 1, format, args);
+    buffer->size += (size_t)len;
+}
+
+static void buffer_printf(ErrorBuffer* buffer, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    buffer_append(buffer, format, args);
+    va_end(args);
+}
+
+void error_report(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    reported++;
+    if (capture) {
+        buffer_printf(capture, "Error: ");
+        buffer_append(capture, format, args);
+        buffer_printf(capture, "\n");
+    } else {
+        fprintf(stderr, "Error: ");
+        vfprintf(stderr, format, args);
+        fprintf(stderr, "\n");
+    }
+    va_end(args);
+}
+
+int error_count(void) {
+    return reported;
+}
+
+void error_capture_begin(ErrorBuffer* buffer) {
+    capture = buffer;
+}
+
+void error_capture_end(void) {
+    capture = NULL;
+}
+
+void error_buffer_flush(ErrorBuffer* buffer, FILE* out) {
+    if (buffer->size > 0) {
+        fwrite(buffer->text, 1, buffer->size, out);
+        fflush(out);
+    }
+    buffer->size = 0;
+}
+
+void error_buffer_free(ErrorBuffer* buffer) {
+    xfree(buffer->text);
+    buffer->text = NULL;
+    buffer->size = buffer->capacity = 0;
+}
@@ -18,18 +18,21 @@
  */
 #include "eclc/token.h"
 #include "eclc/common.h"
+#include "eclc/error.h"
+#include "eclc/intern.h"
 #include <ctype.h>
 #include <string.h>
 #include <stdio.h>
 
 static bool is_identifier_char(char c) {
-    return isalnum(c) || c == '_';
+    return isalnum((unsigned char)c) || c == '_';
 }
 
-static Token* create_token(TokenType type, const char* value, int line, int column) {
+// Token text is interned, so it outlives the stream and repeats share one copy
+static Token* create_token(TokenType type, const char* text, size_t length, int line, int column) {
     Token* token = xmalloc(sizeof(Token));
     token->type = type;
-    token->value = value ? strcmp(value,value) : NULL;
+    token->value = text ? intern(text, length) : NULL;
     token->line = line;
     token->column = column;
     return token;
@@ -54,7 +57,7 @@ TokenStream* tokenize(const char* source) {
         char c = source[pos];
         
         // Skip space char
-        if (isspace(c)) {
+        if (isspace((unsigned char)c)) {
             if (c == '\n') {
                 line++;
                 column = 1;
@@ -83,12 +86,8 @@ TokenStream* tokenize(const char* source) {
                 column++;
             }
             int length = pos - start;
-            char* value = xmalloc(length + 1);
-            strncpy(value, source + start, length);
-            value[length] = '\0';
             
-            token_stream_add(stream, create_token(TOK_STRING, value, line, column - length));
-            xfree(value);
+            token_stream_add(stream, create_token(TOK_STRING, source + start, length, line, column - length));
             continue;
         }
         
@@ -108,12 +107,8 @@ TokenStream* tokenize(const char* source) {
                 column++;
             }
             int length = pos - start;
-            char* value = xmalloc(length + 1);
-            strncpy(value, source + start, length);
-            value[length] = '\0';
             
-            token_stream_add(stream, create_token(TOK_CHAR, value, line, column - length));
-            xfree(value);
+            token_stream_add(stream, create_token(TOK_CHAR, source + start, length, line, column - length));
             continue;
         }
         
@@ -147,71 +142,63 @@ TokenStream* tokenize(const char* source) {
         }
         
         // Know number digit
-        if (isdigit(c)) {
+        if (isdigit((unsigned char)c)) {
             int start = pos;
-            while (isdigit(source[pos])) {
+            while (isdigit((unsigned char)source[pos])) {
                 pos++;
                 column++;
             }
             int length = pos - start;
-            char* value = xmalloc(length + 1);
-            strncpy(value, source + start, length);
-            value[length] = '\0';
             
-            token_stream_add(stream, create_token(TOK_INTEGER, value, line, column - length));
-            xfree(value);
+            token_stream_add(stream, create_token(TOK_INTEGER, source + start, length, line, column - length));
             continue;
         }
         
         // Type and keywords
-        if (isalpha(c) || c == '_') {
+        if (isalpha((unsigned char)c) || c == '_') {
             int start = pos;
             while (is_identifier_char(source[pos])) {
                 pos++;
                 column++;
             }
             int length = pos - start;
-            char* value = xmalloc(length + 1);
-            strncpy(value, source + start, length);
-            value[length] = '\0';
             
             // Check Keywords
             TokenType type = TOK_IDENTIFIER;
-            if (strcmp(value, "int") == 0) type = TOK_INT;
-            else if (strcmp(value, "return") == 0) type = TOK_RETURN;
+            if (length == 3 && strncmp(source + start, "int", 3) == 0) type = TOK_INT;
+            else if (length == 6 && strncmp(source + start, "return", 6) == 0) type = TOK_RETURN;
             
-            token_stream_add(stream, create_token(type, value, line, column - length));
-            xfree(value);
+            token_stream_add(stream, create_token(type, source + start, length, line, column - length));
             continue;
         }
         
         // Multi-character operators
         if (c == '=' && source[pos + 1] == '=') {
-            token_stream_add(stream, create_token(TOK_EQ, "==", line, column));
+            token_stream_add(stream, create_token(TOK_EQ, "==", 2, line, column));
             pos += 2;
             column += 2;
             continue;
         }
         if (c == '!' && source[pos + 1] == '=') {
-            token_stream_add(stream, create_token(TOK_NE, "!=", line, column));
+            token_stream_add(stream, create_token(TOK_NE, "!=", 2, line, column));
             pos += 2;
             column += 2;
             continue;
         }
         if (c == '<' && source[pos + 1] == '=') {
-            token_stream_add(stream, create_token(TOK_LE, "<=", line, column));
+            token_stream_add(stream, create_token(TOK_LE, "<=", 2, line, column));
             pos += 2;
             column += 2;
             continue;
         }
         if (c == '>' && source[pos + 1] == '=') {
-            token_stream_add(stream, create_token(TOK_GE, ">=", line, column));
+            token_stream_add(stream, create_token(TOK_GE, ">=", 2, line, column));
             pos += 2;
             column += 2;
             continue;
         }
         if (c == '-' && source[pos + 1] == '>') {
-            token_stream_add(stream, create_token(TOK_ARROW, "->", line, column));
+            token_stream_add(stream, create_token(TOK_ARROW, "->", 2, line, column));
             pos += 2;
             column += 2;
             continue;
@@ -246,14 +233,13 @@ TokenStream* tokenize(const char* source) {
             case '>': type = TOK_GT; break;
             case '#': type = TOK_HASH; break;
             default:
-                fprintf(stderr, "Error: Unknown character '%c' at line %d, column %d\n", 
-                       c, line, column);
+                error_report("Unknown character '%c' at line %d, column %d",
+                             c, line, column);
                 type = TOK_ERROR;
         }
         
         if (type != TOK_ERROR) {
-            char char_str[2] = {c, '\0'};
-            token_stream_add(stream, create_token(type, char_str, line, column));
+            token_stream_add(stream, create_token(type, source + pos, 1, line, column));
         }
         
         pos++;
@@ -261,16 +247,11 @@ TokenStream* tokenize(const char* source) {
     }
     
     // Add EOF token
-    token_stream_add(stream, create_token(TOK_EOF, NULL, line, column));
+    token_stream_add(stream, create_token(TOK_EOF, NULL, 0, line, column));
     return stream;
 }
 
 void token_stream_free(TokenStream* stream) {
-    for (size_t i = 0; i < stream->count; i++) {
-        if (stream->tokens[i].value) {
-            xfree(stream->tokens[i].value);
-        }
-    }
     xfree(stream->tokens);
     xfree(stream);
 }
@@ -18,6 +18,8 @@
  */
 #include "eclc/ast.h"
 #include "eclc/common.h"
+#include "eclc/error.h"
+#include "eclc/hash.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -81,6 +83,30 @@ static ASTNode* parse_identifier(Parser* parser) {
     return node;
 }
 
+// Parse primary expression: <integer> | <identifier>()
+static ASTNode* parse_expression(Parser* parser) {
+    if (match(parser, TOK_INTEGER)) {
+        return parse_integer(parser);
+    }
+    
+    ASTNode* ident = parse_identifier(parser);
+    if (!ident) {
+        return NULL;
+    }
+    
+    if (!consume(parser, TOK_LPAREN)) {
+        return ident;
+    }
+    
+    if (!consume(parser, TOK_RPAREN)) {
+        error_report("Expected ')' after call arguments");
+        return NULL;
+    }
+    
+    ident->type = NODE_CALL_EXPR;
+    return ident;
+}
+
 // Parse return statement: return <expression>;
 static ASTNode* parse_return_stmt(Parser* parser) {
     if (!consume(parser, TOK_RETURN)) {
@@ -90,11 +116,11 @@ static ASTNode* parse_return_stmt(Parser* parser) {
     Token return_token = parser->tokens->tokens[parser->current_pos - 1];
     ASTNode* node = create_node(NODE_RETURN_STMT, return_token);
     
-    // Parse return value (integer for now)
-    node->left = parse_integer(parser);
+    // Parse return value
+    node->left = parse_expression(parser);
     
     if (!consume(parser, TOK_SEMICOLON)) {
-        fprintf(stderr, "Error: Expected ';' after return statement\n");
+        error_report("Expected ';' after return statement");
         return NULL;
     }
     
@@ -111,22 +137,37 @@ static ASTNode* parse_block(Parser* parser) {
     ASTNode* stmt = parse_return_stmt(parser);
     
     if (!consume(parser, TOK_RBRACE)) {
-        fprintf(stderr, "Error: Expected '}' to close block\n");
+        error_report("Expected '}' to close block");
         return NULL;
     }
     
     return stmt;
 }
 
+// Kinds and spellings of tokens [start, end), so that moving a function
+// around the file or reformatting it keeps its hash
+static u64 hash_tokens(const Parser* parser, int start, int end) {
+    u64 hash = 0;
+    for (int i = start; i < end; i++) {
+        const Token* token = &parser->tokens->tokens[i];
+        hash = eclc_hash_combine(hash, (u64)token->type);
+        if (token->value) {
+            hash = eclc_hash64(token->value, strlen(token->value), hash);
+        }
+    }
+    return hash;
+}
+
 // Parse function definition: int <name>() { <body> }
 static ASTNode* parse_function(Parser* parser) {
+    int start = parser->current_pos;
     if (!consume(parser, TOK_INT)) {
         return NULL;
     }
     
     Token* name_token = current_token(parser);
     if (!name_token || name_token->type != TOK_IDENTIFIER) {
-        fprintf(stderr, "Error: Expected function name\n");
+        error_report("Expected function name");
         return NULL;
     }
     
@@ -134,17 +175,18 @@ static ASTNode* parse_function(Parser* parser) {
     advance(parser);
     
     if (!consume(parser, TOK_LPAREN)) {
-        fprintf(stderr, "Error: Expected '(' after function name\n");
+        error_report("Expected '(' after function name");
         return NULL;
     }
     
     if (!consume(parser, TOK_RPAREN)) {
-        fprintf(stderr, "Error: Expected ')' after parameters\n");
+        error_report("Expected ')' after parameters");
         return NULL;
     }
     
     // Parse function body
     node->left = parse_block(parser);
+    node->hash = hash_tokens(parser, start, parser->current_pos);
     
     return node;
 }
@@ -154,8 +196,20 @@ static ASTNode* parse_program(Parser* parser) {
     Token dummy_token = {0};
     ASTNode* program = create_node(NODE_PROGRAM, dummy_token);
     
-    // Parse single function for now
-    program->left = parse_function(parser);
+    // Functions are chained through their right pointer
+    ASTNode** tail = &program->left;
+    while (!match(parser, TOK_EOF) && current_token(parser)) {
+        if (!match(parser, TOK_INT)) {
+            error_report("Expected function definition at line %d", current_token(parser)->line);
+            break;
+        }
+        ASTNode* function = parse_function(parser);
+        if (!function) {
+            break;
+        }
+        *tail = function;
+        tail = &function->right;
+    }
     
     return program;
 }
@@ -165,7 +219,7 @@ Parser* parser_create(TokenStream* tokens, const char* filename) {
     Parser* parser = xcalloc(1, sizeof(Parser));
     parser->tokens = tokens;
     parser->current_pos = 0;
-    parser->filename = filename ? strdup(filename) : NULL;
+    parser->filename = filename ? xstrdup(filename) : NULL;
     return parser;
 }
 
@@ -211,6 +265,9 @@ void ast_print(ASTNode* node, int indent) {
         case NODE_IDENTIFIER:
             printf("Identifier: %s\n", node->token.value);
             break;
+        case NODE_CALL_EXPR:
+            printf("Call: %s()\n", node->token.value);
+            break;
         default:
             printf("Unknown node\n");
     }
@@ -0,0 +1,1242 @@
+/**
+    ECLC - E-comOS C/C++ Language Compiler
+    Copyright (C) 2025  Saladin5101
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "eclc/link.h"
+#include "eclc/codegen.h"
+#include "eclc/hash.h"
+#include "eclc/inliner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Symbol resolution and rodata merging are split into partitions by hash,
+// each partition is owned by one task so no locking is needed
+#define LINK_PARTITIONS 64
+#define LINK_PAGE_SIZE  0x1000u
+#define NO_OBJECT       UINT32_MAX
+#define ICF_MAX_ROUNDS  8
+
+typedef struct {
+    uint32_t object;
+    uint32_t symbol;
+} SymbolRef;
+
+// A piece of a section that moves as a unit: one function, one rodata
+// object, or the bytes between them. Everything is laid out atom by atom.
+typedef struct {
+    uint32_t object;
+    uint8_t section;
+    bool function;              // Exactly one function, an ICF candidate
+    bool mergeable;             // Local rodata object, deduplicated by content
+    bool live;                  // Reachable from the entry point
+    bool address_taken;         // Referenced other than by a call
+    uint32_t start;
+    uint32_t size;
+    uint32_t align;
+    uint32_t reloc_begin;       // Range in LinkObject.relocs_sorted
+    uint32_t reloc_end;
+    u64 hash;                   // Content hash, or ICF class
+    uint32_t leader;            // Global index of the atom holding the bytes
+    uint32_t body;              // Global index of the atom whose code and relocations
+                                // this one uses; itself unless a callee was inlined
+    uint32_t out_offset;        // Offset in the output section
+} Atom;
+
+typedef enum {
+    LINK_ERR_UNDEFINED,
+    LINK_ERR_DUPLICATE,
+    LINK_ERR_RANGE
+} LinkErrorKind;
+
+typedef struct {
+    LinkErrorKind kind;
+    uint32_t object;
+    uint32_t symbol;
+    uint32_t other;             // Previous definition for duplicates
+} LinkError;
+
+typedef struct {
+    LinkError* items;
+    size_t count;
+    size_t capacity;
+} ErrorList;
+
+typedef struct {
+    const LinkInput* input;
+    uint32_t* hashes;           // GNU hash of every non-local symbol
+    SymbolRef* refs;            // Definition each symbol resolves to
+    uint32_t* addr;             // Final address of each defined symbol
+    uint32_t* sym_atom;         // Local atom index of each defined symbol
+    uint32_t* relocs_sorted;    // Relocation indices by section and offset
+    uint32_t* symbols_by_part;  // Non-local symbols grouped by partition
+    uint32_t sym_part[LINK_PARTITIONS + 1];
+    Atom* atoms;                // Sorted by section, then offset
+    size_t atom_count;
+    size_t atom_base;
+    uint32_t sec_begin[FCEF_SEC_BSS + 1];
+    uint32_t sec_end[FCEF_SEC_BSS + 1];
+    uint32_t* atoms_by_part;    // Mergeable atoms grouped by partition
+    uint32_t atom_part[LINK_PARTITIONS + 1];
+    uint32_t bss_offset;
+    ErrorList errors;
+} LinkObject;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t index;             // Atom index, or 0 for symbols; NO_OBJECT when empty
+    SymbolRef ref;
+} Slot;
+
+typedef struct {
+    Slot* slots;
+    size_t capacity;
+    size_t used;
+    ErrorList errors;
+} Partition;
+
+typedef struct {
+    LinkObject* objects;
+    size_t count;
+    Partition parts[LINK_PARTITIONS];
+    Atom** atoms;               // All atoms in object order
+    size_t atom_count;
+    uint32_t entry_atom;
+    eclc_output_t* out;
+    uint32_t bss_addr;
+} Linker;
+
+static void error_add(ErrorList* list, LinkErrorKind kind,
+                      uint32_t object, uint32_t symbol, uint32_t other) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        list->items = xrealloc(list->items, list->capacity * sizeof(LinkError));
+    }
+    LinkError* e = &list->items[list->count++];
+    e->kind = kind;
+    e->object = object;
+    e->symbol = symbol;
+    e->other = other;
+}
+
+static uint32_t align_up(uint32_t value, uint32_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+static const eclc_output_t* object_of(const Linker* ld, uint32_t object) {
+    return ld->objects[object].input->object;
+}
+
+static const char* symbol_name(const Linker* ld, SymbolRef ref) {
+    const eclc_output_t* obj = object_of(ld, ref.object);
+    return eclc_symbol_name(obj, &obj->symbols[ref.symbol]);
+}
+
+static const uint8_t* section_bytes(const eclc_output_t* obj, uint8_t section) {
+    switch (section) {
+        case FCEF_SEC_TEXT: return obj->code;
+        case FCEF_SEC_RODATA: return obj->rodata;
+        case FCEF_SEC_DATA: return obj->data;
+        default: return NULL;
+    }
+}
+
+static size_t section_size(const eclc_output_t* obj, uint8_t section) {
+    switch (section) {
+        case FCEF_SEC_TEXT: return obj->code_size;
+        case FCEF_SEC_RODATA: return obj->rodata_size;
+        case FCEF_SEC_DATA: return obj->data_size;
+        case FCEF_SEC_BSS: return obj->bss_size;
+        default: return 0;
+    }
+}
+
+// Atom whose code and relocations stand in for `atom`
+static const Atom* atom_code(const Linker* ld, const Atom* atom) {
+    return ld->atoms[atom->body];
+}
+
+static const uint8_t* atom_bytes(const Linker* ld, const Atom* atom) {
+    atom = atom_code(ld, atom);
+    return section_bytes(object_of(ld, atom->object), atom->section) + atom->start;
+}
+
+// ==================== Phase 1: per-object scan ====================
+
+typedef struct {
+    uint32_t value;
+    uint32_t size;
+    uint8_t bind;
+    uint8_t type;
+} SectionSymbol;
+
+static int compare_section_symbols(const void* a, const void* b) {
+    const SectionSymbol* x = a;
+    const SectionSymbol* y = b;
+    return x->value < y->value ? -1 : x->value > y->value;
+}
+
+// Index sorted by a precomputed key; ties keep input order. The key sits
+// next to the index so the comparator needs no shared state.
+typedef struct {
+    u64 key;
+    uint32_t index;
+} SortKey;
+
+static int compare_sort_keys(const void* a, const void* b) {
+    const SortKey* x = a;
+    const SortKey* y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+static void sort_by_key(SortKey* keys, uint32_t* order, size_t count) {
+    qsort(keys, count, sizeof(SortKey), compare_sort_keys);
+    for (size_t k = 0; k < count; k++) {
+        order[k] = keys[k].index;
+    }
+}
+
+// Relocations by section, then offset
+static void sort_relocs(const eclc_output_t* obj, uint32_t* order, size_t count) {
+    SortKey* keys = xmalloc((count + 1) * sizeof(SortKey));
+    for (size_t r = 0; r < count; r++) {
+        const fcef_reloc_t* rel = &obj->relocs[r];
+        keys[r].key = (u64)rel->section << 32 | rel->offset;
+        keys[r].index = (uint32_t)r;
+    }
+    sort_by_key(keys, order, count);
+    xfree(keys);
+}
+
+// Split one section at symbol boundaries
+static void split_section(LinkObject* lo, uint32_t index, uint8_t section,
+                          SectionSymbol* syms, uint32_t* next_reloc) {
+    const eclc_output_t* obj = lo->input->object;
+    size_t size = section_size(obj, section);
+    uint32_t max_align = section == FCEF_SEC_TEXT ? 4 : section == FCEF_SEC_DATA ? 8 : 16;
+
+    size_t n = 0;
+    syms[n].value = 0;          // Sentinel so the section start is always a boundary
+    syms[n].size = 0;
+    syms[n].bind = FCEF_BIND_LOCAL;
+    syms[n].type = FCEF_SYM_NOTYPE;
+    n++;
+    for (size_t s = 1; s < obj->symbol_count; s++) {
+        const fcef_symbol_t* sym = &obj->symbols[s];
+        if (sym->section == section && sym->value < size && sym->type != FCEF_SYM_NOTYPE) {
+            syms[n].value = sym->value;
+            syms[n].size = sym->size;
+            syms[n].bind = sym->bind;
+            syms[n].type = sym->type;
+            n++;
+        }
+    }
+    qsort(syms, n, sizeof(SectionSymbol), compare_section_symbols);
+
+    lo->sec_begin[section] = (uint32_t)lo->atom_count;
+    for (size_t i = 0; i < n;) {
+        size_t first = i;
+        uint32_t start = syms[i].value;
+        while (i < n && syms[i].value == start) i++;
+        uint32_t end = i < n ? syms[i].value : (uint32_t)size;
+        if (end == start) continue;
+
+        Atom* atom = &lo->atoms[lo->atom_count++];
+        atom->object = index;
+        atom->section = section;
+        atom->live = true;
+        atom->start = start;
+        atom->size = end - start;
+        atom->align = 1;
+        while (atom->align < max_align && !(start & atom->align)) {
+            atom->align <<= 1;
+        }
+
+        // Relocations patching this atom
+        while (*next_reloc < obj->reloc_count) {
+            const fcef_reloc_t* rel = &obj->relocs[lo->relocs_sorted[*next_reloc]];
+            if (rel->section > section || (rel->section == section && rel->offset >= start)) break;
+            (*next_reloc)++;
+        }
+        atom->reloc_begin = *next_reloc;
+        while (*next_reloc < obj->reloc_count) {
+            const fcef_reloc_t* rel = &obj->relocs[lo->relocs_sorted[*next_reloc]];
+            if (rel->section != section || rel->offset >= end) break;
+            (*next_reloc)++;
+        }
+        atom->reloc_end = *next_reloc;
+
+        bool exact_local = false;
+        bool exported = false;
+        for (size_t k = first; k < i; k++) {
+            if (syms[k].type == FCEF_SYM_NOTYPE) continue;  // Sentinel
+            if (syms[k].bind != FCEF_BIND_LOCAL) exported = true;
+            else if (syms[k].size == atom->size) exact_local = true;
+            if (syms[k].type == FCEF_SYM_FUNC && syms[k].size == atom->size) {
+                atom->function = section == FCEF_SEC_TEXT;
+            }
+        }
+        if (section == FCEF_SEC_RODATA) {
+            atom->mergeable = exact_local && !exported && atom->reloc_begin == atom->reloc_end;
+            if (atom->mergeable) {
+                atom->hash = eclc_hash64(obj->rodata + start, atom->size, atom->size);
+            }
+        }
+    }
+    lo->sec_end[section] = (uint32_t)lo->atom_count;
+}
+
+static void build_atoms(LinkObject* lo, uint32_t index) {
+    const eclc_output_t* obj = lo->input->object;
+
+    lo->relocs_sorted = xmalloc((obj->reloc_count + 1) * sizeof(uint32_t));
+    sort_relocs(obj, lo->relocs_sorted, obj->reloc_count);
+
+    SectionSymbol* syms = xmalloc((obj->symbol_count + 1) * sizeof(SectionSymbol));
+    lo->atoms = xcalloc(obj->symbol_count * 3 + 3, sizeof(Atom));
+    uint32_t next_reloc = 0;
+    split_section(lo, index, FCEF_SEC_TEXT, syms, &next_reloc);
+    split_section(lo, index, FCEF_SEC_RODATA, syms, &next_reloc);
+    split_section(lo, index, FCEF_SEC_DATA, syms, &next_reloc);
+    xfree(syms);
+}
+
+// Binary search for the atom covering `offset` in `section`, or NO_OBJECT
+static uint32_t find_atom(const LinkObject* lo, uint8_t section, uint32_t offset) {
+    if (section == FCEF_SEC_UNDEF || section > FCEF_SEC_DATA) return NO_OBJECT;
+    uint32_t lo_i = lo->sec_begin[section];
+    uint32_t hi = lo->sec_end[section];
+    if (lo_i == hi) return NO_OBJECT;
+    while (hi - lo_i > 1) {
+        uint32_t mid = (lo_i + hi) / 2;
+        if (lo->atoms[mid].start <= offset) lo_i = mid;
+        else hi = mid;
+    }
+    return lo_i;
+}
+
+static void scan_object(void* ctx, size_t i) {
+    Linker* ld = ctx;
+    LinkObject* lo = &ld->objects[i];
+    const eclc_output_t* obj = lo->input->object;
+    size_t count = obj->symbol_count;
+
+    lo->hashes = xcalloc(count ? count : 1, sizeof(uint32_t));
+    lo->refs = xcalloc(count ? count : 1, sizeof(SymbolRef));
+    lo->addr = xcalloc(count ? count : 1, sizeof(uint32_t));
+    lo->sym_atom = xcalloc(count ? count : 1, sizeof(uint32_t));
+    build_atoms(lo, (uint32_t)i);
+
+    for (size_t s = 0; s < count; s++) {
+        const fcef_symbol_t* sym = &obj->symbols[s];
+        lo->refs[s].object = (uint32_t)i;
+        lo->refs[s].symbol = (uint32_t)s;
+        lo->sym_atom[s] = find_atom(lo, sym->section, sym->value);
+        if (s > 0 && sym->bind != FCEF_BIND_LOCAL) {
+            lo->hashes[s] = fcef_gnu_hash(eclc_symbol_name(obj, sym));
+        }
+    }
+
+    // Counting sort by partition keeps each slice in index order, so a
+    // partition walks only its own entries and still sees them in input order
+    uint32_t* sym_part = lo->sym_part;
+    for (size_t s = 1; s < count; s++) {
+        if (obj->symbols[s].bind != FCEF_BIND_LOCAL) {
+            sym_part[lo->hashes[s] % LINK_PARTITIONS + 1]++;
+        }
+    }
+    for (size_t p = 0; p < LINK_PARTITIONS; p++) {
+        sym_part[p + 1] += sym_part[p];
+    }
+    lo->symbols_by_part = xmalloc((sym_part[LINK_PARTITIONS] + 1) * sizeof(uint32_t));
+    uint32_t fill[LINK_PARTITIONS];
+    memcpy(fill, sym_part, sizeof(fill));
+    for (size_t s = 1; s < count; s++) {
+        if (obj->symbols[s].bind != FCEF_BIND_LOCAL) {
+            lo->symbols_by_part[fill[lo->hashes[s] % LINK_PARTITIONS]++] = (uint32_t)s;
+        }
+    }
+
+    uint32_t* atom_part = lo->atom_part;
+    for (size_t a = 0; a < lo->atom_count; a++) {
+        if (lo->atoms[a].mergeable) {
+            atom_part[lo->atoms[a].hash % LINK_PARTITIONS + 1]++;
+        }
+    }
+    for (size_t p = 0; p < LINK_PARTITIONS; p++) {
+        atom_part[p + 1] += atom_part[p];
+    }
+    lo->atoms_by_part = xmalloc((atom_part[LINK_PARTITIONS] + 1) * sizeof(uint32_t));
+    memcpy(fill, atom_part, sizeof(fill));
+    for (size_t a = 0; a < lo->atom_count; a++) {
+        if (lo->atoms[a].mergeable) {
+            lo->atoms_by_part[fill[lo->atoms[a].hash % LINK_PARTITIONS]++] = (uint32_t)a;
+        }
+    }
+}
+
+
+// ==================== Phase 2: symbol resolution ====================
+
+static Slot* table_find(Partition* part, const Linker* ld, uint32_t hash, const char* name) {
+    size_t mask = part->capacity - 1;
+    for (size_t i = (hash / LINK_PARTITIONS) & mask;; i = (i + 1) & mask) {
+        Slot* slot = &part->slots[i];
+        if (slot->index == NO_OBJECT) return slot;
+        if (slot->hash == hash && strcmp(symbol_name(ld, slot->ref), name) == 0) {
+            return slot;
+        }
+    }
+}
+
+static void table_grow(Partition* part, const Linker* ld) {
+    Slot* old = part->slots;
+    size_t old_capacity = part->capacity;
+
+    part->capacity = old_capacity ? old_capacity * 2 : 64;
+    part->slots = xmalloc(part->capacity * sizeof(Slot));
+    for (size_t i = 0; i < part->capacity; i++) {
+        part->slots[i].index = NO_OBJECT;
+    }
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].index == NO_OBJECT) continue;
+        *table_find(part, ld, old[i].hash, symbol_name(ld, old[i].ref)) = old[i];
+    }
+    xfree(old);
+}
+
+static void resolve_partition(void* ctx, size_t p) {
+    Linker* ld = ctx;
+    Partition* part = &ld->parts[p];
+
+    // Definitions first, in object order, so the winner is deterministic
+    for (size_t o = 0; o < ld->count; o++) {
+        const LinkObject* lo = &ld->objects[o];
+        const eclc_output_t* obj = lo->input->object;
+        for (uint32_t k = lo->sym_part[p]; k < lo->sym_part[p + 1]; k++) {
+            uint32_t s = lo->symbols_by_part[k];
+            const fcef_symbol_t* sym = &obj->symbols[s];
+            if (sym->section == FCEF_SEC_UNDEF) continue;
+
+            if ((part->used + 1) * 2 > part->capacity) {
+                table_grow(part, ld);
+            }
+            Slot* slot = table_find(part, ld, lo->hashes[s], eclc_symbol_name(obj, sym));
+            SymbolRef ref = { (uint32_t)o, s };
+            if (slot->index == NO_OBJECT) {
+                slot->hash = lo->hashes[s];
+                slot->index = 0;
+                slot->ref = ref;
+                part->used++;
+                continue;
+            }
+            const fcef_symbol_t* prev = &object_of(ld, slot->ref.object)->symbols[slot->ref.symbol];
+            if (prev->bind == FCEF_BIND_WEAK && sym->bind == FCEF_BIND_GLOBAL) {
+                slot->ref = ref;
+            } else if (prev->bind == FCEF_BIND_GLOBAL && sym->bind == FCEF_BIND_GLOBAL) {
+                error_add(&part->errors, LINK_ERR_DUPLICATE, ref.object, ref.symbol,
+                          slot->ref.object);
+            }
+        }
+    }
+
+    // Then point every non-local symbol at its definition
+    for (size_t o = 0; o < ld->count; o++) {
+        LinkObject* lo = &ld->objects[o];
+        const eclc_output_t* obj = lo->input->object;
+        for (uint32_t k = lo->sym_part[p]; k < lo->sym_part[p + 1]; k++) {
+            uint32_t s = lo->symbols_by_part[k];
+            const fcef_symbol_t* sym = &obj->symbols[s];
+
+            Slot* slot = part->capacity
+                ? table_find(part, ld, lo->hashes[s], eclc_symbol_name(obj, sym))
+                : NULL;
+            if (slot && slot->index != NO_OBJECT) {
+                lo->refs[s] = slot->ref;
+            } else if (sym->bind == FCEF_BIND_WEAK) {
+                lo->refs[s].object = NO_OBJECT;     // Undefined weak resolves to 0
+            } else {
+                error_add(&part->errors, LINK_ERR_UNDEFINED, (uint32_t)o, s, 0);
+            }
+        }
+    }
+}
+
+
+// ==================== Phase 3: rodata deduplication ====================
+
+typedef struct {
+    Slot* slots;
+    size_t capacity;
+    size_t used;
+} AtomTable;
+
+static void atom_table_grow(AtomTable* table, const Linker* ld) {
+    Slot* old = table->slots;
+    size_t old_capacity = table->capacity;
+
+    table->capacity = old_capacity ? old_capacity * 2 : 64;
+    table->slots = xmalloc(table->capacity * sizeof(Slot));
+    for (size_t k = 0; k < table->capacity; k++) {
+        table->slots[k].index = NO_OBJECT;
+    }
+    size_t mask = table->capacity - 1;
+    for (size_t k = 0; k < old_capacity; k++) {
+        if (old[k].index == NO_OBJECT) continue;
+        size_t j = (ld->atoms[old[k].index]->hash / LINK_PARTITIONS) & mask;
+        while (table->slots[j].index != NO_OBJECT) j = (j + 1) & mask;
+        table->slots[j] = old[k];
+    }
+    xfree(old);
+}
+
+// First atom with given contents becomes the leader of all later copies
+static void merge_atom(AtomTable* table, const Linker* ld, uint32_t index) {
+    Atom* atom = ld->atoms[index];
+    if ((table->used + 1) * 2 > table->capacity) {
+        atom_table_grow(table, ld);
+    }
+
+    size_t mask = table->capacity - 1;
+    for (size_t j = (atom->hash / LINK_PARTITIONS) & mask;; j = (j + 1) & mask) {
+        Slot* slot = &table->slots[j];
+        if (slot->index == NO_OBJECT) {
+            slot->index = index;
+            table->used++;
+            return;
+        }
+        const Atom* other = ld->atoms[slot->index];
+        if (other->hash == atom->hash && other->size == atom->size &&
+            memcmp(atom_bytes(ld, other), atom_bytes(ld, atom), atom->size) == 0) {
+            atom->leader = slot->index;
+            return;
+        }
+    }
+}
+
+static void merge_partition(void* ctx, size_t p) {
+    Linker* ld = ctx;
+    AtomTable table = {0};
+
+    for (size_t o = 0; o < ld->count; o++) {
+        const LinkObject* lo = &ld->objects[o];
+        for (uint32_t k = lo->atom_part[p]; k < lo->atom_part[p + 1]; k++) {
+            merge_atom(&table, ld, (uint32_t)(lo->atom_base + lo->atoms_by_part[k]));
+        }
+    }
+    xfree(table.slots);
+}
+
+
+// ==================== Phase 4: reachability and code folding ====================
+
+// Global atom a relocation points at, and the offset into it
+static uint32_t reloc_target(const Linker* ld, const LinkObject* lo,
+                             const fcef_reloc_t* rel, int64_t* delta) {
+    if (rel->symbol >= lo->input->object->symbol_count) return NO_OBJECT;
+    SymbolRef ref = lo->refs[rel->symbol];
+    if (ref.object == NO_OBJECT) return NO_OBJECT;
+
+    const LinkObject* def = &ld->objects[ref.object];
+    uint32_t local = def->sym_atom[ref.symbol];
+    if (local == NO_OBJECT) return NO_OBJECT;
+    if (delta) {
+        const fcef_symbol_t* sym = &object_of(ld, ref.object)->symbols[ref.symbol];
+        *delta = (int64_t)sym->value - def->atoms[local].start + rel->addend;
+    }
+    return (uint32_t)(def->atom_base + local);
+}
+
+static const fcef_reloc_t* atom_reloc(const Linker* ld, const Atom* atom, uint32_t r) {
+    const LinkObject* lo = &ld->objects[atom->object];
+    return &lo->input->object->relocs[lo->relocs_sorted[r]];
+}
+
+static bool find_entry(Linker* ld, const char* entry) {
+    uint32_t hash = fcef_gnu_hash(entry);
+    uint32_t p = hash % LINK_PARTITIONS;
+    for (size_t o = 0; o < ld->count; o++) {
+        const LinkObject* lo = &ld->objects[o];
+        const eclc_output_t* obj = lo->input->object;
+        for (uint32_t k = lo->sym_part[p]; k < lo->sym_part[p + 1]; k++) {
+            uint32_t s = lo->symbols_by_part[k];
+            const fcef_symbol_t* sym = &obj->symbols[s];
+            if (lo->hashes[s] != hash || sym->section != FCEF_SEC_TEXT) continue;
+            if (lo->refs[s].object != o || lo->refs[s].symbol != s) continue;
+            if (strcmp(eclc_symbol_name(obj, sym), entry) != 0) continue;
+            if (lo->sym_atom[s] == NO_OBJECT) return false;
+            ld->entry_atom = (uint32_t)(lo->atom_base + lo->sym_atom[s]);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void mark_live(Linker* ld, uint32_t index, uint32_t* stack, size_t* top) {
+    Atom* atom = ld->atoms[index];
+    if (!atom->live) {
+        atom->live = true;
+        stack[(*top)++] = index;
+    }
+    // A merged rodata copy needs the bytes of its leader
+    Atom* leader = ld->atoms[atom->leader];
+    if (!leader->live) {
+        leader->live = true;
+        stack[(*top)++] = atom->leader;
+    }
+}
+
+// Keep only atoms reachable from the entry point through relocations
+static void collect_garbage(Linker* ld, LinkStats* stats) {
+    for (size_t i = 0; i < ld->atom_count; i++) {
+        ld->atoms[i]->live = false;
+    }
+
+    uint32_t* stack = xmalloc((ld->atom_count * 2 + 1) * sizeof(uint32_t));
+    size_t top = 0;
+    mark_live(ld, ld->entry_atom, stack, &top);
+    while (top > 0) {
+        const Atom* atom = atom_code(ld, ld->atoms[stack[--top]]);
+        const LinkObject* lo = &ld->objects[atom->object];
+        for (uint32_t r = atom->reloc_begin; r < atom->reloc_end; r++) {
+            uint32_t target = reloc_target(ld, lo, atom_reloc(ld, atom, r), NULL);
+            if (target != NO_OBJECT) {
+                mark_live(ld, target, stack, &top);
+            }
+        }
+    }
+    xfree(stack);
+
+    for (size_t i = 0; i < ld->atom_count; i++) {
+        const Atom* atom = ld->atoms[i];
+        if (atom->live || atom->leader != i) continue;
+        stats->gc_atoms++;
+        stats->gc_bytes += atom->size;
+    }
+}
+
+static void mark_address_taken(void* ctx, size_t o) {
+    Linker* ld = ctx;
+    const LinkObject* lo = &ld->objects[o];
+    const eclc_output_t* obj = lo->input->object;
+    for (size_t r = 0; r < obj->reloc_count; r++) {
+        const fcef_reloc_t* rel = &obj->relocs[r];
+        if (rel->type == FCEF_RELOC_CALL26) continue;
+        uint32_t target = reloc_target(ld, lo, rel, NULL);
+        if (target != NO_OBJECT) {
+            __atomic_store_n(&ld->atoms[target]->address_taken, true, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Only functions whose address never escapes can share one body
+static bool icf_candidate(const Atom* atom) {
+    return atom->function && atom->live && !atom->address_taken;
+}
+
+static uint32_t reloc_width(const fcef_reloc_t* rel) {
+    return rel->type == FCEF_RELOC_ABS64 ? 8 : 4;
+}
+
+// Hash of the body with relocated fields masked out, plus the relocations
+static u64 icf_content_hash(const Linker* ld, const Atom* atom) {
+    atom = atom_code(ld, atom);
+    const uint8_t* bytes = atom_bytes(ld, atom);
+    u64 h = atom->size;
+    uint32_t pos = 0;
+    for (uint32_t r = atom->reloc_begin; r < atom->reloc_end; r++) {
+        const fcef_reloc_t* rel = atom_reloc(ld, atom, r);
+        uint32_t off = rel->offset - atom->start;
+        if (off > pos) {
+            h = eclc_hash_combine(h, eclc_hash64(bytes + pos, off - pos, 0));
+        }
+        h = eclc_hash_combine(h, ((u64)rel->type << 32) | off);
+        h = eclc_hash_combine(h, (u64)(uint32_t)rel->addend);
+        if (off + reloc_width(rel) > pos) pos = off + reloc_width(rel);
+    }
+    if (pos < atom->size) {
+        h = eclc_hash_combine(h, eclc_hash64(bytes + pos, atom->size - pos, 0));
+    }
+    return h;
+}
+
+// Class of whatever a relocation reaches: folded functions share one
+static u64 target_class(const Linker* ld, const u64* classes, uint32_t target) {
+    if (target == NO_OBJECT) return 0;
+    return icf_candidate(ld->atoms[target]) ? classes[target] : ((u64)1 << 63) | target;
+}
+
+typedef struct {
+    Linker* ld;
+    const uint32_t* candidates;
+    const u64* prev;
+    u64* next;
+} IcfRound;
+
+static void icf_hash_body(void* ctx, size_t k) {
+    IcfRound* round = ctx;
+    uint32_t i = round->candidates[k];
+    round->next[i] = icf_content_hash(round->ld, round->ld->atoms[i]);
+}
+
+static void icf_refine(void* ctx, size_t k) {
+    IcfRound* round = ctx;
+    const Linker* ld = round->ld;
+    uint32_t i = round->candidates[k];
+    const Atom* atom = atom_code(ld, ld->atoms[i]);
+    const LinkObject* lo = &ld->objects[atom->object];
+
+    u64 h = ld->atoms[i]->hash;
+    for (uint32_t r = atom->reloc_begin; r < atom->reloc_end; r++) {
+        int64_t delta = 0;
+        uint32_t target = reloc_target(ld, lo, atom_reloc(ld, atom, r), &delta);
+        h = eclc_hash_combine(h, target_class(ld, round->prev, target));
+        h = eclc_hash_combine(h, (u64)delta);
+    }
+    round->next[i] = h;
+}
+
+// Sort `order` by class, then by atom index, and count the classes
+static size_t count_classes(uint32_t* order, size_t count, const u64* classes, SortKey* keys) {
+    for (size_t k = 0; k < count; k++) {
+        keys[k].key = classes[order[k]];
+        keys[k].index = order[k];
+    }
+    sort_by_key(keys, order, count);
+    size_t distinct = count ? 1 : 0;
+    for (size_t k = 1; k < count; k++) {
+        if (classes[order[k]] != classes[order[k - 1]]) distinct++;
+    }
+    return distinct;
+}
+
+// Exact comparison, so a hash collision can never fold different code
+static bool icf_equal(const Linker* ld, const u64* classes, uint32_t a, uint32_t b) {
+    const Atom* x = atom_code(ld, ld->atoms[a]);
+    const Atom* y = atom_code(ld, ld->atoms[b]);
+    if (x->size != y->size || x->reloc_end - x->reloc_begin != y->reloc_end - y->reloc_begin) {
+        return false;
+    }
+
+    const uint8_t* xb = atom_bytes(ld, x);
+    const uint8_t* yb = atom_bytes(ld, y);
+    uint32_t pos = 0;
+    for (uint32_t k = 0; k < x->reloc_end - x->reloc_begin; k++) {
+        const fcef_reloc_t* xr = atom_reloc(ld, x, x->reloc_begin + k);
+        const fcef_reloc_t* yr = atom_reloc(ld, y, y->reloc_begin + k);
+        uint32_t off = xr->offset - x->start;
+        if (off != yr->offset - y->start || xr->type != yr->type || xr->addend != yr->addend) {
+            return false;
+        }
+        if (off > pos && memcmp(xb + pos, yb + pos, off - pos) != 0) {
+            return false;
+        }
+        if (off + reloc_width(xr) > pos) pos = off + reloc_width(xr);
+
+        int64_t xd = 0, yd = 0;
+        uint32_t xt = reloc_target(ld, &ld->objects[x->object], xr, &xd);
+        uint32_t yt = reloc_target(ld, &ld->objects[y->object], yr, &yd);
+        if (xd != yd) return false;
+        if (xt != yt && target_class(ld, classes, xt) != target_class(ld, classes, yt)) {
+            return false;
+        }
+    }
+    return pos >= x->size || memcmp(xb + pos, yb + pos, x->size - pos) == 0;
+}
+
+// Identical code folding: refine classes until the partition is stable,
+// then point every copy at the first function of its class
+static void fold_identical_code(Linker* ld, ThreadPool* pool, LinkStats* stats) {
+    uint32_t* candidates = xmalloc((ld->atom_count + 1) * sizeof(uint32_t));
+    size_t count = 0;
+    for (size_t i = 0; i < ld->atom_count; i++) {
+        if (icf_candidate(ld->atoms[i])) candidates[count++] = (uint32_t)i;
+    }
+
+    u64* prev = xcalloc(ld->atom_count + 1, sizeof(u64));
+    u64* next = xcalloc(ld->atom_count + 1, sizeof(u64));
+    IcfRound round = { ld, candidates, NULL, prev };
+    pool_for(pool, count, icf_hash_body, &round);
+    for (size_t k = 0; k < count; k++) {
+        ld->atoms[candidates[k]]->hash = prev[candidates[k]];
+    }
+
+    uint32_t* order = xmalloc((count + 1) * sizeof(uint32_t));
+    memcpy(order, candidates, count * sizeof(uint32_t));
+    SortKey* keys = xmalloc((count + 1) * sizeof(SortKey));
+    size_t distinct = count_classes(order, count, prev, keys);
+    for (int r = 0; r < ICF_MAX_ROUNDS; r++) {
+        round.prev = prev;
+        round.next = next;
+        pool_for(pool, count, icf_refine, &round);
+        size_t refined = count_classes(order, count, next, keys);
+        u64* tmp = prev;
+        prev = next;
+        next = tmp;
+        if (refined == distinct) break;
+        distinct = refined;
+    }
+
+    // `order` is sorted by final class, then by input position
+    for (size_t k = 0; k < count;) {
+        size_t end = k + 1;
+        while (end < count && prev[order[end]] == prev[order[k]]) end++;
+        uint32_t leader = order[k];
+        for (size_t m = k + 1; m < end; m++) {
+            if (icf_equal(ld, prev, leader, order[m])) {
+                ld->atoms[order[m]]->leader = leader;
+                stats->icf_functions++;
+                stats->icf_bytes += ld->atoms[order[m]]->size;
+            }
+        }
+        k = end;
+    }
+
+    xfree(keys);
+    xfree(order);
+    xfree(next);
+    xfree(prev);
+    xfree(candidates);
+}
+
+// Function reached by the lone `b f` a function consists of, as codegen
+// emits a call in tail position at -O1, or NO_OBJECT
+static uint32_t branch_target(const Linker* ld, const Atom* atom) {
+    if (!atom->function || atom->size != 4 || atom->reloc_end - atom->reloc_begin != 1) {
+        return NO_OBJECT;
+    }
+    const fcef_reloc_t* rel = atom_reloc(ld, atom, atom->reloc_begin);
+    const uint8_t* bytes = atom_bytes(ld, atom);
+    if (rel->type != FCEF_RELOC_CALL26 || rel->offset != atom->start || (bytes[3] & 0xFC) != 0x14) {
+        return NO_OBJECT;       // A bl, whose return has to come back here
+    }
+    int64_t delta = 0;
+    uint32_t target = reloc_target(ld, &ld->objects[atom->object], rel, &delta);
+    if (target == NO_OBJECT || delta != 0 || !ld->atoms[target]->function) {
+        return NO_OBJECT;
+    }
+    return target;
+}
+
+typedef struct {
+    Linker* ld;
+    uint32_t* callee;           // branch_target() of every atom
+} BranchScan;
+
+static void scan_branches(void* ctx, size_t o) {
+    BranchScan* scan = ctx;
+    const LinkObject* lo = &scan->ld->objects[o];
+    for (size_t a = 0; a < lo->atom_count; a++) {
+        scan->callee[lo->atom_base + a] = branch_target(scan->ld, &lo->atoms[a]);
+    }
+}
+
+enum { UNVISITED, ACTIVE, DONE, RECURSIVE = 4 };
+
+// Give a branching function the code of the function it reaches, when the
+// cost model of the -O level allows. Callees are settled first, so a chain
+// of forwarders resolves to its end; functions on a cycle are left alone.
+static void inline_functions(Linker* ld, ThreadPool* pool, int level, LinkStats* stats) {
+    const InlineLimits* model = inline_limits(level);
+    BranchScan scan = { ld, xmalloc((ld->atom_count + 1) * sizeof(uint32_t)) };
+    pool_for(pool, ld->count, scan_branches, &scan);
+    uint32_t* callee = scan.callee;
+
+    size_t insns = 0;
+    for (size_t o = 0; o < ld->count; o++) {
+        insns += ld->objects[o].input->object->code_size / 4;
+    }
+    size_t budget = (INLINE_UNIT_SLACK + insns * model->unit_percent / 100) * 4;
+
+    uint8_t* state = xcalloc(ld->atom_count + 1, 1);
+    uint32_t* path = xmalloc((ld->atom_count + 1) * sizeof(uint32_t));
+    for (size_t root = 0; root < ld->atom_count; root++) {
+        if (callee[root] == NO_OBJECT || state[root] != UNVISITED) continue;
+        size_t depth = 0;
+        path[depth++] = (uint32_t)root;
+        state[root] = ACTIVE;
+        while (depth > 0) {
+            uint32_t i = path[depth - 1];
+            uint32_t c = callee[i];
+            if (c != NO_OBJECT && (state[c] & 3) == UNVISITED) {
+                state[c] |= ACTIVE;
+                path[depth++] = c;
+                continue;
+            }
+            if (c != NO_OBJECT && (state[c] & 3) == ACTIVE) {
+                for (size_t k = depth; k-- > 0;) {
+                    state[path[k]] |= RECURSIVE;
+                    if (path[k] == c) break;
+                }
+            }
+            state[i] = (uint8_t)((state[i] & RECURSIVE) | DONE);
+            depth--;
+            if (c == NO_OBJECT || (state[i] & RECURSIVE) || (state[c] & RECURSIVE)) continue;
+
+            Atom* atom = ld->atoms[i];
+            uint32_t body = ld->atoms[c]->body;
+            const Atom* code = ld->atoms[body];
+            size_t growth;
+            if (code->reloc_begin == code->reloc_end) {
+                growth = code->size - atom->size;
+            } else if (callee[body] != NO_OBJECT) {
+                growth = 0;     // Branch straight to where the callee branches
+            } else {
+                continue;
+            }
+            if (growth > model->site_growth * 4 || growth > budget) continue;
+            budget -= growth;
+            atom->body = body;
+            atom->size = code->size;
+            stats->inlined_calls++;
+            stats->inlined_bytes += growth;
+        }
+    }
+    xfree(path);
+    xfree(state);
+    xfree(callee);
+}
+
+// ==================== Phase 5: layout ====================
+
+static uint32_t layout_section(Linker* ld, uint8_t section) {
+    uint32_t offset = 0;
+    for (size_t o = 0; o < ld->count; o++) {
+        LinkObject* lo = &ld->objects[o];
+        for (uint32_t a = lo->sec_begin[section]; a < lo->sec_end[section]; a++) {
+            Atom* atom = &lo->atoms[a];
+            if (!atom->live || atom->leader != lo->atom_base + a) continue;
+            atom->out_offset = offset = align_up(offset, atom->align);
+            offset += atom->size;
+        }
+    }
+    for (size_t o = 0; o < ld->count; o++) {
+        LinkObject* lo = &ld->objects[o];
+        for (uint32_t a = lo->sec_begin[section]; a < lo->sec_end[section]; a++) {
+            Atom* atom = &lo->atoms[a];
+            atom->out_offset = ld->atoms[atom->leader]->out_offset;
+        }
+    }
+    return offset;
+}
+
+static void layout(Linker* ld) {
+    eclc_output_t* out = ld->out;
+    uint32_t text = layout_section(ld, FCEF_SEC_TEXT);
+    uint32_t rodata = layout_section(ld, FCEF_SEC_RODATA);
+    uint32_t data = layout_section(ld, FCEF_SEC_DATA);
+
+    uint32_t bss = 0;
+    for (size_t o = 0; o < ld->count; o++) {
+        LinkObject* lo = &ld->objects[o];
+        lo->bss_offset = bss = align_up(bss, 8);
+        bss += (uint32_t)lo->input->object->bss_size;
+    }
+
+    out->code_size = text;
+    out->rodata_size = rodata;
+    out->data_size = data;
+    out->bss_size = bss;
+    out->code = xcalloc(text ? text : 1, 1);
+    out->rodata = rodata ? xcalloc(rodata, 1) : NULL;
+    out->data = data ? xcalloc(data, 1) : NULL;
+
+    out->text_addr = ECLC_TEXT_ADDR;
+    out->rodata_addr = align_up(out->text_addr + text, LINK_PAGE_SIZE);
+    if (out->rodata_addr < ECLC_RODATA_ADDR) out->rodata_addr = ECLC_RODATA_ADDR;
+    out->data_addr = align_up(out->rodata_addr + rodata, LINK_PAGE_SIZE);
+    if (out->data_addr < ECLC_DATA_ADDR) out->data_addr = ECLC_DATA_ADDR;
+    ld->bss_addr = align_up(out->data_addr + data, 8);
+}
+
+static uint32_t output_base(const Linker* ld, uint8_t section) {
+    switch (section) {
+        case FCEF_SEC_TEXT: return ld->out->text_addr;
+        case FCEF_SEC_RODATA: return ld->out->rodata_addr;
+        case FCEF_SEC_DATA: return ld->out->data_addr;
+        case FCEF_SEC_BSS: return ld->bss_addr;
+        default: return 0;
+    }
+}
+
+static uint8_t* output_bytes(const Linker* ld, uint8_t section) {
+    switch (section) {
+        case FCEF_SEC_TEXT: return ld->out->code;
+        case FCEF_SEC_RODATA: return ld->out->rodata;
+        case FCEF_SEC_DATA: return ld->out->data;
+        default: return NULL;
+    }
+}
+
+// Address of a location inside one input section after layout
+static uint32_t section_address(const Linker* ld, const LinkObject* lo,
+                                uint8_t section, uint32_t offset) {
+    if (section == FCEF_SEC_BSS) {
+        return ld->bss_addr + lo->bss_offset + offset;
+    }
+    uint32_t a = find_atom(lo, section, offset);
+    if (a == NO_OBJECT) return 0;
+    const Atom* atom = &lo->atoms[a];
+    return output_base(ld, section) + atom->out_offset + (offset - atom->start);
+}
+
+static void assign_addresses(void* ctx, size_t o) {
+    Linker* ld = ctx;
+    LinkObject* lo = &ld->objects[o];
+    const eclc_output_t* obj = lo->input->object;
+    for (size_t s = 1; s < obj->symbol_count; s++) {
+        const fcef_symbol_t* sym = &obj->symbols[s];
+        lo->addr[s] = section_address(ld, lo, sym->section, sym->value);
+    }
+}
+
+// ==================== Phase 6: copy and relocate ====================
+
+static void emit_object(void* ctx, size_t o) {
+    Linker* ld = ctx;
+    LinkObject* lo = &ld->objects[o];
+
+    for (size_t a = 0; a < lo->atom_count; a++) {
+        const Atom* atom = &lo->atoms[a];
+        if (!atom->live || atom->leader != lo->atom_base + a) continue;
+
+        uint8_t* dst = output_bytes(ld, atom->section) + atom->out_offset;
+        uint32_t base = output_base(ld, atom->section) + atom->out_offset;
+        memcpy(dst, atom_bytes(ld, atom), atom->size);
+
+        // An inlined body is relocated as in the object it came from
+        const Atom* code = atom_code(ld, atom);
+        const LinkObject* from = &ld->objects[code->object];
+        const eclc_output_t* from_obj = from->input->object;
+        for (uint32_t r = code->reloc_begin; r < code->reloc_end; r++) {
+            const fcef_reloc_t* rel = &from_obj->relocs[from->relocs_sorted[r]];
+            if (rel->symbol >= from_obj->symbol_count) continue;
+
+            SymbolRef ref = from->refs[rel->symbol];
+            uint64_t target = rel->addend;
+            if (ref.object != NO_OBJECT) {
+                target += ld->objects[ref.object].addr[ref.symbol];
+            }
+            uint32_t delta = rel->offset - code->start;
+            if (!eclc_apply_reloc(dst + delta, base + delta, target,
+                                  (fcef_reloc_type_t)rel->type)) {
+                error_add(&lo->errors, LINK_ERR_RANGE, code->object, rel->symbol, 0);
+            }
+        }
+    }
+}
+
+// ==================== Driver ====================
+
+static int compare_errors(const void* a, const void* b) {
+    const LinkError* x = a;
+    const LinkError* y = b;
+    if (x->object != y->object) return x->object < y->object ? -1 : 1;
+    if (x->symbol != y->symbol) return x->symbol < y->symbol ? -1 : 1;
+    return (int)x->kind - (int)y->kind;
+}
+
+static void append_errors(ErrorList* all, const ErrorList* list) {
+    for (size_t i = 0; i < list->count; i++) {
+        const LinkError* e = &list->items[i];
+        error_add(all, e->kind, e->object, e->symbol, e->other);
+    }
+}
+
+// Print collected errors in input order; returns how many there were
+static size_t report_errors(Linker* ld) {
+    ErrorList all = {0};
+    for (size_t p = 0; p < LINK_PARTITIONS; p++) {
+        append_errors(&all, &ld->parts[p].errors);
+    }
+    for (size_t o = 0; o < ld->count; o++) {
+        append_errors(&all, &ld->objects[o].errors);
+    }
+    qsort(all.items, all.count, sizeof(LinkError), compare_errors);
+
+    for (size_t i = 0; i < all.count; i++) {
+        const LinkError* e = &all.items[i];
+        SymbolRef ref = { e->object, e->symbol };
+        const char* file = ld->objects[e->object].input->name;
+        switch (e->kind) {
+            case LINK_ERR_UNDEFINED:
+                fprintf(stderr, "Error: Undefined symbol '%s' referenced in %s\n",
+                        symbol_name(ld, ref), file);
+                break;
+            case LINK_ERR_DUPLICATE:
+                fprintf(stderr, "Error: Multiple definition of '%s' in %s (first defined in %s)\n",
+                        symbol_name(ld, ref), file, ld->objects[e->other].input->name);
+                break;
+            case LINK_ERR_RANGE:
+                fprintf(stderr, "Error: Relocation against '%s' out of range in %s\n",
+                        symbol_name(ld, ref), file);
+                break;
+        }
+    }
+    size_t count = all.count;
+    xfree(all.items);
+    return count;
+}
+
+
+static void export_symbols(Linker* ld) {
+    eclc_output_t* out = ld->out;
+    for (size_t o = 0; o < ld->count; o++) {
+        const LinkObject* lo = &ld->objects[o];
+        const eclc_output_t* obj = lo->input->object;
+        for (size_t s = 1; s < obj->symbol_count; s++) {
+            const fcef_symbol_t* sym = &obj->symbols[s];
+            if (sym->bind == FCEF_BIND_LOCAL || sym->section == FCEF_SEC_UNDEF) continue;
+            if (lo->refs[s].object != o || lo->refs[s].symbol != s) continue;
+            if (lo->sym_atom[s] != NO_OBJECT && !lo->atoms[lo->sym_atom[s]].live) continue;
+
+            // Folded functions export the address of the body they share,
+            // inlined ones the size of the code they took over
+            uint32_t size = sym->size;
+            if (lo->sym_atom[s] != NO_OBJECT && lo->atoms[lo->sym_atom[s]].function) {
+                size = lo->atoms[lo->sym_atom[s]].size;
+            }
+            eclc_add_symbol(out, eclc_symbol_name(obj, sym), (fcef_section_t)sym->section,
+                            lo->addr[s] - output_base(ld, sym->section), size,
+                            (fcef_bind_t)sym->bind, (fcef_symtype_t)sym->type);
+        }
+    }
+    eclc_finalize_symbols(out);
+}
+
+static void linker_free(Linker* ld) {
+    for (size_t o = 0; o < ld->count; o++) {
+        LinkObject* lo = &ld->objects[o];
+        xfree(lo->hashes);
+        xfree(lo->refs);
+        xfree(lo->addr);
+        xfree(lo->sym_atom);
+        xfree(lo->relocs_sorted);
+        xfree(lo->atoms);
+        xfree(lo->symbols_by_part);
+        xfree(lo->atoms_by_part);
+        xfree(lo->errors.items);
+    }
+    for (size_t p = 0; p < LINK_PARTITIONS; p++) {
+        xfree(ld->parts[p].slots);
+        xfree(ld->parts[p].errors.items);
+    }
+    xfree(ld->objects);
+    xfree(ld->atoms);
+}
+
+static eclc_output_t* build_output(Linker* ld, ThreadPool* pool,
+                                   const LinkOptions* options, LinkStats* stats) {
+    const char* entry = options->entry ? options->entry : "main";
+    if (!find_entry(ld, entry)) {
+        fprintf(stderr, "Error: Entry symbol '%s' is not defined\n", entry);
+        return NULL;
+    }
+
+    // Before collection, so that callees no longer called can go
+    if (options->level > 0) {
+        inline_functions(ld, pool, options->level, stats);
+    }
+    if (options->icf) {
+        pool_for(pool, ld->count, mark_address_taken, ld);
+    }
+    // Collect first so dead functions never keep a live one from folding
+    if (options->gc_sections) {
+        collect_garbage(ld, stats);
+    }
+    if (options->icf) {
+        fold_identical_code(ld, pool, stats);
+    }
+
+    eclc_output_t* out = xcalloc(1, sizeof(eclc_output_t));
+    ld->out = out;
+    layout(ld);
+    pool_for(pool, ld->count, assign_addresses, ld);
+    pool_for(pool, ld->count, emit_object, ld);
+    if (report_errors(ld) != 0) {
+        eclc_free_output(out);
+        return NULL;
+    }
+
+    export_symbols(ld);
+    long main_sym = eclc_lookup_symbol(out, entry);
+    out->entry_point = out->text_addr + out->symbols[main_sym].value;
+    return out;
+}
+
+eclc_output_t* eclc_link(const LinkInput* inputs, size_t count,
+                         const LinkOptions* options, LinkStats* stats) {
+    LinkOptions defaults = {0};
+    if (!options) options = &defaults;
+    LinkStats local_stats;
+    if (!stats) stats = &local_stats;
+    memset(stats, 0, sizeof(*stats));
+
+    ThreadPool* pool = options->pool;
+    ThreadPool* own_pool = NULL;
+    if (!pool && options->threads != 1) {
+        pool = own_pool = pool_create(options->threads);
+    }
+
+    Linker ld;
+    memset(&ld, 0, sizeof(ld));
+    ld.count = count;
+    ld.objects = xcalloc(count ? count : 1, sizeof(LinkObject));
+    for (size_t o = 0; o < count; o++) {
+        ld.objects[o].input = &inputs[o];
+    }
+
+    pool_for(pool, count, scan_object, &ld);
+
+    for (size_t o = 0; o < count; o++) {
+        ld.objects[o].atom_base = ld.atom_count;
+        ld.atom_count += ld.objects[o].atom_count;
+    }
+    ld.atoms = xcalloc(ld.atom_count ? ld.atom_count : 1, sizeof(Atom*));
+    for (size_t o = 0; o < count; o++) {
+        LinkObject* lo = &ld.objects[o];
+        for (size_t a = 0; a < lo->atom_count; a++) {
+            lo->atoms[a].leader = (uint32_t)(lo->atom_base + a);
+            lo->atoms[a].body = (uint32_t)(lo->atom_base + a);
+            ld.atoms[lo->atom_base + a] = &lo->atoms[a];
+        }
+    }
+
+    pool_for(pool, LINK_PARTITIONS, resolve_partition, &ld);
+    pool_for(pool, LINK_PARTITIONS, merge_partition, &ld);
+
+    eclc_output_t* out = NULL;
+    if (report_errors(&ld) == 0) {
+        out = build_output(&ld, pool, options, stats);
+    }
+
+    stats->objects = count;
+    for (size_t o = 0; o < count; o++) {
+        stats->relocations += inputs[o].object->reloc_count;
+        stats->text_in += inputs[o].object->code_size;
+        stats->rodata_in += inputs[o].object->rodata_size;
+    }
+    if (out) {
+        stats->symbols = out->symbol_count ? out->symbol_count - 1 : 0;
+        stats->text_out = out->code_size;
+        stats->rodata_out = out->rodata_size;
+    }
+
+    linker_free(&ld);
+    pool_destroy(own_pool);
+    return out;
+}
@@ -18,18 +18,41 @@
 #include "eclc/token.h"
 #include "eclc/ast.h"
 #include "eclc/common.h"
+#include "eclc/codegen.h"
+#include "eclc/peephole.h"
+#include "eclc/inliner.h"
+#include "eclc/consteval.h"
+#include "eclc/interp.h"
+#include "eclc/jit.h"
+#include "eclc/link.h"
+#include "eclc/inspect.h"
+#include "eclc/error.h"
+#include "eclc/pool.h"
+#include "eclc/queue.h"
+#include "eclc/manifest.h"
+#include "eclc/scan.h"
+#include "eclc/server.h"
+#include "eclc/args.h"
+#include "eclc/profile.h"
+#include "eclc/progress.h"
+#include "eclc/cache.h"
+#include "eclc/hash.h"
+#include "eclc/fileio.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <dirent.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <fcef.h>
 
 // Read file content
 static char* read_file(const char* filename) {
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_READ);
     FILE* file = fopen(filename, "r");
     if (!file) {
-        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+        error_report("Cannot open file '%s'", filename);
+        phase_leave(&scope);
         return NULL;
     }
     
@@ -42,101 +65,175 @@ static char* read_file(const char* filename) {
     content[size] = '\0';
     
     fclose(file);
+    profile_trace_size((u64)size);
+    phase_leave(&scope);
     return content;
 }
 
-// Check if file has C/C++ extension
-static bool is_c_file(const char* filename) {
-    const char* ext = strrchr(filename, '.');
-    return ext && (strcmp(ext, ".c") == 0 || strcmp(ext, ".cpp") == 0);
+// FCEF reads and writes, charged to their own phase
+static bool save_fcef(const eclc_output_t* output, const char* path) {
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_FCEF);
+    bool saved = eclc_save_fcef(output, path);
+    phase_leave(&scope);
+    return saved;
+}
+
+static eclc_output_t* load_fcef(const char* path) {
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_FCEF);
+    eclc_output_t* output = eclc_load_fcef(path);
+    phase_leave(&scope);
+    return output;
+}
+
+// Build cache of the running command, NULL when disabled
+static ObjectCache* object_cache;
+
+// Pool that large files spread their functions' codegen over, NULL = serial
+static ThreadPool* codegen_pool;
+
+// -O level of the running command
+static int codegen_level;
+
+// Options that change the compiled object, for the manifest and cache keys
+static u64 object_flags(const CompilerConfig* config) {
+    return (u64)ECLC_OBJECT_VERSION |
+           (config->c_mode ? 1u << 8 : 0) | (config->cpp_mode ? 1u << 9 : 0) |
+           (config->debug_info ? 1u << 10 : 0) |
+           ((u64)(config->optimization_level & 0xFF) << 16);
+}
+
+// Cache key of a source that isn't part of a folder build
+static CacheKey source_key(const char* source, const char* path, u64 flags) {
+    ManifestDep* deps;
+    size_t dep_count = manifest_scan_includes(source, path, &deps);
+    CacheKey key = cache_key(object_cache, source, path, deps, dep_count, flags);
+    manifest_deps_free(deps, dep_count);
+    return key;
 }
 
 // Generate executable from AST
-static int generate_executable(ASTNode* ast, const char* output_file) {
+static int generate_executable(ASTNode* ast, const char* output_file, const CacheKey* key) {
     int return_value = 0;
-    if (ast && ast->left && ast->left->left && ast->left->left->left) {
-        ASTNode* return_node = ast->left->left->left;
-        if (return_node->type == NODE_INTEGER_LITERAL && return_node->token.value) {
-            return_value = atoi(return_node->token.value);
-        }
+    if (!consteval_function(ast, "main", &return_value)) {
+        return_value = 0;
     }
     
-    FILE* fcef_file = fopen(output_file, "wb");
-    if (!fcef_file) {
-        fprintf(stderr, "Error: Cannot create output file '%s'\n", output_file);
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_CODEGEN);
+    CodegenOptions options = { codegen_pool, NULL, codegen_level };
+    eclc_output_t* output = codegen_generate_with(ast, &options);
+    phase_leave(&scope);
+    if (!output) {
+        fprintf(stderr, "Error: Code generation failed for '%s'\n", output_file);
         return 1;
     }
     
-    fcef_header_t header = {0};
-    fcef_init_header(&header);
-    header.file_size = sizeof(header) + 4; 
-    
- 
-    uint8_t ret_instruction[] = {0xC0, 0x03, 0x5F, 0xD6};  // ret
-    
-    
-    fwrite(&header, sizeof(header), 1, fcef_file);
-    fwrite(ret_instruction, sizeof(ret_instruction), 1, fcef_file);
-    fclose(fcef_file);
+    bool saved = save_fcef(output, output_file);
+    if (saved && key) {
+        cache_store(object_cache, key, output);
+    }
+    eclc_free_output(output);
+    if (!saved) {
+        fprintf(stderr, "Error: Cannot create output file '%s'\n", output_file);
+        return 1;
+    }
     
     printf("Generated FCEF file: %s (return value: %d)\n", output_file, return_value);
+    return 0;
 }
 
-// Compile single file with output (quiet mode for folder compilation)
-static int compile_file_quiet_with_output(const char* filename, const char* output_file) {
-    char* source = read_file(filename);
-    if (!source) {
-        return 1;
-    }
-    
+// Lex and parse source text; NULL if anything was reported. The tree
+// outlives the tokens since token text is interned.
+static ASTNode* parse_source(const char* source, const char* filename) {
+    int errors = error_count();
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_LEX);
     TokenStream* tokens = tokenize(source);
+    phase_leave(&scope);
     if (!tokens) {
-        xfree(source);
-        return 1;
+        return NULL;
     }
     
+    phase_enter(&scope, PHASE_PARSE);
     Parser* parser = parser_create(tokens, filename);
     ASTNode* ast = parser_parse(parser);
-    if (!ast) {
-        parser_destroy(parser);
-        token_stream_free(tokens);
-        xfree(source);
-        return 1;
-    }
-    
-    int result = generate_executable(ast, output_file);
-    
+    phase_leave(&scope);
     parser_destroy(parser);
     token_stream_free(tokens);
-    xfree(source);
-    
-    return result;
+    if (ast && error_count() != errors) {
+        ast_free(ast);
+        ast = NULL;
+    }
+    return ast;
+}
+
+static eclc_output_t* generate_object(ASTNode* ast, CodegenCache* cache) {
+    int errors = error_count();
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_CODEGEN);
+    CodegenOptions options = { codegen_pool, cache, codegen_level };
+    eclc_output_t* object = codegen_generate_with(ast, &options);
+    phase_leave(&scope);
+    if (object && error_count() != errors) {
+        eclc_free_output(object);
+        object = NULL;
+    }
+    return object;
+}
+
+// Compile source text to a relocatable object (quiet mode for folder compilation).
+// Safe to call from several threads at once.
+static eclc_output_t* compile_to_object(const char* source, const char* filename) {
+    ASTNode* ast = parse_source(source, filename);
+    eclc_output_t* object = ast ? generate_object(ast, NULL) : NULL;
+    ast_free(ast);
+    return object;
 }
 
 // Compile single file with optional output
-static int compile_file_with_output(const char* filename, const char* output_file) {
+static int compile_file_with_output(const char* filename, const char* output_file, u64 flags) {
     if (!output_file) {
         printf("Compiling: %s\n", filename);
     } else {
         printf("\033[32m   Compiling\033[0m %s -> %s\n", filename, output_file);
     }
     
+    profile_trace_file(filename);
     char* source = read_file(filename);
     if (!source) {
         return 1;
     }
     
+    CacheKey key = {0};
+    if (output_file && object_cache) {
+        key = source_key(source, filename, flags);
+        if (cache_fetch(object_cache, &key, output_file)) {
+            printf("\033[32m    Finished\033[0m executable: %s (cached)\n", output_file);
+            xfree(source);
+            return 0;
+        }
+    }
+    
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_LEX);
     TokenStream* tokens = tokenize(source);
+    phase_leave(&scope);
     if (!tokens) {
         fprintf(stderr, "Error: Tokenization failed for %s\n", filename);
         xfree(source);
         return 1;
     }
     
+    int errors = error_count();
+    phase_enter(&scope, PHASE_PARSE);
     Parser* parser = parser_create(tokens, filename);
     ASTNode* ast = parser_parse(parser);
-    if (!ast) {
+    phase_leave(&scope);
+    if (!ast || error_count() != errors) {
         fprintf(stderr, "Error: Parsing failed for %s\n", filename);
+        ast_free(ast);
         parser_destroy(parser);
         token_stream_free(tokens);
         xfree(source);
@@ -146,7 +243,7 @@ static int compile_file_with_output(const char* filename, const char* output_fil
     int result = 0;
     if (output_file) {
         // Generate executable
-        result = generate_executable(ast, output_file);
+        result = generate_executable(ast, output_file, object_cache ? &key : NULL);
         if (result == 0) {
             printf("\033[32m    Finished\033[0m executable: %s\n", output_file);
         }
@@ -157,6 +254,7 @@ static int compile_file_with_output(const char* filename, const char* output_fil
         printf("\n");
     }
     
+    ast_free(ast);
     parser_destroy(parser);
     token_stream_free(tokens);
     xfree(source);
@@ -166,146 +264,1314 @@ static int compile_file_with_output(const char* filename, const char* output_fil
 
 // Compile single file (verbose mode)
 static int compile_file(const char* filename) {
-    return compile_file_with_output(filename, NULL);
+    return compile_file_with_output(filename, NULL, ECLC_OBJECT_VERSION);
 }
 
-// Print cargo-style progress bar
-static void print_progress(int current, int total, const char* current_file, bool success) {
-    int percent = (current * 100) / total;
-    int bar_width = 20;
-    int filled = (current * bar_width) / total;
+// Default executable name for a folder build: <folder name>.fcef
+static char* folder_output_name(const char* folder_path) {
+    size_t len = strlen(folder_path);
+    while (len > 1 && folder_path[len - 1] == '/') len--;
+    size_t start = len;
+    while (start > 0 && folder_path[start - 1] != '/') start--;
     
-    printf("\r");
-    if (success) {
-        printf("\033[32m   Compiling\033[0m"); // Green "Compiling"
-    } else {
-        printf("\033[31m     Failed\033[0m"); // Red "Failed"
+    size_t name_len = len - start;
+    if (name_len == 0 || folder_path[start] == '/' ||
+        strncmp(folder_path + start, ".", name_len) == 0 ||
+        strncmp(folder_path + start, "..", name_len) == 0) {
+        return xstrdup("a.fcef");
+    }
+    char* name = xmalloc(name_len + 6);
+    memcpy(name, folder_path + start, name_len);
+    strcpy(name + name_len, ".fcef");
+    return name;
+}
+
+// Link compiled objects into one executable
+static int link_folder(LinkInput* inputs, int count, const char* output_file,
+                       const LinkOptions* options) {
+    printf("\033[32m     Linking\033[0m %d objects -> %s\n", count, output_file);
+    fflush(stdout);
+    profile_trace_file(output_file);
+    
+    LinkStats stats;
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_LINK);
+    eclc_output_t* program = eclc_link(inputs, count, options, &stats);
+    phase_leave(&scope);
+    if (!program) {
+        return 1;
     }
     
-    printf(" [%2d/%2d] ", current, total);
+    bool saved = save_fcef(program, output_file);
+    eclc_free_output(program);
+    if (!saved) {
+        fprintf(stderr, "Error: Cannot create output file '%s'\n", output_file);
+        return 1;
+    }
     
-    // Progress bar
-    for (int i = 0; i < bar_width; i++) {
-        if (i < filled) {
-            printf("\033[32m=\033[0m"); // Green filled
-        } else if (i == filled && current < total) {
-            printf("\033[33m>\033[0m"); // Yellow arrow
-        } else {
-            printf(" ");
+    if (stats.rodata_in > stats.rodata_out) {
+        printf("\033[32m      Merged\033[0m %zu bytes of duplicate read-only data\n",
+               stats.rodata_in - stats.rodata_out);
+    }
+    if (stats.inlined_calls > 0) {
+        printf("\033[32m     Inlined\033[0m %zu calls across files, %zu bytes of code added\n",
+               stats.inlined_calls, stats.inlined_bytes);
+    }
+    if (stats.icf_functions > 0) {
+        printf("\033[32m      Folded\033[0m %zu identical functions, saved %zu bytes\n",
+               stats.icf_functions, stats.icf_bytes);
+    }
+    if (stats.gc_atoms > 0) {
+        printf("\033[32m    Stripped\033[0m %zu unreachable functions and objects, saved %zu bytes\n",
+               stats.gc_atoms, stats.gc_bytes);
+    }
+    if (stats.text_in > stats.text_out) {
+        printf("\033[32m        Code\033[0m %zu -> %zu bytes\n", stats.text_in, stats.text_out);
+    }
+    return 0;
+}
+
+// Long-lived pool of the compile server, NULL otherwise
+static ThreadPool* shared_pool;
+
+// The compile server's pool unless -j asks for a size, else a new one
+static ThreadPool* acquire_pool(int jobs, int* threads, bool* own_pool) {
+    *threads = jobs > 0 ? jobs : pool_cpu_count();
+    *own_pool = !(shared_pool && jobs == 0);
+    if (!*own_pool) {
+        *threads = pool_size(shared_pool);
+        return shared_pool;
+    }
+    return *threads > 1 ? pool_create(*threads) : NULL;
+}
+
+// One source file of a folder build
+typedef struct CompileQueue CompileQueue;
+typedef struct UnityBatch UnityBatch;
+
+typedef struct {
+    CompileQueue* queue;
+    char* name;                 // Relative to the folder
+    char* path;
+    UnityBatch* batch;          // --unity translation unit, NULL otherwise
+    const ManifestEntry* previous;  // Last build of this file, if any
+    ManifestEntry record;       // What this build saw, for the next manifest
+    bool fresh;                 // Unchanged since the last build
+    bool compiled;
+    bool failed;
+    char* source;               // Between reading and compiling
+    eclc_output_t* previous_object; // Its functions are reused where unchanged
+    CacheKey key;
+    eclc_output_t* object;      // With --unity only the batch's first file has one
+    ErrorBuffer errors;         // Diagnostics, printed when the file's turn comes
+    bool done;
+} CompileJob;
+
+// Files compiled into one object by --unity. They are consecutive in the
+// sorted job list and each is still lexed and parsed on its own, so
+// diagnostics keep their file and line.
+struct UnityBatch {
+    CompileJob** jobs;
+    int count;
+    char* object;               // Object name, shared by the members' records
+    char* name;                 // "first..last", for link diagnostics
+};
+
+struct CompileQueue {
+    const Manifest* manifest;
+    u64 flags;                  // object_flags() of the build
+    int unity;                  // Files per --unity batch, 0 = off
+    ThreadPool* pool;
+    Progress* progress;
+    CompileJob** jobs;          // In discovery order until the scan is done
+    int count;
+    int capacity;
+    UnityBatch* batches;
+    int batch_count;
+    size_t reused_functions;    // Copied from previous objects (atomic)
+    int reused_files;           // Edited files that had some (atomic)
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+    
+    // Pipeline of a parallel build without --unity
+    BoundedQueue* to_read;      // Found by the scan
+    BoundedQueue* to_compile;   // Read, with their source
+    BoundedQueue* to_write;     // Compiled
+    int compilers;              // Compile stages still running, under `lock`
+    pthread_t reader;
+    pthread_t writer;
+};
+
+// Stamp the source and its includes for the next manifest
+static void record_source(CompileJob* job, const char* source, const char* object) {
+    ManifestEntry* record = &job->record;
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_SCAN);
+    record->name = xstrdup(job->name);
+    record->object = xstrdup(object);
+    file_stamp_stat(job->path, &record->stamp);
+    record->stamp.hash = eclc_hash64(source, strlen(source), 0);
+    record->dep_count = manifest_scan_includes(source, job->path, &record->deps);
+    phase_leave(&scope);
+}
+
+// stat() first; contents are only hashed when the mtime moved. Fresh files
+// keep their cached object on disk until the link needs it.
+static bool check_fresh(CompileJob* job) {
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_SCAN);
+    job->previous = manifest_find(job->queue->manifest, job->name);
+    char* object_name = manifest_object_name(job->name);
+    // An object shared with a --unity batch doesn't count
+    job->fresh = job->previous && strcmp(job->previous->object, object_name) == 0 &&
+                 manifest_entry_fresh(job->previous, job->path, &job->record);
+    xfree(object_name);
+    phase_leave(&scope);
+    return job->fresh;
+}
+
+// Read (unless the pipeline already did) and stamp the source, then try
+// the build cache. True when the object still has to be compiled from
+// `job->source`.
+static bool prepare_job(CompileJob* job) {
+    job->compiled = true;
+    if (!job->source) {
+        job->source = read_file(job->path);
+    }
+    if (!job->source) {
+        job->failed = true;
+        return false;
+    }
+    char* object_name = manifest_object_name(job->name);
+    record_source(job, job->source, object_name);
+    xfree(object_name);
+    
+    if (object_cache) {
+        const ManifestEntry* record = &job->record;
+        job->key = cache_key(object_cache, job->source, job->path, record->deps,
+                             record->dep_count, job->queue->flags);
+        char* object_path = manifest_object_path(job->queue->manifest, record->object);
+        if (cache_fetch(object_cache, &job->key, object_path)) {
+            job->object = load_fcef(object_path);
         }
+        xfree(object_path);
+    }
+    if (job->object) {
+        xfree(job->source);
+        job->source = NULL;
+        return false;
     }
     
-    printf(" %s", current_file ? current_file : "");
-    fflush(stdout);
+    // An edit to a file the last build compiled: its object still holds
+    // the code of the functions that didn't change
+    const ManifestEntry* previous = job->previous;
+    if (previous && previous->function_count > 0) {
+        char* object_path = manifest_object_path(job->queue->manifest, previous->object);
+        job->previous_object = load_fcef(object_path);
+        xfree(object_path);
+    }
+    return true;
+}
+
+// Functions of the new object, so the next build can reuse them
+static void record_functions(ManifestEntry* record, const ASTNode* ast) {
+    size_t count = 0;
+    for (const ASTNode* fn = ast->left; fn; fn = fn->right) {
+        count++;
+    }
+    record->functions = xmalloc((count ? count : 1) * sizeof(ManifestFunction));
+    record->function_count = 0;
+    for (const ASTNode* fn = ast->left; fn; fn = fn->right) {
+        if (fn->type == NODE_FUNCTION_DEF && fn->token.value) {
+            ManifestFunction* function = &record->functions[record->function_count++];
+            function->name = xstrdup(fn->token.value);
+            function->hash = fn->hash;
+        }
+    }
+}
+
+static void generate_job(CompileJob* job) {
+    ASTNode* ast = parse_source(job->source, job->path);
+    xfree(job->source);
+    job->source = NULL;
+    if (!ast) {
+        eclc_free_output(job->previous_object);
+        job->previous_object = NULL;
+        return;
+    }
+    CodegenCache cache = {0};
+    FunctionHash* functions = NULL;
+    const ManifestEntry* previous = job->previous;
+    if (job->previous_object) {
+        functions = xmalloc(previous->function_count * sizeof(FunctionHash));
+        for (size_t i = 0; i < previous->function_count; i++) {
+            functions[i].name = previous->functions[i].name;
+            functions[i].hash = previous->functions[i].hash;
+        }
+        cache.object = job->previous_object;
+        cache.functions = functions;
+        cache.count = previous->function_count;
+    }
+    job->object = generate_object(ast, job->previous_object ? &cache : NULL);
+    // After codegen, which folds inlined callees into the hashes
+    record_functions(&job->record, ast);
+    if (cache.reused > 0) {
+        __atomic_add_fetch(&job->queue->reused_functions, cache.reused, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&job->queue->reused_files, 1, __ATOMIC_RELAXED);
+    }
+    xfree(functions);
+    eclc_free_output(job->previous_object);
+    job->previous_object = NULL;
+    ast_free(ast);
 }
 
-// Count C files in directory
-static int count_c_files(const char* folder_path) {
-    DIR* dir = opendir(folder_path);
-    if (!dir) return 0;
+// Store up to FILEIO_BATCH new objects next to the manifest in one go,
+// then in the build cache; `record` is only kept once the object is stored
+static void store_jobs(CompileJob** jobs, int count) {
+    FileWrite writes[FILEIO_BATCH];
+    void* images[FILEIO_BATCH];
+    char* paths[FILEIO_BATCH];
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_FCEF);
+    for (int i = 0; i < count; i++) {
+        CompileJob* job = jobs[i];
+        paths[i] = manifest_object_path(job->queue->manifest, job->record.object);
+        writes[i].path = paths[i];
+        writes[i].size = 0;
+        images[i] = job->object ? eclc_to_fcef(job->object, &writes[i].size) : NULL;
+        writes[i].data = images[i];
+    }
+    fileio_write(writes, (size_t)count);
+    phase_leave(&scope);
     
-    struct dirent* entry;
+    for (int i = 0; i < count; i++) {
+        CompileJob* job = jobs[i];
+        if (images[i] && writes[i].error == 0) {
+            cache_store(object_cache, &job->key, job->object);
+        } else {
+            manifest_entry_free(&job->record);
+        }
+        job->failed = !job->object;
+        xfree(images[i]);
+        xfree(paths[i]);
+    }
+}
+
+static void build_job(CompileJob* job) {
+    if (prepare_job(job)) {
+        generate_job(job);
+        store_jobs(&job, 1);
+    }
+}
+
+static void finish_job(CompileJob* job) {
+    if (job->fresh) {
+        progress_skip(job->queue->progress);
+    } else {
+        progress_done(job->queue->progress, job->name, !job->failed);
+    }
+    pthread_mutex_lock(&job->queue->lock);
+    job->done = true;
+    pthread_cond_broadcast(&job->queue->finished);
+    pthread_mutex_unlock(&job->queue->lock);
+}
+
+// All stages of one file on the calling thread
+static void compile_job(void* arg) {
+    CompileJob* job = arg;
+    error_capture_begin(&job->errors);
+    profile_trace_file(job->name);
+    if (!check_fresh(job)) {
+        build_job(job);
+    }
+    error_capture_end();
+    finish_job(job);
+}
+
+// A parallel build runs as a pipeline: the reader thread checks and
+// reads sources while pool workers compile and the writer thread stores
+// objects, so disk waits overlap with codegen. The bounded queues between
+// the stages cap how many sources are held in memory at once. The reader
+// and writer take whatever has queued up, FILEIO_BATCH files at most, and
+// read or write it with one batch of I/O.
+#define PIPELINE_SCAN_DEPTH 1024
+#define PIPELINE_DEPTH(threads) ((threads) * 4 < 16 ? 16 : (threads) * 4)
+
+// Sources of the stale files of a batch. A file that can't be read here
+// is left to read_file(), which reports the error.
+static void read_sources(CompileJob** jobs, int count) {
+    FileRead reads[FILEIO_BATCH];
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_READ);
+    for (int i = 0; i < count; i++) {
+        reads[i].path = jobs[i]->path;
+    }
+    fileio_read(reads, (size_t)count);
+    for (int i = 0; i < count; i++) {
+        jobs[i]->source = reads[i].data;
+    }
+    phase_leave(&scope);
+}
+
+static void* reader_stage(void* arg) {
+    CompileQueue* queue = arg;
+    void* items[FILEIO_BATCH];
+    CompileJob* batch[FILEIO_BATCH];
+    size_t count;
+    while ((count = queue_pop_many(queue->to_read, items, FILEIO_BATCH)) > 0) {
+        int stale = 0;
+        for (size_t i = 0; i < count; i++) {
+            CompileJob* job = items[i];
+            error_capture_begin(&job->errors);
+            profile_trace_file(job->name);
+            bool fresh = check_fresh(job);
+            error_capture_end();
+            if (fresh) {
+                finish_job(job);
+            } else {
+                batch[stale++] = job;
+            }
+        }
+        read_sources(batch, stale);
+        for (int i = 0; i < stale; i++) {
+            CompileJob* job = batch[i];
+            error_capture_begin(&job->errors);
+            profile_trace_file(job->name);
+            bool compile = prepare_job(job);
+            error_capture_end();
+            if (compile) {
+                queue_push(queue->to_compile, job);
+            } else {
+                finish_job(job);
+            }
+        }
+    }
+    queue_close(queue->to_compile);
+    return NULL;
+}
+
+static void compile_stage(void* arg) {
+    CompileQueue* queue = arg;
+    void* item;
+    while (queue_pop(queue->to_compile, &item)) {
+        CompileJob* job = item;
+        error_capture_begin(&job->errors);
+        profile_trace_file(job->name);
+        generate_job(job);
+        error_capture_end();
+        queue_push(queue->to_write, job);
+    }
+    // The last compiler out lets the writer finish
+    pthread_mutex_lock(&queue->lock);
+    if (--queue->compilers == 0) {
+        queue_close(queue->to_write);
+    }
+    pthread_cond_broadcast(&queue->finished);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static void* writer_stage(void* arg) {
+    CompileQueue* queue = arg;
+    void* items[FILEIO_BATCH];
+    CompileJob* batch[FILEIO_BATCH];
+    size_t count;
+    while ((count = queue_pop_many(queue->to_write, items, FILEIO_BATCH)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            batch[i] = items[i];
+        }
+        store_jobs(batch, (int)count);
+        for (size_t i = 0; i < count; i++) {
+            finish_job(batch[i]);
+        }
+    }
+    return NULL;
+}
+
+static void start_pipeline(CompileQueue* queue, int threads) {
+    queue->to_read = queue_create(PIPELINE_SCAN_DEPTH);
+    queue->to_compile = queue_create(PIPELINE_DEPTH(threads));
+    queue->to_write = queue_create(PIPELINE_DEPTH(threads));
+    queue->compilers = threads;
+    pthread_create(&queue->reader, NULL, reader_stage, queue);
+    pthread_create(&queue->writer, NULL, writer_stage, queue);
+    for (int i = 0; i < threads; i++) {
+        pool_submit(queue->pool, compile_stage, queue);
+    }
+}
+
+// Wait for the stages to drain after to_read was closed, then tear them
+// down. The pool tasks are waited for on `lock` since the pool is shared.
+static void stop_pipeline(CompileQueue* queue) {
+    if (!queue->to_read) {
+        return;
+    }
+    queue_close(queue->to_read);
+    pthread_join(queue->reader, NULL);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->compilers > 0) {
+        pthread_cond_wait(&queue->finished, &queue->lock);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    pthread_join(queue->writer, NULL);
+    queue_destroy(queue->to_read);
+    queue_destroy(queue->to_compile);
+    queue_destroy(queue->to_write);
+    queue->to_read = queue->to_compile = queue->to_write = NULL;
+}
+
+// Split the sorted jobs into batches of about `size` files. A batch ends
+// after a file whose name hash picks it (or at twice the size), so adding
+// or removing a file only regroups its own batch instead of shifting
+// every batch after it.
+static void make_batches(CompileQueue* queue) {
+    int size = queue->unity;
+    queue->batches = xcalloc(queue->count, sizeof(UnityBatch));
+    for (int i = 0; i < queue->count;) {
+        UnityBatch* batch = &queue->batches[queue->batch_count++];
+        batch->jobs = &queue->jobs[i];
+        size_t names = 0;
+        bool boundary;
+        do {
+            CompileJob* job = queue->jobs[i++];
+            job->batch = batch;
+            batch->count++;
+            names += strlen(job->name) + 1;
+            boundary = eclc_hash64(job->name, strlen(job->name), 0) % (u64)size == 0;
+        } while (i < queue->count && !boundary && batch->count < 2 * size);
+        
+        // The object name covers every member, so a regrouped batch never
+        // passes for the old one
+        char* joined = xmalloc(names + 1);
+        char* p = joined;
+        for (int j = 0; j < batch->count; j++) {
+            size_t len = strlen(batch->jobs[j]->name);
+            memcpy(p, batch->jobs[j]->name, len);
+            p[len] = '\n';
+            p += len + 1;
+        }
+        *p = '\0';
+        batch->object = manifest_object_name(joined);
+        xfree(joined);
+        
+        const char* first = batch->jobs[0]->name;
+        const char* last = batch->jobs[batch->count - 1]->name;
+        batch->name = xmalloc(strlen(first) + strlen(last) + 3);
+        if (batch->count == 1) {
+            strcpy(batch->name, first);
+        } else {
+            sprintf(batch->name, "%s..%s", first, last);
+        }
+    }
+}
+
+typedef struct {
+    const char* name;           // Interned, so pointers compare
+    int member;
+    int order;
+} FunctionSite;
+
+static int compare_sites(const void* a, const void* b) {
+    const FunctionSite* x = a;
+    const FunctionSite* y = b;
+    if (x->name != y->name) return (uintptr_t)x->name < (uintptr_t)y->name ? -1 : 1;
+    if (x->member != y->member) return x->member - y->member;
+    return x->order - y->order;
+}
+
+// A function defined by two members would clash inside the shared object.
+// Report it against the later file, the way separate objects would fail
+// at link time.
+static bool check_redefinitions(UnityBatch* batch, ASTNode** asts) {
     int count = 0;
+    for (int i = 0; i < batch->count; i++) {
+        for (ASTNode* fn = asts[i]->left; fn; fn = fn->right) count++;
+    }
+    FunctionSite* sites = xmalloc((count ? count : 1) * sizeof(FunctionSite));
+    int n = 0;
+    for (int i = 0; i < batch->count; i++) {
+        for (ASTNode* fn = asts[i]->left; fn; fn = fn->right) {
+            if (fn->type == NODE_FUNCTION_DEF && fn->token.value) {
+                sites[n].name = fn->token.value;
+                sites[n].member = i;
+                sites[n].order = n;
+                n++;
+            }
+        }
+    }
+    qsort(sites, n, sizeof(FunctionSite), compare_sites);
+    
+    bool ok = true;
+    for (int i = 1; i < n; i++) {
+        int first = i - 1;
+        while (first > 0 && sites[first - 1].name == sites[i].name) first--;
+        if (sites[first].name != sites[i].name) continue;
+        CompileJob* job = batch->jobs[sites[i].member];
+        error_capture_begin(&job->errors);
+        if (sites[first].member == sites[i].member) {
+            error_report("Redefinition of function '%s'", sites[i].name);
+        } else {
+            error_report("Redefinition of function '%s' (first defined in %s)",
+                         sites[i].name, batch->jobs[sites[first].member]->name);
+        }
+        error_capture_end();
+        job->failed = true;
+        ok = false;
+    }
+    xfree(sites);
+    return ok;
+}
+
+// Parse every member, then generate one object from all their functions
+static void build_batch(UnityBatch* batch) {
+    CompileJob* owner = batch->jobs[0];
+    ASTNode** asts = xcalloc(batch->count, sizeof(ASTNode*));
+    ASTNode** ends = xcalloc(batch->count, sizeof(ASTNode*));
+    bool ok = true;
+    for (int i = 0; i < batch->count; i++) {
+        CompileJob* job = batch->jobs[i];
+        job->compiled = true;
+        error_capture_begin(&job->errors);
+        profile_trace_file(job->name);
+        char* source = read_file(job->path);
+        if (source) {
+            record_source(job, source, batch->object);
+            asts[i] = parse_source(source, job->path);
+            xfree(source);
+        }
+        error_capture_end();
+        job->failed = !asts[i];
+        ok = ok && !job->failed;
+    }
+    ok = ok && check_redefinitions(batch, asts);
     
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_name[0] == '.') continue;
-        if (is_c_file(entry->d_name)) count++;
+    if (ok) {
+        // Chain the members' functions into one program for codegen
+        ASTNode unit = {0};
+        unit.type = NODE_PROGRAM;
+        ASTNode** tail = &unit.left;
+        for (int i = 0; i < batch->count; i++) {
+            for (*tail = asts[i]->left; *tail; tail = &(*tail)->right) {
+                ends[i] = *tail;
+            }
+        }
+        error_capture_begin(&owner->errors);
+        profile_trace_file(owner->name);
+        owner->object = generate_object(&unit, NULL);
+        error_capture_end();
+        for (int i = 0; i < batch->count; i++) {
+            if (ends[i]) ends[i]->right = NULL;
+        }
+        owner->failed = !owner->object;
     }
     
-    closedir(dir);
-    return count;
+    bool stored = false;
+    if (owner->object) {
+        char* object_path = manifest_object_path(owner->queue->manifest, batch->object);
+        stored = save_fcef(owner->object, object_path);
+        xfree(object_path);
+    }
+    for (int i = 0; i < batch->count; i++) {
+        if (!stored) {
+            manifest_entry_free(&batch->jobs[i]->record);
+        }
+        ast_free(asts[i]);
+    }
+    xfree(ends);
+    xfree(asts);
 }
 
-// Compile folder
-static int compile_folder(const char* folder_path) {
-    DIR* dir = opendir(folder_path);
-    if (!dir) {
-        fprintf(stderr, "Error: Cannot open directory '%s'\n", folder_path);
-        return 1;
+// A batch is fresh when every member is unchanged and was last built in
+// this same batch; otherwise all of it is compiled again
+static void compile_batch(void* arg) {
+    UnityBatch* batch = arg;
+    CompileQueue* queue = batch->jobs[0]->queue;
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_SCAN);
+    bool fresh = true;
+    for (int i = 0; i < batch->count && fresh; i++) {
+        CompileJob* job = batch->jobs[i];
+        profile_trace_file(job->name);
+        job->previous = manifest_find(queue->manifest, job->name);
+        job->fresh = job->previous && strcmp(job->previous->object, batch->object) == 0 &&
+                     manifest_entry_fresh(job->previous, job->path, &job->record);
+        fresh = job->fresh;
+    }
+    for (int i = 0; i < batch->count && !fresh; i++) {
+        manifest_entry_free(&batch->jobs[i]->record);
+        batch->jobs[i]->fresh = false;
+    }
+    phase_leave(&scope);
+    if (!fresh) {
+        build_batch(batch);
+    }
+    
+    for (int i = 0; i < batch->count; i++) {
+        CompileJob* job = batch->jobs[i];
+        if (fresh) {
+            progress_skip(queue->progress);
+        } else {
+            progress_done(queue->progress, job->name, !job->failed);
+        }
+    }
+    pthread_mutex_lock(&queue->lock);
+    for (int i = 0; i < batch->count; i++) {
+        batch->jobs[i]->done = true;
+    }
+    pthread_cond_broadcast(&queue->finished);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static bool owns_object(const CompileJob* job) {
+    return !job->batch || job->batch->jobs[0] == job;
+}
+
+static void load_job(void* ctx, size_t i) {
+    CompileJob* job = ((CompileJob**)ctx)[i];
+    if (!owns_object(job) || !job->fresh) {
+        return;
+    }
+    profile_trace_file(job->name);
+    char* object_path = manifest_object_path(job->queue->manifest, job->record.object);
+    job->object = load_fcef(object_path);
+    xfree(object_path);
+    if (job->object) {
+        return;
+    }
+    // Cached object missing or damaged: build it again
+    if (job->batch) {
+        for (int m = 0; m < job->batch->count; m++) {
+            manifest_entry_free(&job->batch->jobs[m]->record);
+            job->batch->jobs[m]->fresh = false;
+        }
+        build_batch(job->batch);
+    } else {
+        manifest_entry_free(&job->record);
+        job->fresh = false;
+        error_capture_begin(&job->errors);
+        build_job(job);
+        error_capture_end();
+    }
+}
+
+// Scanner callback: queue the file right away so compiling overlaps the walk
+static void found_file(void* ctx, const char* name, const char* path) {
+    CompileQueue* queue = ctx;
+    CompileJob* job = xcalloc(1, sizeof(CompileJob));
+    job->queue = queue;
+    job->name = xstrdup(name);
+    job->path = xstrdup(path);
+    if (queue->count == queue->capacity) {
+        queue->capacity = queue->capacity ? queue->capacity * 2 : 64;
+        queue->jobs = xrealloc(queue->jobs, queue->capacity * sizeof(CompileJob*));
+    }
+    queue->jobs[queue->count++] = job;
+    progress_add_total(queue->progress, 1);
+    if (queue->to_read) {
+        queue_push(queue->to_read, job);
+    }
+}
+
+static int compare_jobs(const void* a, const void* b) {
+    return strcmp((*(CompileJob* const*)a)->name, (*(CompileJob* const*)b)->name);
+}
+
+static u64 link_flags(const LinkOptions* options) {
+    return (options->icf ? 1u : 0u) | (options->gc_sections ? 2u : 0u) |
+           ((u64)(options->level & 0xFF) << 8);
+}
+
+// Nothing to do when every input, the option set and the output itself
+// are exactly as the manifest recorded them
+static bool build_up_to_date(const Manifest* manifest, CompileJob* const* jobs, int count,
+                             const char* output_file, const LinkOptions* options) {
+    if (manifest->count != (size_t)count || manifest->link_flags != link_flags(options)) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!jobs[i]->fresh) return false;
+    }
+    FileStamp output;
+    return file_stamp_stat(output_file, &output) &&
+           output.mtime_ns == manifest->output.mtime_ns && output.size == manifest->output.size;
+}
+
+// Print a file's diagnostics without tearing the status line
+static void flush_errors(ErrorBuffer* errors, Progress* progress) {
+    if (errors->size == 0) {
+        return;
+    }
+    progress_pause(progress);
+    error_buffer_flush(errors, stderr);
+    progress_resume(progress);
+}
+
+static void report_failure(const char* name, ErrorBuffer* errors, Progress* progress) {
+    progress_pause(progress);
+    error_buffer_flush(errors, stderr);
+    printf("\033[31mError:\033[0m Failed to compile %s\n", name);
+    progress_resume(progress);
+}
+
+// Compile every C/C++ file under the folder. Files enter the pipeline,
+// compiling on `jobs` threads (0 = one per CPU), while the tree is still
+// being scanned, then are reported and linked in name order. Unchanged
+// files reuse the objects cached by the previous build. With `unity` > 0,
+// batches of about that many files are queued once the scan is done and
+// share one object.
+static int compile_folder(const char* folder_path, const char* output_file,
+                          int jobs, int unity, u64 flags, const LinkOptions* options) {
+    char* default_output = output_file ? NULL : folder_output_name(folder_path);
+    if (!output_file) {
+        output_file = default_output;
     }
     
-    int total_files = count_c_files(folder_path);
-    if (total_files == 0) {
+    int threads;
+    bool own_pool;
+    ThreadPool* pool = acquire_pool(jobs, &threads, &own_pool);
+    codegen_pool = pool;
+    
+    CompileQueue queue = {0};
+    queue.manifest = manifest_load(output_file, flags);
+    queue.flags = flags;
+    queue.unity = unity;
+    queue.pool = pool;
+    queue.progress = progress_start(stdout, "Compiling", 0);
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.finished, NULL);
+    manifest_prepare_dirs(queue.manifest);
+    if (pool && !unity) {
+        start_pipeline(&queue, threads);
+    }
+    
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_SCAN);
+    bool scanned = scan_project(folder_path, found_file, &queue, NULL);
+    phase_leave(&scope);
+    if (queue.to_read) {
+        queue_close(queue.to_read);
+    }
+    int total_files = queue.count;
+    if (!scanned) {
+        fprintf(stderr, "Error: Cannot open directory '%s'\n", folder_path);
+    } else if (total_files == 0) {
         printf("No C/C++ files found in '%s'\n", folder_path);
-        closedir(dir);
-        return 0;
+    }
+    if (!scanned || total_files == 0) {
+        stop_pipeline(&queue);
+        progress_finish(queue.progress);
+        codegen_pool = NULL;
+        if (own_pool) pool_destroy(pool);
+        pthread_cond_destroy(&queue.finished);
+        pthread_mutex_destroy(&queue.lock);
+        manifest_free((Manifest*)queue.manifest);
+        xfree(default_output);
+        return scanned ? 0 : 1;
+    }
+    qsort(queue.jobs, total_files, sizeof(CompileJob*), compare_jobs);
+    CompileJob** compile_jobs = queue.jobs;
+    if (unity) {
+        make_batches(&queue);
+        for (int i = 0; i < queue.batch_count && pool; i++) {
+            pool_submit(pool, compile_batch, &queue.batches[i]);
+        }
     }
     
-    struct dirent* entry;
+    // Report in order as results arrive, so the output never interleaves
     int failed_count = 0;
-    int current = 0;
+    int compiled_count = 0;
+    for (int i = 0; i < total_files; i++) {
+        CompileJob* job = compile_jobs[i];
+        if (pool) {
+            pthread_mutex_lock(&queue.lock);
+            while (!job->done) {
+                pthread_cond_wait(&queue.finished, &queue.lock);
+            }
+            pthread_mutex_unlock(&queue.lock);
+        } else if (job->batch && !job->done) {
+            compile_batch(job->batch);
+        } else if (!job->done) {
+            compile_job(job);
+        }
+        
+        if (job->compiled) {
+            compiled_count++;
+        }
+        if (job->failed) {
+            failed_count++;
+            report_failure(job->name, &job->errors, queue.progress);
+        } else {
+            flush_errors(&job->errors, queue.progress);
+        }
+        error_buffer_free(&job->errors);
+    }
+    stop_pipeline(&queue);
+    progress_finish(queue.progress);
+    queue.progress = NULL;
+    pthread_cond_destroy(&queue.finished);
+    pthread_mutex_destroy(&queue.lock);
     
-    rewinddir(dir);
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_name[0] == '.') continue;
+    bool up_to_date = failed_count == 0 &&
+                      build_up_to_date(queue.manifest, compile_jobs, total_files, output_file, options);
+    
+    int link_failed = 0;
+    if (up_to_date) {
+        printf("\033[32m       Fresh\033[0m %d files unchanged, executable: %s\n", total_files, output_file);
+    } else {
+        if (compiled_count < total_files) {
+            printf("\033[32m       Fresh\033[0m %d unchanged files reused\n", total_files - compiled_count);
+        }
+        CacheStats cache;
+        cache_stats(object_cache, &cache);
+        if (cache.hits > 0) {
+            printf("\033[32m      Cached\033[0m %zu files restored from the build cache\n", cache.hits);
+        }
+        if (queue.reused_functions > 0) {
+            printf("\033[32m      Reused\033[0m %zu unchanged functions in %d edited files\n",
+                   queue.reused_functions, queue.reused_files);
+        }
         
-        if (is_c_file(entry->d_name)) {
-            current++;
-            print_progress(current, total_files, entry->d_name, true);
-            
-            char filepath[1024];
-            snprintf(filepath, sizeof(filepath), "%s/%s", folder_path, entry->d_name);
-            
-            // Generate output filename (remove .c/.cpp extension)
-            char output_name[256];
-            strncpy(output_name, entry->d_name, sizeof(output_name) - 1);
-            output_name[sizeof(output_name) - 1] = '\0';
-            char* dot = strrchr(output_name, '.');
-            if (dot) *dot = '\0';
-            
-            if (compile_file_quiet_with_output(filepath, output_name) != 0) {
-                print_progress(current, total_files, entry->d_name, false);
-                failed_count++;
-                printf("\n\033[31mError:\033[0m Failed to compile %s\n", entry->d_name);
+        LinkInput* inputs = xcalloc(total_files, sizeof(LinkInput));
+        int input_count = 0;
+        if (failed_count == 0) {
+            pool_for(pool, total_files, load_job, compile_jobs);
+            for (int i = 0; i < total_files; i++) {
+                CompileJob* job = compile_jobs[i];
+                if (job->failed) {
+                    failed_count++;
+                    report_failure(job->name, &job->errors, NULL);
+                }
+                error_buffer_free(&job->errors);
+                if (job->object) {
+                    inputs[input_count].name = job->batch ? job->batch->name : job->name;
+                    inputs[input_count++].object = job->object;
+                }
+            }
+        }
+        
+        if (failed_count == 0) {
+            LinkOptions link_options = *options;
+            link_options.pool = pool;
+            link_options.threads = threads;
+            link_failed = link_folder(inputs, input_count, output_file, &link_options);
+        }
+        xfree(inputs);
+        
+        if (failed_count == 0 && !link_failed) {
+            printf("\033[32m    Finished\033[0m compiling %d files, executable: %s\n", total_files, output_file);
+        } else if (failed_count == 0) {
+            printf("\033[31m    Finished\033[0m compiling %d files, linking %s failed\n", total_files, output_file);
+        } else {
+            printf("\033[31m    Finished\033[0m with %d errors out of %d files, nothing linked\n", failed_count, total_files);
+        }
+    }
+    
+    // Failed files stay out of the manifest so they are retried next time.
+    // A no-op build only rewrites it when some file was touched but unchanged.
+    bool touched = false;
+    for (int i = 0; i < total_files; i++) {
+        const CompileJob* job = compile_jobs[i];
+        if (job->fresh && job->record.stamp.mtime_ns != job->previous->stamp.mtime_ns) {
+            touched = true;
+        }
+    }
+    if (!up_to_date || touched) {
+        Manifest* next = manifest_create(queue.manifest);
+        next->link_flags = link_flags(options);
+        if (up_to_date) {
+            next->output = queue.manifest->output;
+        } else if (failed_count == 0 && !link_failed) {
+            file_stamp_stat(output_file, &next->output);
+        }
+        for (int i = 0; i < total_files; i++) {
+            if (compile_jobs[i]->record.name) {
+                manifest_add(next, &compile_jobs[i]->record);
+            }
+        }
+        manifest_prune(queue.manifest, next);
+        if (!manifest_save(next)) {
+            fprintf(stderr, "Warning: Cannot write build manifest in '%s'\n", next->dir);
+        }
+        manifest_free(next);
+    }
+    
+    for (int i = 0; i < total_files; i++) {
+        CompileJob* job = compile_jobs[i];
+        eclc_free_output(job->object);
+        manifest_entry_free(&job->record);
+        xfree(job->name);
+        xfree(job->path);
+        xfree(job);
+    }
+    for (int i = 0; i < queue.batch_count; i++) {
+        xfree(queue.batches[i].object);
+        xfree(queue.batches[i].name);
+    }
+    xfree(queue.batches);
+    xfree(compile_jobs);
+    manifest_free((Manifest*)queue.manifest);
+    codegen_pool = NULL;
+    if (own_pool) pool_destroy(pool);
+    xfree(default_output);
+    return (failed_count > 0 || link_failed) ? 1 : 0;
+}
+
+// One input of a multi-file command line
+typedef struct {
+    const char* path;
+    char* output;               // Its own executable, NULL when linking them together
+    eclc_output_t* object;
+    bool ok;
+    ErrorBuffer errors;
+    Progress* progress;
+    u64 flags;                  // object_flags() of the command
+} InputJob;
+
+// <input without extension>.fcef, next to the input
+static char* input_output_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    const char* dot = strrchr(path, '.');
+    size_t len = dot && (!slash || dot > slash + 1) ? (size_t)(dot - path) : strlen(path);
+    char* name = xmalloc(len + 6);
+    memcpy(name, path, len);
+    strcpy(name + len, ".fcef");
+    return name;
+}
+
+static void compile_input(void* ctx, size_t i) {
+    InputJob* job = &((InputJob*)ctx)[i];
+    error_capture_begin(&job->errors);
+    profile_trace_file(job->path);
+    char* source = read_file(job->path);
+    CacheKey key = {0};
+    bool cached = false;
+    if (source && object_cache) {
+        key = source_key(source, job->path, job->flags);
+        if (job->output) {
+            cached = job->ok = cache_fetch(object_cache, &key, job->output);
+        } else {
+            job->object = cache_load(object_cache, &key);
+            cached = job->ok = job->object != NULL;
+        }
+    }
+    if (source && !cached) {
+        job->object = compile_to_object(source, job->path);
+        job->ok = job->object != NULL;
+        if (job->ok && job->output) {
+            job->ok = save_fcef(job->object, job->output);
+            if (!job->ok) {
+                error_report("Cannot create output file '%s'", job->output);
             }
         }
+        if (job->ok) {
+            cache_store(object_cache, &key, job->object);
+        }
+        if (job->output) {
+            eclc_free_output(job->object);
+            job->object = NULL;
+        }
+    }
+    xfree(source);
+    error_capture_end();
+    progress_done(job->progress, job->output ? job->output : job->path, job->ok);
+}
+
+// Several inputs in one process: with -o they are linked into one
+// executable, otherwise each becomes <name>.fcef as if compiled alone
+static int compile_files(const CompilerConfig* config, const LinkOptions* options) {
+    int count = config->file_count;
+    bool link = config->output_file != NULL;
+    InputJob* jobs = xcalloc(count, sizeof(InputJob));
+    Progress* progress = progress_start(stdout, "Compiling", count);
+    for (int i = 0; i < count; i++) {
+        jobs[i].progress = progress;
+        jobs[i].flags = object_flags(config);
+        jobs[i].path = config->input_files[i];
+        jobs[i].output = link ? NULL : input_output_name(jobs[i].path);
+    }
+    
+    int threads;
+    bool own_pool;
+    ThreadPool* pool = acquire_pool(config->jobs, &threads, &own_pool);
+    codegen_pool = pool;
+    pool_for(pool, count, compile_input, jobs);
+    progress_finish(progress);
+    
+    int failed_count = 0;
+    for (int i = 0; i < count; i++) {
+        InputJob* job = &jobs[i];
+        if (!job->ok) {
+            failed_count++;
+            report_failure(job->path, &job->errors, NULL);
+        } else {
+            error_buffer_flush(&job->errors, stderr);
+        }
+        error_buffer_free(&job->errors);
+    }
+    
+    int link_failed = 0;
+    if (link && failed_count == 0) {
+        LinkInput* inputs = xcalloc(count, sizeof(LinkInput));
+        for (int i = 0; i < count; i++) {
+            inputs[i].name = jobs[i].path;
+            inputs[i].object = jobs[i].object;
+        }
+        LinkOptions link_options = *options;
+        link_options.pool = pool;
+        link_options.threads = threads;
+        link_failed = link_folder(inputs, count, config->output_file, &link_options);
+        xfree(inputs);
     }
     
-    printf("\n");
-    if (failed_count == 0) {
-        printf("\033[32m    Finished\033[0m compiling %d files, %d executables generated\n", total_files, total_files);
+    if (failed_count > 0) {
+        printf("\033[31m    Finished\033[0m with %d errors out of %d files%s\n",
+               failed_count, count, link ? ", nothing linked" : "");
+    } else if (link_failed) {
+        printf("\033[31m    Finished\033[0m compiling %d files, linking %s failed\n", count, config->output_file);
+    } else if (link) {
+        printf("\033[32m    Finished\033[0m compiling %d files, executable: %s\n", count, config->output_file);
     } else {
-        printf("\033[31m    Finished\033[0m with %d errors out of %d files, %d executables generated\n", failed_count, total_files, total_files - failed_count);
+        printf("\033[32m    Finished\033[0m compiling %d files\n", count);
     }
     
-    closedir(dir);
-    return failed_count > 0 ? 1 : 0;
+    for (int i = 0; i < count; i++) {
+        eclc_free_output(jobs[i].object);
+        xfree(jobs[i].output);
+    }
+    xfree(jobs);
+    codegen_pool = NULL;
+    if (own_pool) pool_destroy(pool);
+    return (failed_count > 0 || link_failed) ? 1 : 0;
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <source_file> [-o output] | -f <folder>\n", argv[0]);
+// One source of `eclc --run`
+typedef struct {
+    const char* path;
+    ASTNode* ast;
+    ErrorBuffer errors;
+} RunInput;
+
+typedef struct {
+    char** paths;
+    int count;
+    int capacity;
+} PathList;
+
+static void found_run_file(void* ctx, const char* name, const char* path) {
+    (void)name;
+    PathList* list = ctx;
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->paths = xrealloc(list->paths, list->capacity * sizeof(char*));
+    }
+    list->paths[list->count++] = xstrdup(path);
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void parse_run_input(void* ctx, size_t i) {
+    RunInput* input = &((RunInput*)ctx)[i];
+    error_capture_begin(&input->errors);
+    profile_trace_file(input->path);
+    char* source = read_file(input->path);
+    input->ast = source ? parse_source(source, input->path) : NULL;
+    xfree(source);
+    error_capture_end();
+}
+
+// Evaluate and inline across all inputs, chained into one program for the calls
+static void optimize_run_inputs(RunInput* inputs, int count) {
+    ASTNode unit = {0};
+    unit.type = NODE_PROGRAM;
+    ASTNode** ends = xcalloc(count, sizeof(ASTNode*));
+    ASTNode** tail = &unit.left;
+    for (int i = 0; i < count; i++) {
+        for (*tail = inputs[i].ast->left; *tail; tail = &(*tail)->right) {
+            ends[i] = *tail;
+        }
+    }
+    consteval_calls(&unit, codegen_level);
+    inline_calls(&unit, codegen_level);
+    for (int i = 0; i < count; i++) {
+        if (ends[i]) ends[i]->right = NULL;
+    }
+    xfree(ends);
+}
+
+// --run: lower the inputs (or every file of the folder) to bytecode and
+// run main() in this process, translated to x86-64 on such hosts and
+// interpreted elsewhere, so code built for E-comOS can be tried on any
+// host. Its return value becomes the exit status and nothing
+// is written.
+static int run_program(const CompilerConfig* config) {
+    PathList list = {0};
+    if (config->folder_mode) {
+        PhaseScope scope;
+        phase_enter(&scope, PHASE_SCAN);
+        bool scanned = scan_project(config->folder_path, found_run_file, &list, NULL);
+        phase_leave(&scope);
+        if (!scanned) {
+            fprintf(stderr, "Error: Cannot open directory '%s'\n", config->folder_path);
+            return 1;
+        }
+        qsort(list.paths, list.count, sizeof(char*), compare_paths);
+    }
+    for (int i = 0; i < config->file_count; i++) {
+        found_run_file(&list, config->input_files[i], config->input_files[i]);
+    }
+    if (list.count == 0) {
+        fprintf(stderr, "Error: --run needs a source file or -f <folder>\n");
         return 1;
     }
     
-    // Check for folder compilation flag
-    if (argc >= 3 && strcmp(argv[1], "-f") == 0) {
-        return compile_folder(argv[2]);
+    RunInput* inputs = xcalloc(list.count, sizeof(RunInput));
+    for (int i = 0; i < list.count; i++) {
+        inputs[i].path = list.paths[i];
     }
+    int threads;
+    bool own_pool;
+    ThreadPool* pool = acquire_pool(config->jobs, &threads, &own_pool);
+    pool_for(list.count > 1 ? pool : NULL, list.count, parse_run_input, inputs);
+    if (own_pool) pool_destroy(pool);
     
-    // Parse arguments for single file compilation
-    const char* input_file = argv[1];
-    const char* output_file = NULL;
+    bool ok = true;
+    for (int i = 0; i < list.count; i++) {
+        error_buffer_flush(&inputs[i].errors, stderr);
+        error_buffer_free(&inputs[i].errors);
+        ok = ok && inputs[i].ast;
+    }
+    InterpProgram* program = interp_create();
+    PhaseScope scope;
+    phase_enter(&scope, PHASE_CODEGEN);
+    if (ok) {
+        optimize_run_inputs(inputs, list.count);
+        for (int i = 0; i < list.count; i++) {
+            ok = interp_add_unit(program, inputs[i].ast, inputs[i].path) && ok;
+        }
+        ok = ok && interp_link(program);
+    }
+    // Native code where the host can run it, unless ECLC_JIT=0
+    const char* env = getenv("ECLC_JIT");
+    JitCode* jit = ok && !(env && strcmp(env, "0") == 0) ? jit_compile(program) : NULL;
+    phase_leave(&scope);
     
-    // Look for -o flag
-    for (int i = 2; i < argc - 1; i++) {
-        if (strcmp(argv[i], "-o") == 0) {
-            if (i + 1 < argc) {
-                output_file = argv[i + 1];
-                break;
-            } else {
-                fprintf(stderr, "Error: -o requires output filename\n");
-                return 1;
-            }
+    int result = 1;
+    int value;
+    if (ok && (jit ? jit_run(jit, "main", &value) : interp_run(program, "main", &value, NULL))) {
+        result = value;
+    }
+    jit_free(jit);
+    interp_free(program);
+    for (int i = 0; i < list.count; i++) {
+        ast_free(inputs[i].ast);
+        xfree(list.paths[i]);
+    }
+    xfree(inputs);
+    xfree(list.paths);
+    return result;
+}
+
+// One command line, run directly or on behalf of a compile server client
+static int run_command(int argc, char* argv[]) {
+    CompilerConfig config = parse_arguments(argc, argv);
+    if (config.time_report || config.mem_report || config.trace_path) {
+        profile_reset();
+        peephole_reset();
+        profile_flags = (config.time_report ? PROFILE_TIME : 0) |
+                        (config.mem_report ? PROFILE_MEM : 0) |
+                        (config.trace_path ? PROFILE_TRACE : 0);
+    }
+    codegen_level = config.optimization_level;
+    LinkOptions link_options = {0};
+    link_options.icf = config.icf;
+    link_options.gc_sections = config.gc_sections;
+    link_options.level = config.optimization_level;
+    
+    // Only commands that write objects use the build cache
+    bool writes_objects = !config.error && !config.show_help && !config.show_version &&
+                          !config.inspect && !config.run && (config.folder_mode || config.output_file ||
+                                              config.file_count > 1);
+    object_cache = writes_objects && !config.no_cache ? cache_open() : NULL;
+    
+    int result = 0;
+    if (config.error) {
+        fprintf(stderr, "Error: %s\n", config.error);
+        result = 1;
+    } else if (config.show_help) {
+        print_help();
+    } else if (config.show_version) {
+        printf("ECLC - E-comOS C/C++ Language Compiler (object format %d)\n", ECLC_OBJECT_VERSION);
+    } else if (config.inspect) {
+        // Validate existing FCEF files
+        InspectOptions inspect_options = { config.jobs, config.json };
+        result = eclc_inspect((const char* const*)config.input_files, config.file_count,
+                              &inspect_options);
+    } else if (config.run) {
+        result = run_program(&config);
+    } else if (config.folder_mode) {
+        result = compile_folder(config.folder_path, config.output_file, config.jobs,
+                                config.unity, object_flags(&config), &link_options);
+    } else if (config.file_count == 0) {
+        fprintf(stderr, "Usage: %s <source_file>... [-o output] | -f <folder> [-o output] [-j jobs] [--icf] [--gc-sections]\n"
+                        "       %s --inspect [--json] [-j threads] <file|dir>...\n"
+                        "       %s --server [socket] | --client <command>...\n", argv[0], argv[0], argv[0]);
+        result = 1;
+    } else if (config.file_count == 1) {
+        int threads;
+        bool own_pool;
+        codegen_pool = acquire_pool(config.jobs, &threads, &own_pool);
+        result = compile_file_with_output(config.input_files[0], config.output_file,
+                                          object_flags(&config));
+        if (own_pool) pool_destroy(codegen_pool);
+        codegen_pool = NULL;
+    } else {
+        result = compile_files(&config, &link_options);
+    }
+    
+    cache_close(object_cache);
+    object_cache = NULL;
+    
+    fflush(stdout);
+    unsigned flags = profile_flags;
+    profile_flags = 0;
+    if (flags & PROFILE_TIME) {
+        profile_report_time(stderr, config.time_report_json);
+        peephole_report(stderr, config.time_report_json);
+    }
+    if (flags & PROFILE_MEM) {
+        profile_report_mem(stderr, config.mem_report_json);
+    }
+    if ((flags & PROFILE_TRACE) && !profile_write_trace(config.trace_path)) {
+        fprintf(stderr, "Error: Cannot write trace file '%s'\n", config.trace_path);
+        result = 1;
+    }
+    free_config(&config);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    // Stay resident and serve command lines from `eclc --client`
+    if (argc >= 2 && strcmp(argv[1], "--server") == 0) {
+        char* socket_path = argc >= 3 ? xstrdup(argv[2]) : server_socket_path();
+        if (!socket_path) {
+            return 1;
         }
+        shared_pool = pool_create(0);
+        int result = eclc_server(socket_path, run_command);
+        pool_destroy(shared_pool);
+        xfree(socket_path);
+        return result;
     }
     
-    // Handle case where -o is provided without filename
-    if (argc >= 3 && strcmp(argv[argc-1], "-o") == 0) {
-        fprintf(stderr, "Error: -o requires output filename\n");
-        return 1;
+    // Forward to a running server, or do the work here when there is none
+    if (argc >= 2 && strcmp(argv[1], "--client") == 0) {
+        argv[1] = argv[0];
+        char* socket_path = server_socket_path();
+        int result = socket_path ? eclc_client(socket_path, argc - 1, argv + 1) : -1;
+        xfree(socket_path);
+        return result >= 0 ? result : run_command(argc - 1, argv + 1);
     }
     
-    // Single file compilation
-    return compile_file_with_output(input_file, output_file);
-}
\ No newline at end of file
+    return run_command(argc, argv);
+}
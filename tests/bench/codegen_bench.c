@@ -0,0 +1,103 @@
+/**
+ * Code generation of one large translation unit: functions generated one
+ * after another vs. spread over pools of 2, 4, ... threads. Every parallel
+ * output is checked to be byte-identical to the serial one.
+ *
+ * Build and run: make bench && ./bin/bench/codegen_bench [functions]
+ */
+#define _POSIX_C_SOURCE 199309L
+#include "eclc/ast.h"
+#include "eclc/codegen.h"
+#include "eclc/pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Functions returning constants, calling each other and calling out
+static char *make_source(int count) {
+    size_t capacity = (size_t)count * 64 + 1;
+    char *source = malloc(capacity);
+    size_t len = 0;
+    for (int f = 0; f < count; f++) {
+        if (f % 3 == 1) {
+            len += snprintf(source + len, capacity - len,
+                            "int fn_%d() { return fn_%d(); }\n", f, (f * 7919) % count);
+        } else if (f % 7 == 0) {
+            len += snprintf(source + len, capacity - len,
+                            "int fn_%d() { return extern_%d(); }\n", f, f % 13);
+        } else {
+            len += snprintf(source + len, capacity - len,
+                            "int fn_%d() { return %d; }\n", f, (f * 7919) % 1000000);
+        }
+    }
+    return source;
+}
+
+static bool same_output(const eclc_output_t *a, const eclc_output_t *b) {
+    return a->code_size == b->code_size && memcmp(a->code, b->code, a->code_size) == 0 &&
+           a->symbol_count == b->symbol_count &&
+           memcmp(a->symbols, b->symbols, a->symbol_count * sizeof(fcef_symbol_t)) == 0 &&
+           a->reloc_count == b->reloc_count &&
+           memcmp(a->relocs, b->relocs, a->reloc_count * sizeof(fcef_reloc_t)) == 0 &&
+           a->strtab_size == b->strtab_size && memcmp(a->strtab, b->strtab, a->strtab_size) == 0;
+}
+
+static double time_codegen(ASTNode *ast, ThreadPool *pool, eclc_output_t **output) {
+    CodegenOptions options = { pool, NULL, 0 };
+    double best = 1e9;
+    for (int rep = 0; rep < 5; rep++) {
+        double t0 = now_sec();
+        eclc_output_t *out = codegen_generate_with(ast, &options);
+        double t = now_sec() - t0;
+        if (t < best) best = t;
+        if (rep == 0) {
+            *output = out;
+        } else {
+            eclc_free_output(out);
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 50000;
+    char *source = make_source(count);
+    TokenStream *tokens = tokenize(source);
+    Parser *parser = parser_create(tokens, "bench.c");
+    ASTNode *ast = parser_parse(parser);
+    if (!ast) {
+        fprintf(stderr, "parse failed\n");
+        return 1;
+    }
+
+    eclc_output_t *serial_out;
+    double serial = time_codegen(ast, NULL, &serial_out);
+    printf("%d functions, %d CPUs  serial %8.2f ms\n", count, pool_cpu_count(), serial * 1e3);
+    int cpus = pool_cpu_count();
+    for (int threads = 2; threads <= (cpus > 8 ? cpus : 8); threads *= 2) {
+        ThreadPool *pool = pool_create(threads);
+        eclc_output_t *out;
+        double t = time_codegen(ast, pool, &out);
+        pool_destroy(pool);
+        if (!same_output(serial_out, out)) {
+            fprintf(stderr, "%d threads: output differs from serial codegen\n", threads);
+            return 1;
+        }
+        eclc_free_output(out);
+        printf("%27d threads %8.2f ms  speedup %5.2fx\n", threads, t * 1e3, serial / t);
+    }
+
+    eclc_free_output(serial_out);
+    ast_free(ast);
+    parser_destroy(parser);
+    token_stream_free(tokens);
+    free(source);
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * Folder-style compile throughput: translation units compiled one after
+ * another vs. spread over the work-stealing pool.
+ *
+ * Build and run: make bench && ./bin/bench/compile_bench
+ */
+#define _POSIX_C_SOURCE 199309L
+#include "eclc/ast.h"
+#include "eclc/codegen.h"
+#include "eclc/pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FUNCS_PER_FILE 200
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Source of file `index`: functions returning constants or calling each other
+static char *make_source(int index) {
+    size_t capacity = FUNCS_PER_FILE * 64 + 1;
+    char *source = malloc(capacity);
+    size_t len = 0;
+    for (int f = 0; f < FUNCS_PER_FILE; f++) {
+        if (f % 3 == 2) {
+            len += snprintf(source + len, capacity - len,
+                            "int fn_%d_%d() { return fn_%d_%d(); }\n", index, f, index, f - 1);
+        } else {
+            len += snprintf(source + len, capacity - len,
+                            "int fn_%d_%d() { return %d; }\n", index, f, index * 1000 + f);
+        }
+    }
+    return source;
+}
+
+typedef struct {
+    char **sources;
+    size_t bytes;
+    int failed;
+} Corpus;
+
+static void compile_one(void *ctx, size_t i) {
+    Corpus *corpus = ctx;
+    TokenStream *tokens = tokenize(corpus->sources[i]);
+    Parser *parser = parser_create(tokens, "bench.c");
+    ASTNode *ast = parser_parse(parser);
+    eclc_output_t *object = ast ? codegen_generate(ast) : NULL;
+    if (!object) {
+        __atomic_add_fetch(&corpus->failed, 1, __ATOMIC_RELAXED);
+    }
+    eclc_free_output(object);
+    ast_free(ast);
+    parser_destroy(parser);
+    token_stream_free(tokens);
+}
+
+static double time_compile(Corpus *corpus, int count, ThreadPool *pool) {
+    double best = 1e9;
+    for (int rep = 0; rep < 3; rep++) {
+        double t0 = now_sec();
+        pool_for(pool, count, compile_one, corpus);
+        double t = now_sec() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(void) {
+    int counts[] = { 10, 100, 1000, 4000 };
+    int cpus = pool_cpu_count();
+    ThreadPool *pool = pool_create(0);
+
+    printf("%d CPUs, %d functions per file\n", cpus, FUNCS_PER_FILE);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        int count = counts[c];
+        Corpus corpus = { calloc(count, sizeof(char *)), 0, 0 };
+        for (int i = 0; i < count; i++) {
+            corpus.sources[i] = make_source(i);
+            corpus.bytes += strlen(corpus.sources[i]);
+        }
+
+        double serial = time_compile(&corpus, count, NULL);
+        double parallel = time_compile(&corpus, count, pool);
+        if (corpus.failed) {
+            fprintf(stderr, "compile failed\n");
+            return 1;
+        }
+        printf("%6d files  serial %8.2f ms  parallel %8.2f ms  speedup %5.2fx  %.1f MB/s\n",
+               count, serial * 1e3, parallel * 1e3, serial / parallel,
+               corpus.bytes / 1e6 / parallel);
+
+        for (int i = 0; i < count; i++) {
+            free(corpus.sources[i]);
+        }
+        free(corpus.sources);
+    }
+    pool_destroy(pool);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * Throughput of the --run interpreter: bytecode instructions per second
+ * on call chains of several depths, plus how fast units are lowered and
+ * linked. Each chain is main -> fn_0 -> ... -> fn_{depth-1}, which
+ * returns a constant, so every run executes 2 * depth + 1 instructions.
+ *
+ * Build and run: make bench && ./bin/bench/interp_bench [instructions]
+ */
+#define _POSIX_C_SOURCE 199309L
+#include "eclc/ast.h"
+#include "eclc/interp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *make_chain(int depth) {
+    size_t capacity = (size_t)depth * 48 + 64;
+    char *source = malloc(capacity);
+    size_t len = snprintf(source, capacity, "int main() { return fn_0(); }\n");
+    for (int f = 0; f < depth; f++) {
+        if (f + 1 < depth) {
+            len += snprintf(source + len, capacity - len,
+                            "int fn_%d() { return fn_%d(); }\n", f, f + 1);
+        } else {
+            len += snprintf(source + len, capacity - len, "int fn_%d() { return 7; }\n", f);
+        }
+    }
+    return source;
+}
+
+static ASTNode *parse(const char *source) {
+    TokenStream *tokens = tokenize(source);
+    Parser *parser = parser_create(tokens, "bench.c");
+    ASTNode *ast = parser_parse(parser);
+    parser_destroy(parser);
+    token_stream_free(tokens);
+    return ast;
+}
+
+int main(int argc, char **argv) {
+    double budget = argc > 1 ? atof(argv[1]) : 2e8;    // Instructions per depth
+    const int depths[] = { 1, 10, 1000, 100000 };
+
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        int depth = depths[d];
+        char *source = make_chain(depth);
+        ASTNode *ast = parse(source);
+        if (!ast) {
+            fprintf(stderr, "parse failed\n");
+            return 1;
+        }
+
+        double t0 = now_sec();
+        InterpProgram *program = interp_create();
+        if (!interp_add_unit(program, ast, "bench.c") || !interp_link(program)) {
+            return 1;
+        }
+        double lower = now_sec() - t0;
+
+        long runs = (long)(budget / (2.0 * depth + 1));
+        if (runs < 1) runs = 1;
+        InterpStats stats;
+        u64 executed = 0, calls = 0;
+        t0 = now_sec();
+        for (long i = 0; i < runs; i++) {
+            int result;
+            if (!interp_run(program, "main", &result, &stats) || result != 7) {
+                fprintf(stderr, "depth %d: wrong result\n", depth);
+                return 1;
+            }
+            executed += stats.instructions;
+            calls += stats.calls;
+        }
+        double t = now_sec() - t0;
+        size_t code_size;
+        interp_code(program, &code_size);
+        printf("depth %6d  %8ld runs  %7.1f M ops/s  %5.2f ns/op  %7.1f M calls/s  "
+               "lowered %zu insns in %.3f ms\n",
+               depth, runs, executed / t / 1e6, t * 1e9 / executed, calls / t / 1e6,
+               code_size, lower * 1e3);
+
+        interp_free(program);
+        ast_free(ast);
+        free(source);
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ * The --run JIT: how fast bytecode is translated to x86-64, how fast the
+ * result runs next to the interpreter, and the latency from source text
+ * to main()'s value compared with compiling to an FCEF file and loading
+ * it back.
+ *
+ * Build and run: make bench && ./bin/bench/jit_bench [functions]
+ */
+#define _POSIX_C_SOURCE 199309L
+#include "eclc/ast.h"
+#include "eclc/codegen.h"
+#include "eclc/interp.h"
+#include "eclc/jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// main -> fn_0 -> ... -> fn_{depth-1}, which returns 7
+static char *make_chain(int depth) {
+    size_t capacity = (size_t)depth * 48 + 64;
+    char *source = malloc(capacity);
+    size_t len = snprintf(source, capacity, "int main() { return fn_0(); }\n");
+    for (int f = 0; f < depth; f++) {
+        if (f + 1 < depth) {
+            len += snprintf(source + len, capacity - len,
+                            "int fn_%d() { return fn_%d(); }\n", f, f + 1);
+        } else {
+            len += snprintf(source + len, capacity - len, "int fn_%d() { return 7; }\n", f);
+        }
+    }
+    return source;
+}
+
+static ASTNode *parse(const char *source) {
+    TokenStream *tokens = tokenize(source);
+    Parser *parser = parser_create(tokens, "bench.c");
+    ASTNode *ast = parser_parse(parser);
+    parser_destroy(parser);
+    token_stream_free(tokens);
+    return ast;
+}
+
+static InterpProgram *lower(ASTNode *ast) {
+    InterpProgram *program = interp_create();
+    if (!interp_add_unit(program, ast, "bench.c") || !interp_link(program)) {
+        exit(1);
+    }
+    return program;
+}
+
+// Source to main()'s value through the JIT
+static int jit_latency(const char *source) {
+    ASTNode *ast = parse(source);
+    InterpProgram *program = lower(ast);
+    JitCode *jit = jit_compile(program);
+    int result = -1;
+    jit_run(jit, "main", &result);
+    jit_free(jit);
+    interp_free(program);
+    ast_free(ast);
+    return result;
+}
+
+// Source to an FCEF file on disk and back into memory, not run
+static int disk_latency(const char *source, const char *path) {
+    ASTNode *ast = parse(source);
+    eclc_output_t *out = codegen_generate(ast);
+    eclc_save_fcef(out, path);
+    eclc_free_output(out);
+    out = eclc_load_fcef(path);
+    int ok = out != NULL;
+    eclc_free_output(out);
+    ast_free(ast);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (!jit_available()) {
+        printf("no JIT on this host\n");
+        return 0;
+    }
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+
+    // Translation throughput
+    char *source = make_chain(count);
+    ASTNode *ast = parse(source);
+    InterpProgram *program = lower(ast);
+    double t0, best = 1e9;
+    JitCode *jit = NULL;
+    for (int rep = 0; rep < 5; rep++) {
+        jit_free(jit);
+        t0 = now_sec();
+        jit = jit_compile(program);
+        double t = now_sec() - t0;
+        if (t < best) best = t;
+    }
+    size_t insns;
+    interp_code(program, &insns);
+    printf("compile  %d functions, %zu insns -> %zu bytes in %.2f ms  "
+           "(%.1f M functions/s, %.0f MB/s)\n",
+           count + 1, insns, jit_code_size(jit), best * 1e3,
+           (count + 1) / best / 1e6, jit_code_size(jit) / best / 1e6);
+
+    jit_free(jit);
+    interp_free(program);
+    ast_free(ast);
+    free(source);
+
+    // Execution: chains of several depths, JIT vs interpreter
+    const int depths[] = { 10, 1000, count };
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        int depth = depths[d];
+        source = make_chain(depth);
+        ast = parse(source);
+        program = lower(ast);
+        jit = jit_compile(program);
+        long runs = 20000000 / (depth + 1) + 1;
+        int result;
+        t0 = now_sec();
+        for (long i = 0; i < runs; i++) {
+            if (!jit_run(jit, "main", &result) || result != 7) return 1;
+        }
+        double jit_time = (now_sec() - t0) / runs;
+        t0 = now_sec();
+        for (long i = 0; i < runs; i++) {
+            if (!interp_run(program, "main", &result, NULL) || result != 7) return 1;
+        }
+        double interp_time = (now_sec() - t0) / runs;
+        printf("run      %6d calls deep: jit %6.2f ns/call, interpreter %6.2f ns/call, %.2fx\n",
+               depth + 1, jit_time * 1e9 / (depth + 1), interp_time * 1e9 / (depth + 1),
+               interp_time / jit_time);
+        jit_free(jit);
+        interp_free(program);
+        ast_free(ast);
+        free(source);
+    }
+
+    // Latency of a small program
+    source = make_chain(10);
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/eclc_jit_bench_%d.fcef", (int)getpid());
+    double best_jit = 1e9, best_disk = 1e9;
+    for (int rep = 0; rep < 200; rep++) {
+        t0 = now_sec();
+        if (jit_latency(source) != 7) return 1;
+        double t = now_sec() - t0;
+        if (t < best_jit) best_jit = t;
+        t0 = now_sec();
+        if (!disk_latency(source, path)) return 1;
+        t = now_sec() - t0;
+        if (t < best_disk) best_disk = t;
+    }
+    unlink(path);
+    printf("latency  11 functions: source to result %.1f us, to FCEF on disk and loaded %.1f us, "
+           "%.1fx\n", best_jit * 1e6, best_disk * 1e6, best_disk / best_jit);
+    free(source);
+    return 0;
+}
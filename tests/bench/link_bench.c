@@ -0,0 +1,118 @@
+/**
+ * Link time by object count, serial vs. thread pool.
+ *
+ * Build and run: make bench && ./bin/bench/link_bench
+ */
+#define _POSIX_C_SOURCE 199309L
+#include "eclc/link.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FUNCS_PER_OBJECT 16
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+// Object `index`: functions calling into other objects, one string literal
+// shared by every object and one unique to it
+static eclc_output_t *make_object(int index, int total) {
+    eclc_output_t *obj = calloc(1, sizeof(eclc_output_t));
+    char name[64];
+
+    obj->code_size = FUNCS_PER_OBJECT * 16;
+    obj->code = malloc(obj->code_size);
+    for (int f = 0; f < FUNCS_PER_OBJECT; f++) {
+        uint8_t *p = obj->code + f * 16;
+        put32(p, 0xA9BF7BFD);       // stp x29, x30, [sp, #-16]!
+        put32(p + 4, 0x94000000);   // bl
+        put32(p + 8, 0xA8C17BFD);   // ldp x29, x30, [sp], #16
+        put32(p + 12, 0xD65F03C0);  // ret
+
+        snprintf(name, sizeof(name), "%s_%d_%d", index == 0 && f == 0 ? "main" : "fn", index, f);
+        eclc_add_symbol(obj, index == 0 && f == 0 ? "main" : name, FCEF_SEC_TEXT,
+                        f * 16, 16, FCEF_BIND_GLOBAL, FCEF_SYM_FUNC);
+
+        int target = (index * 7 + f * 13 + 1) % total;
+        int target_fn = (f + 1) % FUNCS_PER_OBJECT;
+        snprintf(name, sizeof(name), "fn_%d_%d", target, target_fn);
+        if (target == 0 && target_fn == 0) strcpy(name, "main");
+        uint32_t sym = eclc_add_symbol(obj, name, FCEF_SEC_UNDEF, 0, 0,
+                                       FCEF_BIND_GLOBAL, FCEF_SYM_NOTYPE);
+        eclc_add_reloc(obj, FCEF_SEC_TEXT, f * 16 + 4, sym, FCEF_RELOC_CALL26, 0);
+    }
+
+    const char *shared = "Hello from ECLC compiler!\n";
+    snprintf(name, sizeof(name), "object %d says hi", index);
+    size_t shared_len = strlen(shared) + 1;
+    size_t unique_len = strlen(name) + 1;
+    obj->rodata_size = shared_len + unique_len;
+    obj->rodata = malloc(obj->rodata_size);
+    memcpy(obj->rodata, shared, shared_len);
+    memcpy(obj->rodata + shared_len, name, unique_len);
+    eclc_add_symbol(obj, ".L.str.0", FCEF_SEC_RODATA, 0, (uint32_t)shared_len,
+                    FCEF_BIND_LOCAL, FCEF_SYM_OBJECT);
+    eclc_add_symbol(obj, ".L.str.1", FCEF_SEC_RODATA, (uint32_t)shared_len,
+                    (uint32_t)unique_len, FCEF_BIND_LOCAL, FCEF_SYM_OBJECT);
+
+    eclc_finalize_symbols(obj);
+    return obj;
+}
+
+static double time_link(LinkInput *inputs, int count, int threads, LinkStats *stats) {
+    LinkOptions options = {0};
+    options.threads = threads;
+    double best = 1e9;
+    for (int rep = 0; rep < 3; rep++) {
+        double t0 = now_sec();
+        eclc_output_t *out = eclc_link(inputs, count, &options, stats);
+        double t = now_sec() - t0;
+        if (!out) {
+            fprintf(stderr, "link failed\n");
+            exit(1);
+        }
+        eclc_free_output(out);
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(void) {
+    int counts[] = { 10, 100, 1000, 5000, 20000 };
+    int cpus = pool_cpu_count();
+
+    printf("%d CPUs, %d functions per object\n", cpus, FUNCS_PER_OBJECT);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        int count = counts[c];
+        LinkInput *inputs = calloc(count, sizeof(LinkInput));
+        for (int i = 0; i < count; i++) {
+            inputs[i].name = "bench.c";
+            inputs[i].object = make_object(i, count);
+        }
+
+        LinkStats stats;
+        double serial = time_link(inputs, count, 1, &stats);
+        double parallel = time_link(inputs, count, 0, &stats);
+        printf("%6d objects  serial %8.2f ms  parallel %8.2f ms  speedup %5.2fx  "
+               "relocs %zu  rodata %zu -> %zu B\n",
+               count, serial * 1e3, parallel * 1e3, serial / parallel,
+               stats.relocations, stats.rodata_in, stats.rodata_out);
+
+        for (int i = 0; i < count; i++) {
+            eclc_free_output((eclc_output_t *)inputs[i].object);
+        }
+        free(inputs);
+    }
+    return 0;
+}
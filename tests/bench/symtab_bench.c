@@ -0,0 +1,100 @@
+/**
+ * Symbol lookup throughput of the FCEF GNU-style hash table.
+ *
+ * Build and run: make bench && ./bin/bench/symtab_bench
+ */
+#define _POSIX_C_SOURCE 199309L
+#include "fcef/eclc_fcef.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void make_name(char *buf, size_t size, const char *prefix, int i) {
+    snprintf(buf, size, "%s_%08x_%d", prefix, (unsigned)(i * 2654435761u), i);
+}
+
+static void bench(int count) {
+    eclc_output_t *out = calloc(1, sizeof(eclc_output_t));
+    char name[64];
+
+    // Code bytes are irrelevant here, one ret keeps eclc_to_fcef happy
+    out->code = malloc(4);
+    memcpy(out->code, "\xC0\x03\x5F\xD6", 4);
+    out->code_size = 4;
+
+    for (int i = 0; i < count; i++) {
+        make_name(name, sizeof(name), "func", i);
+        eclc_add_symbol(out, name, FCEF_SEC_TEXT, 0, 4, FCEF_BIND_GLOBAL, FCEF_SYM_FUNC);
+    }
+
+    double t0 = now_sec();
+    eclc_finalize_symbols(out);
+    double build = now_sec() - t0;
+
+    // Round trip through the file format so lookups use the loaded table
+    size_t size;
+    void *image = eclc_to_fcef(out, &size);
+    eclc_output_t *loaded = eclc_from_fcef(image, size);
+    free(image);
+    eclc_free_output(out);
+    if (!loaded) {
+        fprintf(stderr, "round trip failed\n");
+        exit(1);
+    }
+
+    char (*hits)[64] = malloc((size_t)count * 64);
+    char (*misses)[64] = malloc((size_t)count * 64);
+    for (int i = 0; i < count; i++) {
+        make_name(hits[i], 64, "func", i);
+        make_name(misses[i], 64, "miss", i);
+    }
+
+    int rounds = 2000000 / count + 1;
+    long found = 0;
+
+    t0 = now_sec();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            found += eclc_lookup_symbol(loaded, hits[i]) >= 0;
+        }
+    }
+    double hit_time = now_sec() - t0;
+
+    t0 = now_sec();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            found -= eclc_lookup_symbol(loaded, misses[i]) >= 0;
+        }
+    }
+    double miss_time = now_sec() - t0;
+
+    double lookups = (double)rounds * count;
+    if (found != (long)lookups) {
+        fprintf(stderr, "lookup mismatch: %ld of %.0f\n", found, lookups);
+        exit(1);
+    }
+    printf("%8d symbols  build %7.2f ms  hit %6.1f ns (%6.2f M/s)  miss %6.1f ns (%6.2f M/s)  table %zu B\n",
+           count, build * 1e3,
+           hit_time / lookups * 1e9, lookups / hit_time / 1e6,
+           miss_time / lookups * 1e9, lookups / miss_time / 1e6,
+           loaded->hash_size);
+
+    free(hits);
+    free(misses);
+    eclc_free_output(loaded);
+}
+
+int main(void) {
+    int sizes[] = { 100, 1000, 10000, 50000, 200000 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench(sizes[i]);
+    }
+    return 0;
+}
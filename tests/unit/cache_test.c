@@ -0,0 +1,154 @@
+/**
+ * Build cache: what the key covers, that a hit gives a writable file of
+ * its own, and that eviction drops the least recently used entries.
+ *
+ * Build and run: make test
+ */
+#include "eclc/cache.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static bool same_key(CacheKey a, CacheKey b) {
+    return a.hi == b.hi && a.lo == b.lo;
+}
+
+static void test_keys(const char* dir) {
+    ObjectCache* cache = cache_open_at(dir, 1 << 20, 1);
+    ObjectCache* rebuilt = cache_open_at(dir, 1 << 20, 2);
+    ManifestDep dep = { "util.h", { 0, 10, 0x1111 } };
+    ManifestDep edited = { "util.h", { 0, 10, 0x2222 } };
+    const char* source = "int main() { return 0; }\n";
+
+    CacheKey key = cache_key(cache, source, "a.c", &dep, 1, 0);
+    CHECK(same_key(key, cache_key(cache, source, "other/a.c", &dep, 1, 0)));
+    CHECK(!same_key(key, cache_key(cache, "int main() { return 1; }\n", "a.c", &dep, 1, 0)));
+    CHECK(!same_key(key, cache_key(cache, source, "a.c", &dep, 1, 1)));            // Flags
+    CHECK(!same_key(key, cache_key(cache, source, "a.c", &edited, 1, 0)));         // Include
+    CHECK(!same_key(key, cache_key(cache, source, "a.c", NULL, 0, 0)));
+    CHECK(!same_key(key, cache_key(cache, source, "a.cpp", &dep, 1, 0)));          // Language
+    CHECK(!same_key(key, cache_key(rebuilt, source, "a.c", &dep, 1, 0)));          // Compiler
+    cache_close(cache);
+    cache_close(rebuilt);
+}
+
+static eclc_output_t* make_object(uint8_t fill, size_t size) {
+    eclc_output_t* object = xcalloc(1, sizeof(eclc_output_t));
+    object->code = xmalloc(size);
+    memset(object->code, fill, size);
+    object->code_size = size;
+    return object;
+}
+
+static char* read_file_bytes(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    char* data = xmalloc(1 << 16);
+    *size = fread(data, 1, 1 << 16, file);
+    fclose(file);
+    return data;
+}
+
+static void test_hit(const char* dir) {
+    ObjectCache* cache = cache_open_at(dir, 1 << 20, 1);
+    CacheKey key = cache_key(cache, "hit", "hit.c", NULL, 0, 0);
+    eclc_output_t* object = make_object(0xAA, 64);
+    char* out = xmalloc(strlen(dir) + 16);
+    sprintf(out, "%s/out.fcef", dir);
+
+    CHECK(!cache_fetch(cache, &key, out));
+    CHECK(cache_store(cache, &key, object));
+    CHECK(cache_fetch(cache, &key, out));
+
+    struct stat st;
+    CHECK(stat(out, &st) == 0 && st.st_nlink == 1);
+    CHECK(access(out, W_OK) == 0);
+    size_t size;
+    char* original = read_file_bytes(out, &size);
+
+    // Rewriting the output must not reach the cache
+    FILE* file = fopen(out, "r+b");
+    CHECK(file != NULL);
+    if (file) {
+        fputs("garbage", file);
+        fclose(file);
+    }
+    CHECK(cache_fetch(cache, &key, out));
+    size_t again_size;
+    char* again = read_file_bytes(out, &again_size);
+    CHECK(original && again && size == again_size && memcmp(original, again, size) == 0);
+
+    eclc_output_t* loaded = cache_load(cache, &key);
+    CHECK(loaded && loaded->code_size == 64 && loaded->code[0] == 0xAA);
+    eclc_free_output(loaded);
+
+    CacheStats stats;
+    cache_stats(cache, &stats);
+    CHECK(stats.hits == 3 && stats.misses == 1 && stats.stores == 1);
+    xfree(again);
+    xfree(original);
+    xfree(out);
+    eclc_free_output(object);
+    cache_close(cache);
+}
+
+static void pause_ms(long ms) {
+    struct timespec ts = { 0, ms * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+// Three entries of one size in a cache that holds two and a half: after
+// `a` is used again, closing evicts `b`, the least recently used
+static void test_eviction(const char* dir) {
+    eclc_output_t* object = make_object(0x55, 4000);
+    size_t size;
+    void* image = eclc_to_fcef(object, &size);
+    xfree(image);
+
+    ObjectCache* cache = cache_open_at(dir, size * 5 / 2, 1);
+    CacheKey a = cache_key(cache, "a", "a.c", NULL, 0, 0);
+    CacheKey b = cache_key(cache, "b", "b.c", NULL, 0, 0);
+    CacheKey c = cache_key(cache, "c", "c.c", NULL, 0, 0);
+    CHECK(cache_store(cache, &a, object));
+    pause_ms(20);
+    CHECK(cache_store(cache, &b, object));
+    pause_ms(20);
+    CHECK(cache_store(cache, &c, object));
+    pause_ms(20);
+    eclc_output_t* used = cache_load(cache, &a);
+    CHECK(used != NULL);
+    eclc_free_output(used);
+    cache_close(cache);
+
+    cache = cache_open_at(dir, size * 5 / 2, 1);
+    eclc_output_t* left[3] = { cache_load(cache, &a), cache_load(cache, &b), cache_load(cache, &c) };
+    CHECK(left[0] != NULL);
+    CHECK(left[1] == NULL);
+    CHECK(left[2] != NULL);
+    for (int i = 0; i < 3; i++) {
+        eclc_free_output(left[i]);
+    }
+    cache_close(cache);
+    eclc_free_output(object);
+}
+
+int main(void) {
+    char dirs[3][32];
+    for (int i = 0; i < 3; i++) {
+        strcpy(dirs[i], "/tmp/eclc_cache_XXXXXX");
+        CHECK(mkdtemp(dirs[i]) != NULL);
+    }
+    test_keys(dirs[0]);
+    test_hit(dirs[1]);
+    test_eviction(dirs[2]);
+
+    for (int i = 0; i < 3; i++) {
+        char command[64];
+        snprintf(command, sizeof(command), "rm -rf '%s'", dirs[i]);
+        CHECK(system(command) == 0);
+    }
+    return check_result("cache_test");
+}
@@ -0,0 +1,25 @@
+/**
+ * Minimal assertions for the unit tests: CHECK records a failure and
+ * keeps going, check_result() turns the count into the exit status.
+ */
+#ifndef ECLC_TEST_CHECK_H
+#define ECLC_TEST_CHECK_H
+
+#include <stdio.h>
+
+static int check_failures;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                               \
+        }                                                                   \
+    } while (0)
+
+static inline int check_result(const char *name) {
+    printf("%s: %s\n", name, check_failures ? "FAILED" : "ok");
+    return check_failures ? 1 : 0;
+}
+
+#endif // ECLC_TEST_CHECK_H
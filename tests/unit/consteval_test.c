@@ -0,0 +1,110 @@
+/**
+ * Compile-time evaluation: values of call chains, calls that have none
+ * (cycles, other files, chains past the depth limit), which -O levels
+ * replace calls, and main collapsing to a constant from -O2 on.
+ *
+ * Build and run: make test
+ */
+#include "eclc/ast.h"
+#include "eclc/codegen.h"
+#include "eclc/consteval.h"
+#include "check.h"
+#include "emulate.h"
+#include <string.h>
+
+static const char* const program =
+    "int main() { return first(); }\n"
+    "int first() { return second(); }\n"
+    "int second() { return 305419896; }\n"
+    "int loop_a() { return loop_b(); }\n"
+    "int loop_b() { return loop_a(); }\n"
+    "int to_loop() { return loop_a(); }\n"
+    "int outside() { return elsewhere(); }\n";
+
+typedef struct {
+    TokenStream* tokens;
+    Parser* parser;
+    ASTNode* ast;
+} Unit;
+
+static Unit parse(const char* source) {
+    Unit unit;
+    unit.tokens = tokenize(source);
+    unit.parser = parser_create(unit.tokens, "consteval_test.c");
+    unit.ast = parser_parse(unit.parser);
+    CHECK(unit.ast != NULL);
+    return unit;
+}
+
+static void unit_free(Unit* unit) {
+    ast_free(unit->ast);
+    parser_destroy(unit->parser);
+    token_stream_free(unit->tokens);
+}
+
+static void test_values(void) {
+    Unit unit = parse(program);
+    int value = 0;
+    CHECK(consteval_function(unit.ast, "main", &value) && value == 305419896);
+    CHECK(consteval_function(unit.ast, "second", &value) && value == 305419896);
+    CHECK(!consteval_function(unit.ast, "loop_a", &value));
+    CHECK(!consteval_function(unit.ast, "to_loop", &value));
+    CHECK(!consteval_function(unit.ast, "outside", &value));
+    CHECK(!consteval_function(unit.ast, "missing", &value));
+    unit_free(&unit);
+}
+
+// f0 calls f1 ... calls f{functions-1}, which returns 7
+static void check_chain(size_t functions, bool known) {
+    size_t capacity = functions * 40 + 64;
+    char* source = malloc(capacity);
+    size_t len = 0;
+    for (size_t f = 0; f + 1 < functions; f++) {
+        len += snprintf(source + len, capacity - len, "int f%zu() { return f%zu(); }\n", f, f + 1);
+    }
+    snprintf(source + len, capacity - len, "int f%zu() { return 7; }\n", functions - 1);
+
+    Unit unit = parse(source);
+    int value = 0;
+    CHECK(consteval_function(unit.ast, "f0", &value) == known);
+    CHECK(!known || value == 7);
+    unit_free(&unit);
+    free(source);
+}
+
+// A chain one call longer than evaluation follows is left to run time
+static void test_depth_limit(void) {
+    check_chain(CONSTEVAL_MAX_DEPTH, true);
+    check_chain(CONSTEVAL_MAX_DEPTH + 1, false);
+}
+
+// Calls are only replaced from -O2 on; main then becomes movz, movk
+// and ret, where it branched to first before
+static void test_levels(void) {
+    for (int level = 0; level <= 3; level++) {
+        Unit unit = parse(program);
+        CHECK(consteval_calls(unit.ast, level) == (level < 2 ? 0u : 2u));
+        unit_free(&unit);
+
+        unit = parse(program);
+        CodegenOptions options = { NULL, NULL, level };
+        eclc_output_t* out = codegen_generate_with(unit.ast, &options);
+        Run run = emulate_symbol(out, "main");
+        CHECK(run.ok && run.w0 == 305419896);
+        long main_index = eclc_lookup_symbol(out, "main");
+        CHECK(main_index > 0);
+        if (level >= 2 && main_index > 0) {
+            CHECK(out->symbols[main_index].size == 12);
+            CHECK(run.executed == 3 && run.calls == 0);
+        }
+        eclc_free_output(out);
+        unit_free(&unit);
+    }
+}
+
+int main(void) {
+    test_values();
+    test_depth_limit();
+    test_levels();
+    return check_result("consteval_test");
+}
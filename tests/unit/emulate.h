@@ -0,0 +1,93 @@
+/**
+ * Runs generated AArch64 code for the unit tests: a tiny emulator of the
+ * instructions codegen emits (frames, calls, branches and w0 constants).
+ * Anything else stops the run and leaves `ok` false.
+ */
+#ifndef ECLC_TEST_EMULATE_H
+#define ECLC_TEST_EMULATE_H
+
+#include "fcef/eclc_fcef.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+    uint64_t executed;          // Instructions
+    uint64_t calls;             // bl executed
+    uint64_t max_stack;         // Bytes
+    uint32_t w0;
+    bool ok;                    // Returned to the caller with the stack balanced
+} Run;
+
+static inline uint32_t emulate_load32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline int64_t emulate_branch_offset(uint32_t insn) {
+    int64_t imm = insn & 0x03FFFFFF;
+    return (imm ^ 0x02000000) - 0x02000000;
+}
+
+#define EMULATE_RETURN UINT64_MAX  // Where the first call returns to
+#define EMULATE_LIMIT  (1u << 24)  // Instructions before giving up
+
+// Call the function at code offset `entry`
+static inline Run emulate(const eclc_output_t* out, uint64_t entry) {
+    Run run = {0};
+    size_t capacity = 1024;
+    uint64_t* stack = malloc(capacity * sizeof(uint64_t));
+    size_t sp = 0;              // Saved x29/x30 pairs
+    uint64_t pc = entry, x30 = EMULATE_RETURN;
+    while (pc != EMULATE_RETURN && run.executed < EMULATE_LIMIT) {
+        if (pc + 4 > out->code_size) {
+            break;
+        }
+        uint32_t insn = emulate_load32(out->code + pc);
+        run.executed++;
+        uint64_t next = pc + 4;
+        if (insn == 0xA9BF7BFDu) {                              // stp x29, x30, [sp, #-16]!
+            if (sp == capacity) {
+                capacity *= 2;
+                stack = realloc(stack, capacity * sizeof(uint64_t));
+            }
+            stack[sp++] = x30;
+            if (sp * 16 > run.max_stack) run.max_stack = sp * 16;
+        } else if (insn == 0xA8C17BFDu) {                       // ldp x29, x30, [sp], #16
+            if (sp == 0) break;
+            x30 = stack[--sp];
+        } else if (insn == 0x910003FDu) {                       // mov x29, sp
+        } else if (insn == 0xD65F03C0u) {                       // ret
+            next = x30;
+        } else if ((insn & 0xFC000000u) == 0x94000000u) {       // bl
+            run.calls++;
+            x30 = next;
+            next = pc + emulate_branch_offset(insn) * 4;
+        } else if ((insn & 0xFC000000u) == 0x14000000u) {       // b
+            next = pc + emulate_branch_offset(insn) * 4;
+        } else if ((insn & 0xFF80001Fu) == 0x52800000u) {       // movz w0
+            run.w0 = ((insn >> 5) & 0xFFFF) << ((insn >> 21 & 3) * 16);
+        } else if ((insn & 0xFF80001Fu) == 0x12800000u) {       // movn w0
+            run.w0 = ~(((insn >> 5) & 0xFFFF) << ((insn >> 21 & 3) * 16));
+        } else if ((insn & 0xFF80001Fu) == 0x72800000u) {       // movk w0
+            unsigned shift = (insn >> 21 & 3) * 16;
+            run.w0 = (run.w0 & ~(0xFFFFu << shift)) | (((insn >> 5) & 0xFFFF) << shift);
+        } else {
+            break;
+        }
+        pc = next;
+    }
+    run.ok = pc == EMULATE_RETURN && sp == 0;
+    free(stack);
+    return run;
+}
+
+// Call `name`, which must be a defined symbol of `out`
+static inline Run emulate_symbol(const eclc_output_t* out, const char* name) {
+    long index = eclc_lookup_symbol(out, name);
+    if (index < 0) {
+        Run none = {0};
+        return none;
+    }
+    return emulate(out, out->symbols[index].value);
+}
+
+#endif // ECLC_TEST_EMULATE_H
@@ -0,0 +1,196 @@
+/**
+ * FCEF objects: symbols, relocations, the hash table and rodata survive
+ * a save and load, the link section is written little-endian, and images
+ * with corrupt link tables fail verification and are rejected.
+ *
+ * Build and run: make test
+ */
+#include "fcef/eclc_fcef.h"
+#include "eclc/common.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t code[] = {
+    0x00, 0x00, 0x00, 0x94,     // bl helper
+    0xC0, 0x03, 0x5F, 0xD6,     // ret
+};
+static const char rodata[] = "hello";
+
+static eclc_output_t *make_object(void) {
+    eclc_output_t *out = xcalloc(1, sizeof(eclc_output_t));
+    out->code_size = sizeof(code);
+    out->code = xmalloc(sizeof(code));
+    memcpy(out->code, code, sizeof(code));
+    out->rodata_size = sizeof(rodata);
+    out->rodata = xmalloc(sizeof(rodata));
+    memcpy(out->rodata, rodata, sizeof(rodata));
+
+    uint32_t helper = eclc_add_symbol(out, "helper", FCEF_SEC_UNDEF, 0, 0,
+                                      FCEF_BIND_GLOBAL, FCEF_SYM_FUNC);
+    eclc_add_symbol(out, "main", FCEF_SEC_TEXT, 0, sizeof(code), FCEF_BIND_GLOBAL, FCEF_SYM_FUNC);
+    eclc_add_symbol(out, "greeting", FCEF_SEC_RODATA, 0, sizeof(rodata),
+                    FCEF_BIND_GLOBAL, FCEF_SYM_OBJECT);
+    eclc_add_symbol(out, "local", FCEF_SEC_TEXT, 4, 4, FCEF_BIND_LOCAL, FCEF_SYM_FUNC);
+    eclc_add_reloc(out, FCEF_SEC_TEXT, 0, helper, FCEF_RELOC_CALL26, 0);
+    eclc_finalize_symbols(out);
+    return out;
+}
+
+static void test_round_trip(void) {
+    eclc_output_t *out = make_object();
+    size_t size;
+    uint8_t *image = eclc_to_fcef(out, &size);
+    CHECK(image != NULL);
+    CHECK(eclc_fcef_verify(image, size, NULL) == ECLC_FCEF_OK);
+
+    eclc_output_t *back = eclc_from_fcef(image, size);
+    CHECK(back != NULL);
+    if (back) {
+        CHECK(back->code_size == out->code_size && memcmp(back->code, code, sizeof(code)) == 0);
+        CHECK(back->rodata_size == sizeof(rodata) && memcmp(back->rodata, rodata, sizeof(rodata)) == 0);
+        CHECK(back->symbol_count == out->symbol_count);
+        CHECK(memcmp(back->symbols, out->symbols, out->symbol_count * sizeof(fcef_symbol_t)) == 0);
+        CHECK(back->reloc_count == 1);
+        CHECK(memcmp(back->relocs, out->relocs, sizeof(fcef_reloc_t)) == 0);
+        CHECK(back->hash_size == out->hash_size && memcmp(back->hash, out->hash, out->hash_size) == 0);
+        CHECK(back->strtab_size == out->strtab_size && memcmp(back->strtab, out->strtab, out->strtab_size) == 0);
+
+        // The relocation still names the undefined helper after finalizing
+        const fcef_symbol_t *target = &back->symbols[back->relocs[0].symbol];
+        CHECK(strcmp(eclc_symbol_name(back, target), "helper") == 0);
+        CHECK(target->section == FCEF_SEC_UNDEF);
+
+        long main_index = eclc_lookup_symbol(back, "main");
+        long greeting = eclc_lookup_symbol(back, "greeting");
+        CHECK(main_index > 0 && back->symbols[main_index].section == FCEF_SEC_TEXT);
+        CHECK(greeting > 0 && back->symbols[greeting].section == FCEF_SEC_RODATA);
+        CHECK(eclc_lookup_symbol(back, "helper") == -1);    // Undefined
+        CHECK(eclc_lookup_symbol(back, "local") == -1);     // Not exported
+        CHECK(eclc_lookup_symbol(back, "missing") == -1);
+    }
+    eclc_free_output(back);
+    xfree(image);
+    eclc_free_output(out);
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// The link tables inside an image written by eclc_to_fcef, little-endian
+typedef struct {
+    uint8_t *link;
+    uint8_t *symbols;
+    uint8_t *relocs;
+    uint8_t *hash;
+} link_view_t;
+
+static link_view_t view_link(uint8_t *image) {
+    fcef_layout_t layout;
+    eclc_fcef_layout((const fcef_header_t *)image, &layout);
+    link_view_t view;
+    view.link = image + layout.link_offset;
+    view.symbols = view.link + sizeof(fcef_link_header_t);
+    view.relocs = view.symbols + get_le32(view.link + 4) * sizeof(fcef_symbol_t);
+    view.hash = view.relocs + get_le32(view.link + 8) * sizeof(fcef_reloc_t);
+    return view;
+}
+
+// The link section has the same bytes on any host
+static void test_link_byte_order(void) {
+    eclc_output_t *out = make_object();
+    out->relocs[0].addend = -8;
+    size_t size;
+    uint8_t *image = eclc_to_fcef(out, &size);
+    link_view_t view = view_link(image);
+
+    CHECK(memcmp(view.link, "FLNK", 4) == 0);
+    CHECK(get_le32(view.link + 4) == out->symbol_count);
+    CHECK(get_le32(view.link + 16) == out->strtab_size);
+    CHECK(get_le32(view.symbols + sizeof(fcef_symbol_t)) == out->symbols[1].name);
+    CHECK(get_le32(view.symbols + sizeof(fcef_symbol_t) + 8) == out->symbols[1].size);
+    CHECK(get_le32(view.relocs + 4) == out->relocs[0].symbol);
+    CHECK(memcmp(view.relocs + 8, "\xF8\xFF\xFF\xFF", 4) == 0);
+    const fcef_gnu_hash_t *gnu = (const fcef_gnu_hash_t *)out->hash;
+    CHECK(get_le32(view.hash) == gnu->nbuckets);
+    CHECK(get_le32(view.hash + 8) == gnu->bloom_size);
+
+    fcef_layout_t layout;
+    fcef_link_header_t link;
+    CHECK(eclc_fcef_verify(image, size, &layout) == ECLC_FCEF_OK);
+    CHECK(eclc_fcef_link_header(image, size, &layout, &link));
+    CHECK(link.magic == FCEF_LINK_MAGIC && link.symbol_count == out->symbol_count &&
+          link.reloc_count == 1 && link.hash_size == out->hash_size);
+
+    eclc_output_t *back = eclc_from_fcef(image, size);
+    CHECK(back && back->relocs[0].addend == -8);
+    eclc_free_output(back);
+    xfree(image);
+    eclc_free_output(out);
+}
+
+// Corrupt a fresh image with `mutate`, drop its CRC as old files do and
+// check that verifying and loading refuse it
+static void check_rejected(void (*mutate)(link_view_t *), const char *what) {
+    eclc_output_t *out = make_object();
+    size_t size;
+    uint8_t *image = eclc_to_fcef(out, &size);
+    link_view_t view = view_link(image);
+    mutate(&view);
+    ((fcef_header_t *)image)->crc32 = 0;
+
+    CHECK(eclc_fcef_verify(image, size, NULL) == ECLC_FCEF_BAD_LINK);
+    eclc_output_t *back = eclc_from_fcef(image, size);
+    if (back) {
+        fprintf(stderr, "accepted an image with %s\n", what);
+    }
+    CHECK(back == NULL);
+    eclc_free_output(back);
+    xfree(image);
+    eclc_free_output(out);
+}
+
+static void zero_hash(link_view_t *v) { memset(v->hash, 0, sizeof(fcef_gnu_hash_t)); }
+static void odd_bloom(link_view_t *v) { put_le32(v->hash + 8, 3); }
+static void wide_shift(link_view_t *v) { put_le32(v->hash + 12, 64); }
+static void big_symoffset(link_view_t *v) { put_le32(v->hash + 4, get_le32(v->link + 4) + 1); }
+static void many_buckets(link_view_t *v) { put_le32(v->hash, 1u << 20); }
+static void bad_name(link_view_t *v) {
+    put_le32(v->symbols + sizeof(fcef_symbol_t), get_le32(v->link + 16));
+}
+static void bad_reloc(link_view_t *v) { put_le32(v->relocs + 4, get_le32(v->link + 4)); }
+
+static void test_rejects_bad_tables(void) {
+    check_rejected(zero_hash, "a zeroed hash header");
+    check_rejected(odd_bloom, "a bloom size that is not a power of two");
+    check_rejected(wide_shift, "a bloom shift of 64");
+    check_rejected(big_symoffset, "symoffset past the symbols");
+    check_rejected(many_buckets, "buckets past the hash table");
+    check_rejected(bad_name, "a symbol name outside the string table");
+    check_rejected(bad_reloc, "a relocation against a missing symbol");
+}
+
+static void test_rejects_bad_crc(void) {
+    eclc_output_t *out = make_object();
+    size_t size;
+    uint8_t *image = eclc_to_fcef(out, &size);
+    image[sizeof(fcef_header_t)] ^= 1;
+    CHECK(eclc_fcef_verify(image, size, NULL) == ECLC_FCEF_BAD_CRC);
+    CHECK(eclc_from_fcef(image, size) == NULL);
+    xfree(image);
+    eclc_free_output(out);
+}
+
+int main(void) {
+    test_round_trip();
+    test_link_byte_order();
+    test_rejects_bad_tables();
+    test_rejects_bad_crc();
+    return check_result("fcef_test");
+}
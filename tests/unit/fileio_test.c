@@ -0,0 +1,141 @@
+/**
+ * Batched file I/O, once with whatever backend the thread gets and once
+ * with ECLC_IO_URING=0: contents round-trip across more than one batch,
+ * including empty files and files at and past FILEIO_SLOT; missing files
+ * and unwritable targets report their errno; no temporary file is left
+ * behind.
+ *
+ * Build and run: make test
+ */
+#include "eclc/fileio.h"
+#include "check.h"
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILES (FILEIO_BATCH + 8)    // Splits into two batches
+#define BAD 2                       // Unwritable targets at the end
+
+static size_t file_size(size_t i) {
+    switch (i) {
+    case 0: return 0;
+    case 1: return FILEIO_SLOT;
+    case 2: return 3 * FILEIO_SLOT + 7;
+    default: return 100 + i * 37;
+    }
+}
+
+static char* contents(size_t i, size_t round) {
+    size_t size = file_size(i);
+    char* data = xmalloc(size + 1);
+    for (size_t j = 0; j < size; j++) {
+        data[j] = (char)('a' + (i * 7 + j + round) % 26);
+    }
+    data[size] = '\0';
+    return data;
+}
+
+static size_t count_temps(const char* dir) {
+    size_t temps = 0;
+    DIR* listing = opendir(dir);
+    if (!listing) return SIZE_MAX;
+    struct dirent* entry;
+    while ((entry = readdir(listing)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        temps += length > 4 && strcmp(entry->d_name + length - 4, ".tmp") == 0;
+    }
+    closedir(listing);
+    return temps;
+}
+
+typedef struct {
+    const char* dir;
+    bool expect_sync;
+} Round;
+
+static void write_round(const char* dir, char** paths, size_t round) {
+    FileWrite writes[FILES + BAD];
+    char* data[FILES];
+    for (size_t i = 0; i < FILES; i++) {
+        data[i] = contents(i, round);
+        writes[i] = (FileWrite){ .path = paths[i], .data = data[i],
+                                 .size = file_size(i), .error = -1 };
+    }
+    for (size_t i = FILES; i < FILES + BAD; i++) {
+        writes[i] = (FileWrite){ .path = paths[i], .data = "x", .size = 1, .error = -1 };
+    }
+    fileio_write(writes, FILES + BAD);
+
+    size_t written = 0;
+    for (size_t i = 0; i < FILES; i++) written += writes[i].error == 0;
+    CHECK(written == FILES);
+    CHECK(writes[FILES].error == ENOENT);        // Under a missing folder
+    CHECK(writes[FILES + 1].error == ENOTDIR);   // Under a plain file
+    CHECK(count_temps(dir) == 0);
+
+    FileRead reads[FILES + 1];
+    for (size_t i = 0; i < FILES; i++) {
+        reads[i] = (FileRead){ .path = paths[i], .error = -1 };
+    }
+    reads[FILES] = (FileRead){ .path = paths[FILES], .error = -1 };
+    fileio_read(reads, FILES + 1);
+
+    size_t matched = 0;
+    for (size_t i = 0; i < FILES; i++) {
+        matched += reads[i].error == 0 && reads[i].data &&
+                   reads[i].size == file_size(i) &&
+                   memcmp(reads[i].data, data[i], file_size(i)) == 0 &&
+                   reads[i].data[file_size(i)] == '\0';
+        xfree(reads[i].data);
+        xfree(data[i]);
+    }
+    CHECK(matched == FILES);
+    CHECK(reads[FILES].error == ENOENT && reads[FILES].data == NULL);
+}
+
+static void* run_round(void* arg) {
+    Round* round = arg;
+    char* paths[FILES + BAD];
+    for (size_t i = 0; i < FILES + BAD; i++) {
+        paths[i] = xmalloc(strlen(round->dir) + 32);
+    }
+    for (size_t i = 0; i < FILES; i++) {
+        sprintf(paths[i], "%s/file%zu.o", round->dir, i);
+    }
+    sprintf(paths[FILES], "%s/missing/file.o", round->dir);
+    sprintf(paths[FILES + 1], "%s/file3.o/file.o", round->dir);
+
+    if (round->expect_sync) {
+        CHECK(!fileio_uring());
+    }
+    write_round(round->dir, paths, 0);
+    write_round(round->dir, paths, 1);      // Replaces every file
+
+    for (size_t i = 0; i < FILES + BAD; i++) xfree(paths[i]);
+    return NULL;
+}
+
+// The backend is chosen once per thread, so each setting gets its own
+static void run_thread(const char* dir, bool expect_sync) {
+    Round round = { dir, expect_sync };
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, run_round, &round) == 0);
+    pthread_join(thread, NULL);
+}
+
+int main(void) {
+    char dir[] = "/tmp/eclc_fileio_XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+
+    unsetenv("ECLC_IO_URING");
+    run_thread(dir, false);
+    setenv("ECLC_IO_URING", "0", 1);
+    run_thread(dir, true);
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf '%s'", dir);
+    CHECK(system(command) == 0);
+    return check_result("fileio_test");
+}
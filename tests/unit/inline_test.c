@@ -0,0 +1,116 @@
+/**
+ * Inlining by -O level: which calls each level's cost model replaces,
+ * that cycles stay calls, that programs still return the same value,
+ * and that the linker inlines across objects.
+ *
+ * Build and run: make test
+ */
+#include "eclc/ast.h"
+#include "eclc/codegen.h"
+#include "eclc/inliner.h"
+#include "eclc/link.h"
+#include "check.h"
+#include "emulate.h"
+
+// small is one instruction, wide (0x12345678) takes a movz and a movk
+static const char* const program =
+    "int main() { return outer(); }\n"
+    "int outer() { return inner(); }\n"
+    "int inner() { return small(); }\n"
+    "int small() { return 5; }\n"
+    "int wide() { return 305419896; }\n"
+    "int use_wide() { return wide(); }\n"
+    "int ping() { return pong(); }\n"
+    "int pong() { return ping(); }\n";
+
+typedef struct {
+    TokenStream* tokens;
+    Parser* parser;
+    ASTNode* ast;
+} Unit;
+
+static Unit parse(const char* source) {
+    Unit unit;
+    unit.tokens = tokenize(source);
+    unit.parser = parser_create(unit.tokens, "inline_test.c");
+    unit.ast = parser_parse(unit.parser);
+    CHECK(unit.ast != NULL);
+    return unit;
+}
+
+static void unit_free(Unit* unit) {
+    ast_free(unit->ast);
+    parser_destroy(unit->parser);
+    token_stream_free(unit->tokens);
+}
+
+static eclc_output_t* compile(const char* source, int level) {
+    Unit unit = parse(source);
+    CodegenOptions options = { NULL, NULL, level };
+    eclc_output_t* out = codegen_generate_with(unit.ast, &options);
+    unit_free(&unit);
+    return out;
+}
+
+// b and bl in the body of `name`
+static size_t branches_in(const eclc_output_t* out, const char* name) {
+    long index = eclc_lookup_symbol(out, name);
+    if (index < 0) return 0;
+    const fcef_symbol_t* sym = &out->symbols[index];
+    size_t branches = 0;
+    for (uint32_t k = sym->value; k + 4 <= sym->value + sym->size; k += 4) {
+        uint32_t top = emulate_load32(out->code + k) & 0x7C000000u;
+        if (top == 0x14000000u) branches++;
+    }
+    return branches;
+}
+
+static void test_levels(void) {
+    // -O1 collapses the chain to small; wide only fits the -O2 budget
+    static const size_t expected[4] = { 0, 3, 4, 4 };
+    for (int level = 0; level <= 3; level++) {
+        Unit unit = parse(program);
+        CHECK(inline_calls(unit.ast, level) == expected[level]);
+        unit_free(&unit);
+
+        eclc_output_t* out = compile(program, level);
+        Run main_run = emulate_symbol(out, "main");
+        Run wide_run = emulate_symbol(out, "use_wide");
+        CHECK(main_run.ok && main_run.w0 == 5);
+        CHECK(wide_run.ok && wide_run.w0 == 305419896);
+        CHECK(branches_in(out, "main") == (level == 0 ? 1u : 0u));
+        CHECK(branches_in(out, "use_wide") == (level < 2 ? 1u : 0u));
+        CHECK(branches_in(out, "ping") == 1 && branches_in(out, "pong") == 1);
+        eclc_free_output(out);
+    }
+}
+
+// main and helper live in different objects, so only the linker can
+// put helper's body into main
+static void test_across_objects(void) {
+    for (int level = 0; level <= 2; level++) {
+        LinkInput inputs[2] = {
+            { "main.c", compile("int main() { return helper(); }\n", level) },
+            { "helper.c", compile("int helper() { return 123; }\n", level) },
+        };
+        LinkOptions options = { NULL, 1, NULL, false, false, level };
+        LinkStats stats;
+        eclc_output_t* out = eclc_link(inputs, 2, &options, &stats);
+        CHECK(out != NULL);
+        if (out) {
+            Run run = emulate_symbol(out, "main");
+            CHECK(run.ok && run.w0 == 123);
+            CHECK(stats.inlined_calls == (level == 0 ? 0u : 1u));
+            CHECK(branches_in(out, "main") == (level == 0 ? 1u : 0u));
+        }
+        eclc_free_output(out);
+        eclc_free_output((eclc_output_t*)inputs[0].object);
+        eclc_free_output((eclc_output_t*)inputs[1].object);
+    }
+}
+
+int main(void) {
+    test_levels();
+    test_across_objects();
+    return check_result("inline_test");
+}
@@ -0,0 +1,93 @@
+/**
+ * Link-time passes: identical code folding merges functions with the
+ * same code and callees across objects, and --gc-sections drops what
+ * main can't reach, each with the savings LinkStats reports.
+ *
+ * Build and run: make test
+ */
+#include "eclc/ast.h"
+#include "eclc/codegen.h"
+#include "eclc/link.h"
+#include "check.h"
+#include <string.h>
+
+static const char* const sources[] = {
+    "int main() { return twin_a(); }\n"
+    "int twin_a() { return 7; }\n"
+    "int unused() { return 9; }\n",
+
+    "int twin_b() { return 7; }\n"
+    "int caller_b() { return twin_b(); }\n"
+    "int caller_a() { return twin_a(); }\n",
+};
+#define OBJECTS (sizeof(sources) / sizeof(sources[0]))
+
+static eclc_output_t* compile(const char* source) {
+    TokenStream* tokens = tokenize(source);
+    Parser* parser = parser_create(tokens, "link_test.c");
+    ASTNode* ast = parser_parse(parser);
+    CHECK(ast != NULL);
+    CodegenOptions options = { NULL, NULL, 0 };
+    eclc_output_t* out = codegen_generate_with(ast, &options);
+    ast_free(ast);
+    parser_destroy(parser);
+    token_stream_free(tokens);
+    return out;
+}
+
+static eclc_output_t* link_objects(LinkInput* inputs, bool icf, bool gc, LinkStats* stats) {
+    LinkOptions options = { NULL, 1, NULL, icf, gc, 0 };
+    eclc_output_t* out = eclc_link(inputs, OBJECTS, &options, stats);
+    CHECK(out != NULL);
+    return out;
+}
+
+static long address_of(const eclc_output_t* out, const char* name) {
+    long index = eclc_lookup_symbol(out, name);
+    return index < 0 ? -1 : (long)out->symbols[index].value;
+}
+
+int main(void) {
+    LinkInput inputs[OBJECTS];
+    for (size_t i = 0; i < OBJECTS; i++) {
+        inputs[i].name = "link_test.c";
+        inputs[i].object = compile(sources[i]);
+    }
+
+    LinkStats plain, icf, gc, both;
+    eclc_output_t* out = link_objects(inputs, false, false, &plain);
+    CHECK(plain.icf_functions == 0 && plain.gc_atoms == 0);
+    CHECK(plain.text_out == plain.text_in);
+    CHECK(address_of(out, "twin_a") != address_of(out, "twin_b"));
+    CHECK(address_of(out, "unused") >= 0);
+    eclc_free_output(out);
+
+    // twin_b folds into twin_a, then caller_a and caller_b into main,
+    // the first function with their code
+    out = link_objects(inputs, true, false, &icf);
+    CHECK(icf.icf_functions == 3);
+    CHECK(icf.text_out == icf.text_in - icf.icf_bytes && icf.icf_bytes > 0);
+    CHECK(address_of(out, "twin_a") == address_of(out, "twin_b"));
+    CHECK(address_of(out, "caller_a") == address_of(out, "main"));
+    CHECK(address_of(out, "caller_b") == address_of(out, "main"));
+    CHECK(address_of(out, "unused") != address_of(out, "twin_a"));
+    eclc_free_output(out);
+
+    // Only main and twin_a are reachable
+    out = link_objects(inputs, false, true, &gc);
+    CHECK(gc.gc_atoms == 4);
+    CHECK(gc.text_out == gc.text_in - gc.gc_bytes && gc.gc_bytes > 0);
+    CHECK(address_of(out, "main") >= 0 && address_of(out, "twin_a") >= 0);
+    CHECK(address_of(out, "unused") == -1 && address_of(out, "caller_b") == -1);
+    eclc_free_output(out);
+
+    out = link_objects(inputs, true, true, &both);
+    CHECK(both.text_out == gc.text_out);
+    CHECK(both.text_out + both.icf_bytes + both.gc_bytes == both.text_in);
+    eclc_free_output(out);
+
+    for (size_t i = 0; i < OBJECTS; i++) {
+        eclc_free_output((eclc_output_t*)inputs[i].object);
+    }
+    return check_result("link_test");
+}
@@ -0,0 +1,88 @@
+/**
+ * Build manifests: two folder builds writing different executables into
+ * one directory keep separate manifests and cached objects, so neither
+ * build's state or objects are touched by the other.
+ *
+ * Build and run: make test
+ */
+#include "eclc/manifest.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static char* join(const char* dir, const char* name) {
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char* path = xmalloc(len);
+    snprintf(path, len, "%s/%s", dir, name);
+    return path;
+}
+
+static bool exists(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+// What a build of one file writes: the object and the manifest naming it
+static char* record_build(const char* output, const char* input) {
+    Manifest* manifest = manifest_load(output, 1);
+    Manifest* next = manifest_create(manifest);
+    ManifestEntry entry = {0};
+    entry.name = xstrdup(input);
+    entry.object = manifest_object_name(input);
+    char* object = manifest_object_path(next, entry.object);
+    manifest_add(next, &entry);
+
+    CHECK(manifest_prepare_dirs(next));
+    FILE* file = fopen(object, "w");
+    CHECK(file != NULL);
+    if (file) fclose(file);
+    CHECK(manifest_save(next));
+    manifest_prune(manifest, next);
+    manifest_free(manifest);
+    manifest_free(next);
+    return object;
+}
+
+int main(void) {
+    char dir[] = "/tmp/eclc_manifest_XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    char* a = join(dir, "a.fcef");
+    char* b = join(dir, "b.fcef");
+
+    char* a_object = record_build(a, "a/main.c");
+    char* b_object = record_build(b, "b/main.c");
+    CHECK(strcmp(a_object, b_object) != 0);
+    CHECK(exists(a_object) && exists(b_object));
+
+    // Each output still finds its own entry and only that
+    Manifest* ma = manifest_load(a, 1);
+    Manifest* mb = manifest_load(b, 1);
+    CHECK(ma->count == 1 && manifest_find(ma, "a/main.c") && !manifest_find(ma, "b/main.c"));
+    CHECK(mb->count == 1 && manifest_find(mb, "b/main.c") && !manifest_find(mb, "a/main.c"));
+    CHECK(strcmp(ma->dir, mb->dir) != 0);
+
+    // Pruning a's state once its input is gone leaves b's object alone
+    Manifest* empty = manifest_create(ma);
+    manifest_prune(ma, empty);
+    CHECK(!exists(a_object));
+    CHECK(exists(b_object));
+    manifest_free(empty);
+    manifest_free(ma);
+    manifest_free(mb);
+
+    // Other flags start over
+    Manifest* other = manifest_load(b, 2);
+    CHECK(other->count == 0);
+    manifest_free(other);
+
+    char command[256];
+    snprintf(command, sizeof(command), "rm -rf '%s'", dir);
+    CHECK(system(command) == 0);
+    xfree(a_object);
+    xfree(b_object);
+    xfree(a);
+    xfree(b);
+    return check_result("manifest_test");
+}
@@ -0,0 +1,140 @@
+/**
+ * Peephole rewrites: each pattern against the words it should produce,
+ * shapes that must be left alone, pinned relocation sites and the map
+ * from input to output positions.
+ *
+ * Build and run: make test
+ */
+#include "eclc/peephole.h"
+#include "check.h"
+#include <string.h>
+
+#define MOVZ_W0_5       0x528000A0u     // mov w0, #5
+#define MOVZ_W0_0       0x52800000u     // mov w0, #0
+#define MOVK_W0_0_16    0x72A00000u     // movk w0, #0, lsl #16
+#define MOVK_W0_2_16    0x72A00040u     // movk w0, #2, lsl #16
+#define MOVK_W0_FFFF_16 0x72BFFFE0u     // movk w0, #0xffff, lsl #16
+#define MOVZ_W0_2_16    0x52A00040u     // mov w0, #0x20000
+#define MOVN_W0_FFFA    0x129FFF40u     // movn w0, #0xfffa (mov w0, #0xffff0005)
+#define MOV_X1_X1       0xAA0103E1u     // mov x1, x1
+#define MOV_X1_X2       0xAA0203E1u     // mov x1, x2
+#define MOV_X2_X1       0xAA0103E2u     // mov x2, x1
+#define ADD_X3_X3_0     0x91000063u     // add x3, x3, #0
+#define ADD_X3_X4_0     0x91000083u     // add x3, x4, #0
+#define STR_X0_SP_8     0xF90007E0u     // str x0, [sp, #8]
+#define LDR_X0_SP_8     0xF94007E0u     // ldr x0, [sp, #8]
+#define LDR_X0_SP_16    0xF9400BE0u     // ldr x0, [sp, #16]
+#define STR_W0_SP_8     0xB9000BE0u     // str w0, [sp, #8]
+#define LDR_W0_SP_8     0xB9400BE0u     // ldr w0, [sp, #8]
+#define B_NEXT          0x14000001u     // b .+4
+#define B_BACK          0x17FFFFFFu     // b .-4
+#define STP_FP_LR       0xA9BF7BFDu
+#define MOV_FP_SP       0x910003FDu
+#define LDP_FP_LR       0xA8C17BFDu
+#define RET             0xD65F03C0u
+
+// Run the pass on `in` and compare with `expect`
+static void check_rewrite(const uint32_t* in, size_t n, const uint32_t* expect, size_t m,
+                          const uint8_t* pinned, const char* what) {
+    uint32_t words[16];
+    uint32_t where[16];
+    memcpy(words, in, n * sizeof(uint32_t));
+    size_t kept = peephole_optimize(words, n, pinned, where);
+    bool same = kept == m && memcmp(words, expect, m * sizeof(uint32_t)) == 0;
+    if (!same) {
+        fprintf(stderr, "%s: got", what);
+        for (size_t k = 0; k < kept; k++) fprintf(stderr, " %08x", words[k]);
+        fprintf(stderr, "\n");
+    }
+    CHECK(same);
+}
+
+#define REWRITE(what, in, expect)                                                   \
+    check_rewrite(in, sizeof(in) / sizeof(in[0]), expect,                           \
+                  sizeof(expect) / sizeof(expect[0]), NULL, what)
+
+static void test_patterns(void) {
+    static const uint32_t movk_zero[] = { MOVZ_W0_5, MOVK_W0_0_16, RET };
+    static const uint32_t movk_zero_out[] = { MOVZ_W0_5, RET };
+    REWRITE("movk-zero", movk_zero, movk_zero_out);
+
+    static const uint32_t movz_high[] = { MOVZ_W0_0, MOVK_W0_2_16, RET };
+    static const uint32_t movz_high_out[] = { MOVZ_W0_2_16, RET };
+    REWRITE("movz-high", movz_high, movz_high_out);
+
+    static const uint32_t movn[] = { MOVZ_W0_5, MOVK_W0_FFFF_16, RET };
+    static const uint32_t movn_out[] = { MOVN_W0_FFFA, RET };
+    REWRITE("movn", movn, movn_out);
+
+    static const uint32_t mov_self[] = { MOV_X1_X1, ADD_X3_X3_0, ADD_X3_X4_0, RET };
+    static const uint32_t mov_self_out[] = { ADD_X3_X4_0, RET };
+    REWRITE("mov-self and add-zero", mov_self, mov_self_out);
+
+    static const uint32_t mov_back[] = { MOV_X1_X2, MOV_X2_X1, RET };
+    static const uint32_t mov_back_out[] = { MOV_X1_X2, RET };
+    REWRITE("mov-back", mov_back, mov_back_out);
+
+    static const uint32_t reload[] = { STR_X0_SP_8, LDR_X0_SP_8, RET };
+    static const uint32_t reload_out[] = { STR_X0_SP_8, RET };
+    REWRITE("store-reload", reload, reload_out);
+
+    static const uint32_t branch[] = { B_NEXT, RET };
+    static const uint32_t branch_out[] = { RET };
+    REWRITE("branch-next", branch, branch_out);
+
+    static const uint32_t frame[] = { STP_FP_LR, MOV_FP_SP, LDP_FP_LR, RET };
+    static const uint32_t frame_out[] = { RET };
+    REWRITE("empty-frame", frame, frame_out);
+
+    // A rewrite exposes the next one: the movk goes, then the frame around it
+    static const uint32_t cascade[] = { STP_FP_LR, MOV_FP_SP, MOVZ_W0_5, MOVK_W0_0_16,
+                                        MOV_X1_X1, LDP_FP_LR, RET };
+    static const uint32_t cascade_out[] = { STP_FP_LR, MOV_FP_SP, MOVZ_W0_5, LDP_FP_LR, RET };
+    REWRITE("cascade", cascade, cascade_out);
+}
+
+static void test_left_alone(void) {
+    // ldr w0 clears the top half of x0, so the reload isn't redundant
+    static const uint32_t w_reload[] = { STR_W0_SP_8, LDR_W0_SP_8, RET };
+    REWRITE("32-bit store-reload", w_reload, w_reload);
+
+    static const uint32_t other_slot[] = { STR_X0_SP_8, LDR_X0_SP_16, RET };
+    REWRITE("reload of another slot", other_slot, other_slot);
+
+    static const uint32_t loop[] = { B_BACK, RET };
+    REWRITE("backward branch", loop, loop);
+
+    static const uint32_t moves[] = { MOV_X1_X2, MOV_X1_X2, RET };
+    REWRITE("repeated move", moves, moves);
+}
+
+static void test_pinned(void) {
+    // A relocated branch to the next word is still a call site
+    static const uint32_t in[] = { B_NEXT, MOVZ_W0_5, MOVK_W0_0_16, RET };
+    static const uint32_t out[] = { B_NEXT, MOVZ_W0_5, RET };
+    static const uint8_t pinned[] = { 1, 0, 0, 0 };
+    check_rewrite(in, 4, out, 3, pinned, "pinned");
+
+    static const uint8_t pinned_movk[] = { 0, 0, 1, 0 };
+    static const uint32_t out_movk[] = { MOVZ_W0_5, MOVK_W0_0_16, RET };
+    check_rewrite(in, 4, out_movk, 3, pinned_movk, "pinned movk");
+}
+
+static void test_where(void) {
+    uint32_t words[] = { STR_X0_SP_8, LDR_X0_SP_8, B_NEXT, MOVZ_W0_5, RET };
+    uint32_t where[5];
+    memset(where, 0xFF, sizeof(where));
+    size_t kept = peephole_optimize(words, 5, NULL, where);
+    CHECK(kept == 3);
+    CHECK(where[0] == 0);
+    CHECK(where[3] == 1);
+    CHECK(where[4] == 2);
+}
+
+int main(void) {
+    test_patterns();
+    test_left_alone();
+    test_pinned();
+    test_where();
+    return check_result("peephole_test");
+}
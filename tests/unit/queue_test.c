@@ -0,0 +1,181 @@
+/**
+ * Bounded queue: capacity and FIFO order on one thread, every item
+ * delivered exactly once with several producers and consumers on a ring
+ * small enough to fill, and close semantics (pending items drain, then
+ * pops fail; consumers asleep on an empty queue wake up).
+ *
+ * Build and run: make test
+ */
+#include "eclc/queue.h"
+#include "check.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define PRODUCERS 4
+#define CONSUMERS 4
+#define ITEMS 50000             // Per producer
+#define DEPTH 8
+
+// Items are 1 + producer * ITEMS + index, so none is NULL
+static void* make_item(size_t producer, size_t index) {
+    return (void*)(uintptr_t)(1 + producer * ITEMS + index);
+}
+
+static size_t item_number(void* item) {
+    return (size_t)(uintptr_t)item - 1;
+}
+
+static void test_single_thread(void) {
+    BoundedQueue* queue = queue_create(3);      // Rounded up to 4
+    void* item = NULL;
+    CHECK(!queue_try_pop(queue, &item));
+    for (size_t i = 0; i < 4; i++) {
+        CHECK(queue_try_push(queue, make_item(0, i)));
+    }
+    CHECK(!queue_try_push(queue, make_item(0, 4)));
+    for (size_t i = 0; i < 4; i++) {
+        CHECK(queue_try_pop(queue, &item) && item == make_item(0, i));
+    }
+    CHECK(!queue_try_pop(queue, &item));
+
+    // Wrap around the ring a few times
+    for (size_t i = 0; i < 10; i++) {
+        queue_push(queue, make_item(0, i));
+        CHECK(queue_pop(queue, &item) && item == make_item(0, i));
+    }
+    queue_destroy(queue);
+}
+
+typedef struct {
+    BoundedQueue* queue;
+    size_t producer;
+    unsigned char* seen;        // Per item, atomic
+    size_t popped;
+    bool ordered;
+    bool batch;
+} Worker;
+
+static void* produce(void* arg) {
+    Worker* worker = arg;
+    for (size_t i = 0; i < ITEMS; i++) {
+        queue_push(worker->queue, make_item(worker->producer, i));
+    }
+    return NULL;
+}
+
+// One consumer sees each producer's items in the order they were pushed
+static void consume_one(Worker* worker, void* item, size_t* last) {
+    size_t number = item_number(item);
+    size_t producer = number / ITEMS;
+    if (producer >= PRODUCERS) {
+        worker->ordered = false;
+        return;
+    }
+    if (last[producer] != SIZE_MAX && number <= last[producer]) {
+        worker->ordered = false;
+    }
+    last[producer] = number;
+    __atomic_add_fetch(&worker->seen[number], 1, __ATOMIC_RELAXED);
+    worker->popped++;
+}
+
+static void* consume(void* arg) {
+    Worker* worker = arg;
+    size_t last[PRODUCERS];
+    for (size_t i = 0; i < PRODUCERS; i++) last[i] = SIZE_MAX;
+    if (worker->batch) {
+        void* items[DEPTH];
+        size_t count;
+        while ((count = queue_pop_many(worker->queue, items, DEPTH)) > 0) {
+            for (size_t i = 0; i < count; i++) consume_one(worker, items[i], last);
+        }
+    } else {
+        void* item;
+        while (queue_pop(worker->queue, &item)) consume_one(worker, item, last);
+    }
+    return NULL;
+}
+
+static void test_many_threads(void) {
+    BoundedQueue* queue = queue_create(DEPTH);
+    unsigned char* seen = xcalloc(PRODUCERS * ITEMS, 1);
+    pthread_t producers[PRODUCERS], consumers[CONSUMERS];
+    Worker producer_args[PRODUCERS], consumer_args[CONSUMERS];
+
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        consumer_args[i] = (Worker){ .queue = queue, .seen = seen, .ordered = true,
+                                     .batch = i % 2 == 1 };
+        pthread_create(&consumers[i], NULL, consume, &consumer_args[i]);
+    }
+    for (size_t i = 0; i < PRODUCERS; i++) {
+        producer_args[i] = (Worker){ .queue = queue, .producer = i };
+        pthread_create(&producers[i], NULL, produce, &producer_args[i]);
+    }
+    for (size_t i = 0; i < PRODUCERS; i++) pthread_join(producers[i], NULL);
+    queue_close(queue);
+
+    size_t popped = 0;
+    bool ordered = true;
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+        popped += consumer_args[i].popped;
+        ordered = ordered && consumer_args[i].ordered;
+    }
+    CHECK(popped == PRODUCERS * ITEMS);
+    CHECK(ordered);
+    size_t once = 0;
+    for (size_t i = 0; i < PRODUCERS * ITEMS; i++) once += seen[i] == 1;
+    CHECK(once == PRODUCERS * ITEMS);
+
+    xfree(seen);
+    queue_destroy(queue);
+}
+
+static void test_close(void) {
+    // Items pushed before the close are still delivered, then pops fail
+    BoundedQueue* queue = queue_create(4);
+    void* item = NULL;
+    void* items[4];
+    queue_push(queue, make_item(0, 0));
+    queue_push(queue, make_item(0, 1));
+    queue_push(queue, make_item(0, 2));
+    queue_close(queue);
+    CHECK(queue_pop(queue, &item) && item == make_item(0, 0));
+    CHECK(queue_pop_many(queue, items, 4) == 2);
+    CHECK(items[0] == make_item(0, 1) && items[1] == make_item(0, 2));
+    CHECK(!queue_pop(queue, &item));
+    CHECK(queue_pop_many(queue, items, 4) == 0);
+    queue_destroy(queue);
+
+    // Consumers asleep on an empty queue take what arrives, then wake on close
+    queue = queue_create(4);
+    unsigned char seen[2 * ITEMS] = { 0 };
+    pthread_t consumers[CONSUMERS];
+    Worker args[CONSUMERS];
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        args[i] = (Worker){ .queue = queue, .seen = seen, .ordered = true,
+                            .batch = i % 2 == 1 };
+        pthread_create(&consumers[i], NULL, consume, &args[i]);
+    }
+    usleep(20000);
+    queue_push(queue, make_item(1, 0));
+    queue_push(queue, make_item(1, 1));
+    usleep(20000);
+    queue_close(queue);
+    size_t popped = 0;
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+        popped += args[i].popped;
+    }
+    CHECK(popped == 2);
+    CHECK(seen[ITEMS] == 1 && seen[ITEMS + 1] == 1);
+    queue_destroy(queue);
+}
+
+int main(void) {
+    test_single_thread();
+    test_many_threads();
+    test_close();
+    return check_result("queue_test");
+}
@@ -0,0 +1,144 @@
+/**
+ * Project scanner on a temporary tree: recursion, .eclcignore rules
+ * (directory-only, anchored in a subfolder, negation), hidden entries,
+ * and symlinks followed to files but never into directories. Each
+ * directory is read once.
+ *
+ * Build and run: make test
+ */
+#include "eclc/scan.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    char* names[32];
+    size_t count;
+    const char* root;
+    bool paths_ok;
+} Found;
+
+static void found_file(void* ctx, const char* name, const char* path) {
+    Found* found = ctx;
+    // `path` is the root, a slash and `name`
+    size_t root_len = strlen(found->root);
+    if (strncmp(path, found->root, root_len) != 0 || path[root_len] != '/' ||
+        strcmp(path + root_len + 1, name) != 0) {
+        found->paths_ok = false;
+    }
+    if (found->count < 32) {
+        found->names[found->count++] = xstrdup(name);
+    }
+}
+
+static bool was_found(const Found* found, const char* name) {
+    for (size_t i = 0; i < found->count; i++) {
+        if (strcmp(found->names[i], name) == 0) return true;
+    }
+    return false;
+}
+
+static void put(const char* root, const char* name, const char* text) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    FILE* file = fopen(path, "w");
+    CHECK(file != NULL);
+    if (file) {
+        fputs(text, file);
+        fclose(file);
+    }
+}
+
+static void make_dir(const char* root, const char* name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    CHECK(mkdir(path, 0777) == 0);
+}
+
+static void make_link(const char* root, const char* target, const char* name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    CHECK(symlink(target, path) == 0);
+}
+
+static void build_tree(const char* root) {
+    put(root, ".eclcignore", "# generated code\nbuild/\n*_test.c\n!keep_test.c\n");
+    put(root, "main.c", "");
+    put(root, "util_test.c", "");
+    put(root, "keep_test.c", "");
+    put(root, "notes.txt", "");
+    put(root, ".hidden.c", "");
+    make_dir(root, "build");
+    put(root, "build/gen.c", "");
+    make_dir(root, ".git");
+    put(root, ".git/x.c", "");
+
+    make_dir(root, "sub");
+    put(root, "sub/.eclcignore", "/gen\n");
+    put(root, "sub/a.cpp", "");
+    put(root, "sub/build", "");             // A file: build/ only matches folders
+    make_dir(root, "sub/gen");
+    put(root, "sub/gen/x.c", "");
+    make_dir(root, "sub/deep");
+    make_dir(root, "sub/deep/gen");          // Not next to sub/.eclcignore
+    put(root, "sub/deep/gen/y.c", "");
+
+    make_link(root, "main.c", "link_file.c");
+    make_link(root, "missing.c", "dangling.c");
+    make_link(root, "sub", "link_dir");
+    make_link(root, ".", "loop");
+}
+
+int main(void) {
+    char root[] = "/tmp/eclc_scan_XXXXXX";
+    CHECK(mkdtemp(root) != NULL);
+    build_tree(root);
+
+    Found found = { .root = root, .paths_ok = true };
+    ScanStats stats;
+    CHECK(scan_project(root, found_file, &found, &stats));
+
+    static const char* const expected[] = {
+        "main.c", "keep_test.c", "link_file.c", "sub/a.cpp", "sub/deep/gen/y.c",
+    };
+    size_t expected_count = sizeof(expected) / sizeof(expected[0]);
+    for (size_t i = 0; i < expected_count; i++) {
+        if (!was_found(&found, expected[i])) {
+            fprintf(stderr, "missing %s\n", expected[i]);
+        }
+        CHECK(was_found(&found, expected[i]));
+    }
+    for (size_t i = 0; i < found.count; i++) {
+        bool listed = false;
+        for (size_t j = 0; j < expected_count; j++) {
+            listed = listed || strcmp(found.names[i], expected[j]) == 0;
+        }
+        if (!listed) {
+            fprintf(stderr, "unexpected %s\n", found.names[i]);
+        }
+        CHECK(listed);
+    }
+    CHECK(found.count == expected_count);
+    CHECK(found.paths_ok);
+    CHECK(stats.files == expected_count);
+    CHECK(stats.dirs == 4);                 // root, sub, sub/deep, sub/deep/gen
+    CHECK(stats.ignored == 3);              // util_test.c, build/, sub/gen
+
+    // A trailing slash on the root changes nothing
+    char slashed[sizeof(root) + 1];
+    snprintf(slashed, sizeof(slashed), "%s/", root);
+    Found again = { .root = root, .paths_ok = true };
+    CHECK(scan_project(slashed, found_file, &again, NULL));
+    CHECK(again.count == expected_count && again.paths_ok);
+
+    CHECK(!scan_project("/nonexistent/eclc_scan", found_file, &again, NULL));
+
+    for (size_t i = 0; i < found.count; i++) xfree(found.names[i]);
+    for (size_t i = 0; i < again.count; i++) xfree(again.names[i]);
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf '%s'", root);
+    CHECK(system(command) == 0);
+    return check_result("scan_test");
+}
@@ -0,0 +1,59 @@
+/**
+ * Tail calls and frame elision: a chain of calls returns the same value
+ * at -O0 and -O1, but at -O1 it runs without a stack frame or a bl.
+ *
+ * Build and run: make test
+ */
+#include "eclc/ast.h"
+#include "eclc/codegen.h"
+#include "check.h"
+#include "emulate.h"
+#include <string.h>
+
+#define DEPTH 1000
+
+// fn_0 calls fn_1 ... calls fn_{DEPTH-1}, which returns a constant
+static char* make_chain(void) {
+    size_t capacity = (size_t)DEPTH * 48 + 64;
+    char* source = malloc(capacity);
+    size_t len = 0;
+    for (int f = 0; f + 1 < DEPTH; f++) {
+        len += snprintf(source + len, capacity - len, "int fn_%d() { return fn_%d(); }\n", f, f + 1);
+    }
+    snprintf(source + len, capacity - len, "int fn_%d() { return 305419896; }\n", DEPTH - 1);
+    return source;
+}
+
+static Run run_chain(ASTNode* ast, int level) {
+    CodegenOptions options = { NULL, NULL, level };
+    eclc_output_t* out = codegen_generate_with(ast, &options);
+    Run run = emulate_symbol(out, "fn_0");
+    eclc_free_output(out);
+    return run;
+}
+
+int main(void) {
+    char* source = make_chain();
+    TokenStream* tokens = tokenize(source);
+    Parser* parser = parser_create(tokens, "tailcall_test.c");
+    ASTNode* ast = parser_parse(parser);
+    CHECK(ast != NULL);
+
+    // At -O0 every function but the leaf at the end sets up a frame
+    Run o0 = run_chain(ast, 0);
+    CHECK(o0.ok && o0.w0 == 305419896);
+    CHECK(o0.calls == DEPTH - 1);
+    CHECK(o0.max_stack == (DEPTH - 1) * 16);
+
+    Run o1 = run_chain(ast, 1);
+    CHECK(o1.ok && o1.w0 == o0.w0);
+    CHECK(o1.calls == 0);
+    CHECK(o1.max_stack == 0);
+    CHECK(o1.executed < o0.executed);
+
+    ast_free(ast);
+    parser_destroy(parser);
+    token_stream_free(tokens);
+    free(source);
+    return check_result("tailcall_test");
+}